@@ -24,15 +24,26 @@ public:
 	using difference_type = ptrdiff_t;
 	using size_type = std::size_t;
 
+private:
+	/// @brief Only accept iterators to `T` or to a less qualified `T` (e.g. `int*` for
+	/// `ArrayView<const int>`). This keeps overloads taking views of different element types
+	/// unambiguous
+	template<class It>
+	static constexpr bool IsCompatibleIterator =
+		std::is_convertible_v<std::remove_reference_t<std::iter_reference_t<It>>(*)[], T(*)[]>;
+
+public:
 	ArrayView() noexcept = default;
 
-	template<class It>
+	template<std::contiguous_iterator It>
+		requires (IsCompatibleIterator<It>)
 	ArrayView(It begin, size_type size) noexcept:
 		m_data(std::to_address(begin)),
 		m_size(size)
 	{ }
 
-	template<class It>
+	template<std::contiguous_iterator It>
+		requires (IsCompatibleIterator<It>)
 	ArrayView(It begin, It end):
 		m_data(std::to_address(begin)),
 		m_size(static_cast<size_type>(end - begin))
@@ -47,8 +58,11 @@ public:
 	{ }
 
 	//// Conversion from ArrayView of non-const elements to ArrayView of const elements
-	ArrayView(const ArrayView<value_type>& other) noexcept
-			requires (std::is_const_v<T>): // See C++ 20 Concepts
+	/// @note This has to be a template. Otherwise, for `ArrayView<value_type>` it would be
+	/// a constrained copy constructor that suppresses the implicit one
+	template<class U>
+		requires (std::is_const_v<T> && std::is_same_v<U, value_type>) // See C++ 20 Concepts
+	ArrayView(const ArrayView<U>& other) noexcept:
 		m_data(other.data()),
 		m_size(other.size())
 	{ }
@@ -0,0 +1,152 @@
+#include "benchmark/benchmark.hpp"
+
+#include <cassert>
+#include <cmath>
+#include <cstdlib>
+
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+
+namespace {
+
+/// @brief Write `text` as a JSON string literal
+void writeJsonString(std::ostream& output, const std::string& text) {
+	output << '"';
+	for (char c : text) {
+		if (c == '"' || c == '\\') {
+			output << '\\' << c;
+		}
+		else if (static_cast<unsigned char>(c) < 0x20) {
+			output << "\\u" << std::hex << std::setw(4) << std::setfill('0')
+				<< static_cast<int>(c) << std::dec << std::setfill(' ');
+		}
+		else {
+			output << c;
+		}
+	}
+	output << '"';
+}
+
+void printUsage(const char* program, std::string_view extraUsage) {
+	std::cerr << "Usage: " << program << " [OPTION VALUE]...\n" << extraUsage
+		<< "  --runs N           Timed runs per benchmark (default 7)\n"
+		"  --warmup N         Untimed runs per benchmark (default 1)\n"
+		"  --min-time MS      Shortest duration of a run in milliseconds, reached by repeating"
+		" the benchmark (default 5)\n"
+		"  --json PATH        Write the results as JSON to PATH, '-' for stdout\n";
+}
+
+} // namespace
+
+double BenchmarkResult::percentile(double p) const {
+	assert(!runSeconds.empty() && p >= 0 && p <= 100);
+	const double rank = std::ceil(p / 100 * static_cast<double>(runSeconds.size()));
+	const size_t index = static_cast<size_t>(std::max(rank, 1.0)) - 1;
+	return runSeconds[index];
+}
+
+const BenchmarkResult& BenchmarkSuite::addResult(BenchmarkResult result) {
+	std::sort(result.runSeconds.begin(), result.runSeconds.end());
+	m_results.push_back(std::move(result));
+	return m_results.back();
+}
+
+void BenchmarkSuite::writeSummary(std::ostream& output, const BenchmarkResult& result) {
+	for (const auto& [name, value] : result.labels) {
+		output << name << '=' << value << ' ';
+	}
+
+	const double toNanosecondsPerItem = 1e9 / static_cast<double>(result.itemsPerIteration);
+	output << "| " << result.median() * toNanosecondsPerItem << " ns/item median ("
+		<< result.percentile(10) * toNanosecondsPerItem << " p10, "
+		<< result.percentile(90) * toNanosecondsPerItem << " p90), "
+		<< result.median() * 1e6 << " us/iteration, " << result.iterationsPerRun
+		<< " iterations/run\n";
+}
+
+void BenchmarkSuite::writeJson(std::ostream& output) const {
+	output << "{\n";
+	output << "  \"warmupRuns\": " << m_options.warmupRuns << ",\n";
+	output << "  \"runs\": " << m_options.runs << ",\n";
+	output << "  \"minRunSeconds\": " << m_options.minRunSeconds << ",\n";
+	output << "  \"results\": [";
+
+	bool isFirstResult = true;
+	for (const BenchmarkResult& result : m_results) {
+		output << (isFirstResult ? "\n" : ",\n") << "    {";
+		isFirstResult = false;
+
+		for (const auto& [name, value] : result.labels) {
+			writeJsonString(output, name);
+			output << ": ";
+			writeJsonString(output, value);
+			output << ", ";
+		}
+
+		const double toNanoseconds = 1e9;
+		output << "\"itemsPerIteration\": " << result.itemsPerIteration
+			<< ", \"iterationsPerRun\": " << result.iterationsPerRun
+			<< ", \"minNs\": " << result.runSeconds.front() * toNanoseconds
+			<< ", \"medianNs\": " << result.median() * toNanoseconds
+			<< ", \"p90Ns\": " << result.percentile(90) * toNanoseconds
+			<< ", \"p99Ns\": " << result.percentile(99) * toNanoseconds
+			<< ", \"maxNs\": " << result.runSeconds.back() * toNanoseconds
+			<< ", \"medianNsPerItem\": "
+			<< result.median() * toNanoseconds / static_cast<double>(result.itemsPerIteration)
+			<< "}";
+	}
+	output << "\n  ]\n}\n";
+}
+
+std::ostream& BenchmarkCommandLine::log() const {
+	return jsonPath == "-" ? std::cerr : std::cout;
+}
+
+bool BenchmarkCommandLine::writeJson(const BenchmarkSuite& suite) const {
+	if (jsonPath == "-") {
+		suite.writeJson(std::cout);
+	}
+	else if (!jsonPath.empty()) {
+		std::ofstream output(jsonPath);
+		suite.writeJson(output);
+		if (!output) {
+			std::cerr << "Failed to write '" << jsonPath << "'\n";
+			return false;
+		}
+	}
+	return true;
+}
+
+std::optional<BenchmarkCommandLine> parseBenchmarkCommandLine(int argc, char* argv[],
+	std::string_view extraUsage, const BenchmarkOptionParser& parseOption)
+{
+	BenchmarkCommandLine result;
+	for (int i = 1; i < argc; ++i) {
+		const std::string_view argument = argv[i];
+		if (i + 1 >= argc) {
+			printUsage(argv[0], extraUsage);
+			return std::nullopt;
+		}
+		const char* value = argv[++i];
+		if (argument == "--runs") {
+			result.options.runs = std::max(
+				static_cast<unsigned>(std::strtoul(value, nullptr, 10)), 1u);
+		}
+		else if (argument == "--warmup") {
+			result.options.warmupRuns = static_cast<unsigned>(std::strtoul(value, nullptr, 10));
+		}
+		else if (argument == "--min-time") {
+			result.options.minRunSeconds = std::strtod(value, nullptr) / 1e3;
+		}
+		else if (argument == "--json") {
+			result.jsonPath = value;
+		}
+		else if (!parseOption || !parseOption(argument, value)) {
+			printUsage(argv[0], extraUsage);
+			return std::nullopt;
+		}
+	}
+	return result;
+}
@@ -0,0 +1,182 @@
+#ifndef BENCHMARK_HPP_INCLUDED
+#define BENCHMARK_HPP_INCLUDED
+
+#include <cstddef>
+
+#include <algorithm>
+#include <chrono>
+#include <functional>
+#include <optional>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+/// @brief Keep the compiler from optimizing away the computation of `value`
+template<typename T>
+inline void doNotOptimize(const T& value) {
+#if defined(__GNUC__) || defined(__clang__)
+	asm volatile("" : : "g"(&value) : "memory");
+#else
+	static_cast<void>(*static_cast<const volatile char*>(static_cast<const void*>(&value)));
+#endif
+}
+
+struct BenchmarkOptions {
+	/// @brief Untimed runs before the measurements, to warm up the caches and the branch predictors
+	unsigned warmupRuns = 1;
+	/// @brief Timed runs. The statistics are computed over these
+	unsigned runs = 7;
+	/// @brief The shortest duration of a run in seconds. A run calls the benchmark as many times
+	/// as it takes to last that long, so that the cheap ones aren't lost in the cost of reading
+	/// the clock
+	double minRunSeconds = 0.005;
+};
+
+/// @brief The measurements of a single benchmark
+struct BenchmarkResult {
+	/// @brief Name-value pairs that identify the benchmark, e.g. `{"operation", "get"}`
+	std::vector<std::pair<std::string, std::string>> labels;
+	/// @brief The number of operations done by a single iteration, for the per-item figures
+	std::size_t itemsPerIteration = 1;
+	/// @brief The number of iterations in every run, picked to make a run last at least
+	/// `BenchmarkOptions::minRunSeconds`
+	std::size_t iterationsPerRun = 1;
+	/// @brief The durations of an iteration in seconds, one per timed run: the duration of the
+	/// run divided by the iterations in it. Sorted in ascending order
+	std::vector<double> runSeconds;
+
+	/// @brief The nearest-rank percentile of the iteration durations in seconds
+	/// @pre `0 <= p <= 100` and there was at least one run
+	double percentile(double p) const;
+	double median() const {
+		return percentile(50);
+	}
+};
+
+/// @brief A minimal timing harness: runs every benchmark a few times, keeps all the timings and
+/// reports the median and the percentiles rather than the mean, which is skewed by the outliers
+class BenchmarkSuite {
+public:
+	using Labels = std::vector<std::pair<std::string, std::string>>;
+
+	explicit BenchmarkSuite(BenchmarkOptions options = {}): m_options(options) { }
+
+	/// @brief Time `body()`, an iteration that does `itemsPerIteration` operations. Before every
+	/// call of `body()`, warmup or timed, `setup()` is called untimed, e.g. to reset the state
+	/// that `body()` modifies
+	/// @note With a setup, every iteration is timed on its own, so the cost of reading the clock,
+	/// a few dozen nanoseconds, adds to each. Prefer the overload without one for cheap bodies
+	template<typename Setup, typename Body>
+	const BenchmarkResult& run(Labels labels, std::size_t itemsPerIteration, Setup setup,
+		Body body)
+	{
+		for (unsigned i = 0; i < m_options.warmupRuns; ++i) {
+			runIterations(setup, body, 1);
+		}
+
+		// Grow the number of iterations until a run lasts long enough. These runs warm up too
+		std::size_t iterations = 1;
+		for (;;) {
+			const double seconds = runIterations(setup, body, iterations);
+			if (seconds >= m_options.minRunSeconds) {
+				break;
+			}
+			// Aim a bit past the minimum, but grow at most tenfold at a time, since the first
+			// runs are the least reliable
+			const double scale = seconds > 0 ? m_options.minRunSeconds / seconds * 1.2 : 10;
+			iterations = std::max(iterations + 1, static_cast<std::size_t>(
+				static_cast<double>(iterations) * std::min(scale, 10.0)));
+		}
+
+		BenchmarkResult result{std::move(labels), itemsPerIteration, iterations, {}};
+		result.runSeconds.reserve(m_options.runs);
+		for (unsigned i = 0; i < m_options.runs; ++i) {
+			result.runSeconds.push_back(runIterations(setup, body, iterations)
+				/ static_cast<double>(iterations));
+		}
+		return addResult(std::move(result));
+	}
+
+	/// @brief Time `body()` that doesn't need any setup. A run reads the clock only at its start
+	/// and its end
+	template<typename Body>
+	const BenchmarkResult& run(Labels labels, std::size_t itemsPerIteration, Body body) {
+		return run(std::move(labels), itemsPerIteration, NoSetup{}, std::move(body));
+	}
+
+	const std::vector<BenchmarkResult>& results() const {
+		return m_results;
+	}
+
+	/// @brief Write a single line with the labels and the per-item timings of `result`
+	static void writeSummary(std::ostream& output, const BenchmarkResult& result);
+
+	/// @brief Write the options and all the results with their statistics as a JSON document
+	void writeJson(std::ostream& output) const;
+
+private:
+	using Clock = std::chrono::steady_clock;
+	using Seconds = std::chrono::duration<double>;
+
+	struct NoSetup {
+		void operator()() const { }
+	};
+
+	/// @brief Call `body()` `iterations` times and return the time it took in seconds, that of
+	/// `setup()` excluded
+	template<typename Setup, typename Body>
+	static double runIterations(Setup& setup, Body& body, std::size_t iterations) {
+		if constexpr (std::is_same_v<Setup, NoSetup>) {
+			const auto start = Clock::now();
+			for (std::size_t i = 0; i < iterations; ++i) {
+				body();
+			}
+			return Seconds(Clock::now() - start).count();
+		}
+		else {
+			double seconds = 0;
+			for (std::size_t i = 0; i < iterations; ++i) {
+				setup();
+				const auto start = Clock::now();
+				body();
+				seconds += Seconds(Clock::now() - start).count();
+			}
+			return seconds;
+		}
+	}
+
+	const BenchmarkResult& addResult(BenchmarkResult result);
+
+	BenchmarkOptions m_options;
+	std::vector<BenchmarkResult> m_results;
+};
+
+/// @brief The command line shared by the benchmark programs
+struct BenchmarkCommandLine {
+	BenchmarkOptions options;
+	/// @brief Where to write the results as JSON: nowhere if empty, to stdout if `-`
+	std::string jsonPath;
+
+	/// @brief The stream for the progress and the summaries, which keeps stdout clean for the
+	/// JSON document if it goes there
+	std::ostream& log() const;
+
+	/// @brief Write the results of `suite` to `jsonPath`, if any. Returns `false` and reports
+	/// the error to stderr if the file can't be written
+	bool writeJson(const BenchmarkSuite& suite) const;
+};
+
+/// @brief Called with the name and the value of an option that `parseBenchmarkCommandLine()`
+/// doesn't know. Returns `false` if the program doesn't know it either
+using BenchmarkOptionParser = std::function<bool(std::string_view name, const char* value)>;
+
+/// @brief Parse `--runs N`, `--warmup N`, `--min-time MS` and `--json PATH`, and pass the other
+/// options to `parseOption`. Writes the usage with `extraUsage` for the program's own options to
+/// stderr and returns nothing on an error
+std::optional<BenchmarkCommandLine> parseBenchmarkCommandLine(int argc, char* argv[],
+	std::string_view extraUsage = {}, const BenchmarkOptionParser& parseOption = {});
+
+#endif
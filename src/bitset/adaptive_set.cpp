@@ -0,0 +1,189 @@
+#include "bitset/adaptive_set.hpp"
+
+#include <algorithm>
+
+AdaptiveSet::AdaptiveSet(BitSet set):
+	m_set(std::move(set))
+{
+	const BitSet& dense = std::get<BitSet>(m_set);
+	m_count = dense.count();
+	m_maxElement = dense.bytes().empty() ? 0 : dense.bytes().size() * 8 - 1;
+	rebalance();
+}
+
+AdaptiveSet::AdaptiveSet(SparseSet set):
+	m_set(std::move(set))
+{
+	const SparseSet& sparse = std::get<SparseSet>(m_set);
+	m_count = sparse.count();
+	sparse.forEach([this](uint64_t element) {
+		m_maxElement = std::max(m_maxElement, element);
+	});
+	rebalance();
+}
+
+void AdaptiveSet::rebalance() {
+	const size_t sparseBytes = m_count * sparseBytesPerElement;
+	if (BitSet* dense = std::get_if<BitSet>(&m_set)) {
+		if (dense->bytes().size() > switchRatio * sparseBytes) {
+			m_set = SparseSet::fromBitSet(*dense);
+		}
+	}
+	else {
+		const size_t denseBytes = static_cast<size_t>(m_maxElement / 8 + 1);
+		if (sparseBytes > switchRatio * denseBytes) {
+			m_set = std::get<SparseSet>(m_set).toBitSet();
+		}
+	}
+}
+
+void AdaptiveSet::set(uint64_t pos, bool value) {
+	if (get(pos) == value) {
+		return;
+	}
+
+	// Rebalance before changing the set: an element far past the end of a `BitSet` may make it
+	// worth converting before the `BitSet` grows to hold it
+	if (value) {
+		++m_count;
+		m_maxElement = std::max(m_maxElement, pos);
+		if (const BitSet* dense = std::get_if<BitSet>(&m_set)) {
+			const size_t grownBytes = std::max(dense->bytes().size(),
+				static_cast<size_t>(pos / 8 + 1));
+			if (grownBytes > switchRatio * m_count * sparseBytesPerElement) {
+				m_set = SparseSet::fromBitSet(*dense);
+			}
+		}
+	}
+	else {
+		--m_count;
+	}
+
+	std::visit([pos, value](auto& set) { set.set(pos, value); }, m_set);
+	rebalance();
+}
+
+void AdaptiveSet::clear() {
+	m_set = SparseSet();
+	m_count = 0;
+	m_maxElement = 0;
+}
+
+size_t AdaptiveSet::sizeBytes() const {
+	if (const BitSet* dense = std::get_if<BitSet>(&m_set)) {
+		return dense->bytes().size();
+	}
+	return std::get<SparseSet>(m_set).sizeBytes();
+}
+
+BitSet AdaptiveSet::toBitSet() const {
+	if (const BitSet* dense = std::get_if<BitSet>(&m_set)) {
+		return *dense;
+	}
+	return std::get<SparseSet>(m_set).toBitSet();
+}
+
+SparseSet AdaptiveSet::toSparseSet() const {
+	if (const BitSet* dense = std::get_if<BitSet>(&m_set)) {
+		return SparseSet::fromBitSet(*dense);
+	}
+	return std::get<SparseSet>(m_set);
+}
+
+bool operator==(const AdaptiveSet& a, const AdaptiveSet& b) {
+	if (a.m_count != b.m_count) {
+		return false;
+	}
+	if (a.m_set.index() == b.m_set.index()) {
+		return a.m_set == b.m_set;
+	}
+
+	// Equal counts, so the sets are equal if the sparse one is a subset of the dense one
+	const SparseSet& sparse = std::get<SparseSet>(a.isDense() ? b.m_set : a.m_set);
+	const BitSet& dense = std::get<BitSet>(a.isDense() ? a.m_set : b.m_set);
+	bool isSubset = true;
+	sparse.forEach([&isSubset, &dense](uint64_t element) {
+		isSubset = isSubset && dense.get(element);
+	});
+	return isSubset;
+}
+
+AdaptiveSet operator|(const AdaptiveSet& a, const AdaptiveSet& b) {
+	if (!a.isDense() && !b.isDense()) {
+		return AdaptiveSet(std::get<SparseSet>(a.m_set) | std::get<SparseSet>(b.m_set));
+	}
+	if (a.isDense() && b.isDense()) {
+		return AdaptiveSet(std::get<BitSet>(a.m_set) | std::get<BitSet>(b.m_set));
+	}
+
+	const AdaptiveSet& sparse = a.isDense() ? b : a;
+	const BitSet& dense = std::get<BitSet>((a.isDense() ? a : b).m_set);
+	if (sparse.m_maxElement / 8 >= dense.bytes().size()) {
+		// The sparse elements reach past the end of the dense set, don't let it grow to hold them
+		return AdaptiveSet(SparseSet::fromBitSet(dense) | std::get<SparseSet>(sparse.m_set));
+	}
+
+	BitSet result = dense;
+	std::get<SparseSet>(sparse.m_set).forEach([&result](uint64_t element) {
+		result.set(element);
+	});
+	return AdaptiveSet(std::move(result));
+}
+
+AdaptiveSet operator&(const AdaptiveSet& a, const AdaptiveSet& b) {
+	if (!a.isDense() && !b.isDense()) {
+		return AdaptiveSet(std::get<SparseSet>(a.m_set) & std::get<SparseSet>(b.m_set));
+	}
+	if (a.isDense() && b.isDense()) {
+		return AdaptiveSet(std::get<BitSet>(a.m_set) & std::get<BitSet>(b.m_set));
+	}
+
+	// The intersection is no larger than the sparse operand
+	const BitSet& dense = std::get<BitSet>((a.isDense() ? a : b).m_set);
+	SparseSet result;
+	std::get<SparseSet>((a.isDense() ? b : a).m_set).forEach([&result, &dense](uint64_t element) {
+		if (dense.get(element)) {
+			result.set(element);
+		}
+	});
+	return AdaptiveSet(std::move(result));
+}
+
+AdaptiveSet operator^(const AdaptiveSet& a, const AdaptiveSet& b) {
+	if (!a.isDense() && !b.isDense()) {
+		return AdaptiveSet(std::get<SparseSet>(a.m_set) ^ std::get<SparseSet>(b.m_set));
+	}
+	if (a.isDense() && b.isDense()) {
+		return AdaptiveSet(std::get<BitSet>(a.m_set) ^ std::get<BitSet>(b.m_set));
+	}
+
+	const AdaptiveSet& sparse = a.isDense() ? b : a;
+	const BitSet& dense = std::get<BitSet>((a.isDense() ? a : b).m_set);
+	if (sparse.m_maxElement / 8 >= dense.bytes().size()) {
+		// The sparse elements reach past the end of the dense set, don't let it grow to hold them
+		return AdaptiveSet(SparseSet::fromBitSet(dense) ^ std::get<SparseSet>(sparse.m_set));
+	}
+
+	BitSet result = dense;
+	std::get<SparseSet>(sparse.m_set).forEach([&result](uint64_t element) {
+		result.set(element, !result.get(element));
+	});
+	return AdaptiveSet(std::move(result));
+}
+
+std::ostream& operator<<(std::ostream& output, const AdaptiveSet& set) {
+	std::visit([&output](const auto& representation) { output << representation; }, set.m_set);
+	return output;
+}
+
+std::istream& operator>>(std::istream& input, AdaptiveSet& set) {
+	set.clear();
+	uint64_t value{};
+	while (input >> value) {
+		if (input.peek() == '\n') {
+			input.setstate(std::ios::eofbit);
+		}
+		set.set(value);
+	}
+	return input;
+}
@@ -0,0 +1,121 @@
+#ifndef ADAPTIVE_SET_HPP_INCLUDED
+#define ADAPTIVE_SET_HPP_INCLUDED
+
+#include <cstddef>
+#include <cstdint>
+
+#include <istream>
+#include <ostream>
+#include <variant>
+
+#include "bitset/bitset.hpp"
+#include "bitset/sparse_set.hpp"
+
+/// @brief A set of unique unsigned numbers that stores its elements either in a `BitSet` or in
+/// a `SparseSet`, whichever takes less memory, and converts between them as the set changes.
+///
+/// A `BitSet` costs 1/8 of a byte per possible element, a `SparseSet` about 16 bytes per actual
+/// element, so the break-even density is around 1/128. The set converts only when the other
+/// representation is at least `switchRatio` times smaller, so that a set near the threshold
+/// doesn't convert back and forth on every change
+class AdaptiveSet {
+public:
+	/// @brief Estimated memory of a `SparseSet` per element, with the average load of the table
+	static constexpr size_t sparseBytesPerElement = 16;
+	static constexpr size_t switchRatio = 2;
+
+	/// @brief A wrapper that acts like a reference to a specific element, as `BitSet::BitReference`
+	class BitReference {
+	public:
+		BitReference(AdaptiveSet& set, uint64_t pos): m_set(&set), m_pos(pos) { }
+
+		explicit operator bool() const {
+			return m_set->get(m_pos);
+		}
+
+		BitReference& operator=(bool value) {
+			m_set->set(m_pos, value);
+			return *this;
+		}
+
+	private:
+		AdaptiveSet* m_set;
+		uint64_t m_pos;
+	};
+
+	/// @brief An empty set starts sparse
+	AdaptiveSet() = default;
+	explicit AdaptiveSet(BitSet set);
+	explicit AdaptiveSet(SparseSet set);
+
+	bool get(uint64_t pos) const {
+		return std::visit([pos](const auto& set) { return set.get(pos); }, m_set);
+	}
+
+	/// @brief Add or remove a given element. May convert the set to the other representation
+	void set(uint64_t pos, bool value = true);
+
+	bool operator[](uint64_t pos) const {
+		return get(pos);
+	}
+	BitReference operator[](uint64_t pos) {
+		return {*this, pos};
+	}
+
+	/// @brief Remove all elements. The set becomes sparse, freeing the storage of a `BitSet`
+	void clear();
+
+	size_t count() const {
+		return m_count;
+	}
+
+	bool isDense() const {
+		return std::holds_alternative<BitSet>(m_set);
+	}
+
+	/// @brief The memory taken by the current representation in bytes
+	size_t sizeBytes() const;
+
+	/// @brief Get the set as a `BitSet`, converting it if it is sparse
+	BitSet toBitSet() const;
+	/// @brief Get the set as a `SparseSet`, converting it if it is dense
+	SparseSet toSparseSet() const;
+
+	friend bool operator==(const AdaptiveSet& a, const AdaptiveSet& b);
+	friend bool operator!=(const AdaptiveSet& a, const AdaptiveSet& b) {
+		return !(a == b);
+	}
+
+	/// @brief Construct a union of two sets. Mixed operands are combined without converting
+	/// the sparse one, e.g. by setting its elements in a copy of the dense one
+	friend AdaptiveSet operator|(const AdaptiveSet& a, const AdaptiveSet& b);
+	/// @brief Construct an intersection of two sets
+	friend AdaptiveSet operator&(const AdaptiveSet& a, const AdaptiveSet& b);
+	/// @brief Construct a symmetric difference of two sets
+	friend AdaptiveSet operator^(const AdaptiveSet& a, const AdaptiveSet& b);
+
+	friend void swap(AdaptiveSet& a, AdaptiveSet& b) noexcept {
+		using std::swap;
+
+		swap(a.m_set, b.m_set);
+		swap(a.m_count, b.m_count);
+		swap(a.m_maxElement, b.m_maxElement);
+	}
+
+	/// @brief Write to the stream `output` in the format of `{value1, value2, ..., valueN}`
+	friend std::ostream& operator<<(std::ostream& output, const AdaptiveSet& set);
+	/// @brief Read from the stream `input` in the format of `value1 value2 ... valueN`
+	friend std::istream& operator>>(std::istream& input, AdaptiveSet& set);
+
+private:
+	/// @brief Convert to the other representation if it is `switchRatio` times smaller
+	void rebalance();
+
+	std::variant<SparseSet, BitSet> m_set;
+	size_t m_count = 0;
+	/// @brief An upper bound of the largest element, for the size of the `BitSet` the sparse
+	/// representation would turn into. Not lowered when elements are removed
+	uint64_t m_maxElement = 0;
+};
+
+#endif
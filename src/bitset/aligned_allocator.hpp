@@ -0,0 +1,44 @@
+#ifndef ALIGNED_ALLOCATOR_HPP_INCLUDED
+#define ALIGNED_ALLOCATOR_HPP_INCLUDED
+
+#include <cstddef>
+
+#include <new>
+
+/// @brief Minimal allocator for standard containers that aligns the storage to `Alignment` bytes,
+/// e.g. to the cache line size
+template<typename T, std::size_t Alignment>
+class AlignedAllocator {
+public:
+	static_assert(Alignment >= alignof(T) && (Alignment & (Alignment - 1)) == 0,
+		"Alignment must be a power of two that is not less than the alignment of T");
+
+	using value_type = T;
+
+	/// @brief Needed by `std::allocator_traits` since the allocator has a non-type template
+	/// parameter
+	template<typename U>
+	struct rebind {
+		using other = AlignedAllocator<U, Alignment>;
+	};
+
+	AlignedAllocator() noexcept = default;
+
+	template<typename U>
+	AlignedAllocator(const AlignedAllocator<U, Alignment>&) noexcept { }
+
+	T* allocate(std::size_t count) {
+		return static_cast<T*>(::operator new(count * sizeof(T), std::align_val_t{Alignment}));
+	}
+
+	void deallocate(T* ptr, std::size_t) noexcept {
+		::operator delete(ptr, std::align_val_t{Alignment});
+	}
+
+	/// All instances are interchangeable
+	friend bool operator==(const AlignedAllocator&, const AlignedAllocator&) noexcept {
+		return true;
+	}
+};
+
+#endif
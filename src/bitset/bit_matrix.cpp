@@ -0,0 +1,177 @@
+#include "bitset/bit_matrix.hpp"
+
+#include <cassert>
+
+#include <algorithm>
+#include <barrier>
+
+#include "parallel/parallel.hpp"
+
+namespace {
+
+/// @brief Transpose a 64x64 bit tile in place. Bit `c` of `tile[r]` becomes bit `r` of `tile[c]`
+///
+/// Swaps the off-diagonal 32x32 quadrants, then the off-diagonal 16x16 blocks of each quadrant
+/// and so on down to single bits (see "Hacker's Delight", section 7-3)
+void transposeTile(uint64_t tile[64]) {
+	uint64_t mask = 0x00000000ffffffff;
+	for (unsigned width = 32; width != 0; width >>= 1, mask ^= mask << width) {
+		for (unsigned k = 0; k < 64; k = ((k | width) + 1) & ~width) {
+			const uint64_t diff = ((tile[k] >> width) ^ tile[k | width]) & mask;
+			tile[k] ^= diff << width;
+			tile[k | width] ^= diff;
+		}
+	}
+}
+
+} // namespace
+
+BitMatrix::BitMatrix(size_t rows, size_t columns):
+	m_rows(rows),
+	m_columns(columns),
+	m_rowWords((columns + lineWords * wordBits - 1) / (lineWords * wordBits) * lineWords),
+	m_data(rows * m_rowWords)
+{ }
+
+void BitMatrix::orRow(size_t dest, size_t source) {
+	uint64_t* destData = rowData(dest);
+	const uint64_t* sourceData = rowData(source);
+	for (size_t i = 0; i < m_rowWords; ++i) {
+		destData[i] |= sourceData[i];
+	}
+}
+
+void BitMatrix::andRow(size_t dest, size_t source) {
+	uint64_t* destData = rowData(dest);
+	const uint64_t* sourceData = rowData(source);
+	for (size_t i = 0; i < m_rowWords; ++i) {
+		destData[i] &= sourceData[i];
+	}
+}
+
+BitSet BitMatrix::row(size_t index) const {
+	std::vector<uint8_t> bytes((m_columns + 7) / 8);
+	const uint64_t* data = rowData(index);
+	for (size_t i = 0; i < bytes.size(); ++i) {
+		bytes[i] = static_cast<uint8_t>(data[i / 8] >> (8 * (i % 8)));
+	}
+	return BitSet::fromBytes({bytes.begin(), bytes.end()});
+}
+
+void BitMatrix::setRow(size_t index, const BitSet& bitset) {
+	uint64_t* data = rowData(index);
+	std::fill(data, data + m_rowWords, 0);
+
+	const ArrayView<const uint8_t> bytes = bitset.bytes();
+	const size_t byteCount = std::min(bytes.size(), (m_columns + 7) / 8);
+	for (size_t i = 0; i < byteCount; ++i) {
+		data[i / 8] |= uint64_t{bytes[i]} << (8 * (i % 8));
+	}
+
+	// Keep the padding bits zero, the rest of the class relies on it
+	if (m_columns % wordBits != 0 && byteCount != 0) {
+		data[m_columns / wordBits] &= (uint64_t{1} << (m_columns % wordBits)) - 1;
+	}
+}
+
+void BitMatrix::transitiveClosure(unsigned threadCount) {
+	assert(m_rows == m_columns);
+
+	const unsigned threads = resolveThreadCount(threadCount, m_rows);
+	std::barrier sync(static_cast<std::ptrdiff_t>(threads));
+
+	const auto worker = [&](unsigned threadIndex) {
+		const ThreadRange rows(m_rows, threadIndex, threads);
+
+		for (size_t blockBegin = 0; blockBegin < m_rows; blockBegin += wordBits) {
+			const size_t blockEnd = std::min(blockBegin + wordBits, m_rows);
+			const size_t blockWord = blockBegin / wordBits;
+
+			// Phase 1: plain Warshall steps over the pivots of the block, restricted to the rows
+			// of the block itself. Afterwards these rows account for all of the block's pivots
+			if (threadIndex == 0) {
+				for (size_t k = blockBegin; k < blockEnd; ++k) {
+					for (size_t i = blockBegin; i < blockEnd; ++i) {
+						if (i != k && get(i, k)) {
+							orRow(i, k);
+						}
+					}
+				}
+			}
+			sync.arrive_and_wait();
+
+			// Phase 2: every other row applies the pivots in order. The pivot rows are read-only
+			// during this phase. Using them after all of the block's steps instead of just the
+			// preceding ones only adds paths that exist anyway, so the result is the same
+			for (size_t i = rows.begin; i < rows.end; ++i) {
+				if (i >= blockBegin && i < blockEnd) {
+					continue;
+				}
+				// The bits of the block may change as the row grows, so re-read them every time
+				const uint64_t* pivotWord = rowData(i) + blockWord;
+				if (*pivotWord == 0) {
+					continue;
+				}
+				for (size_t k = blockBegin; k < blockEnd; ++k) {
+					if ((*pivotWord >> (k - blockBegin)) & 1) {
+						orRow(i, k);
+					}
+				}
+			}
+			sync.arrive_and_wait();
+		}
+	};
+
+	runOnThreads(threads, worker);
+}
+
+BitMatrix BitMatrix::transposed(unsigned threadCount) const {
+	BitMatrix result(m_columns, m_rows);
+
+	// Each thread owns a range of tile columns, i.e. a range of rows of the result
+	const size_t tileColumns = (m_columns + wordBits - 1) / wordBits;
+	const size_t tileRows = (m_rows + wordBits - 1) / wordBits;
+	const unsigned threads = resolveThreadCount(threadCount, tileColumns);
+
+	const auto worker = [&](unsigned threadIndex) {
+		const ThreadRange tiles(tileColumns, threadIndex, threads);
+
+		uint64_t tile[64];
+		for (size_t tileColumn = tiles.begin; tileColumn < tiles.end; ++tileColumn) {
+			for (size_t tileRow = 0; tileRow < tileRows; ++tileRow) {
+				for (size_t r = 0; r < 64; ++r) {
+					const size_t row = tileRow * wordBits + r;
+					tile[r] = row < m_rows ? rowData(row)[tileColumn] : 0;
+				}
+
+				transposeTile(tile);
+
+				for (size_t c = 0; c < 64; ++c) {
+					const size_t column = tileColumn * wordBits + c;
+					if (column >= m_columns) {
+						break;
+					}
+					result.rowData(column)[tileRow] = tile[c];
+				}
+			}
+		}
+	};
+
+	runOnThreads(threads, worker);
+	return result;
+}
+
+bool operator==(const BitMatrix& a, const BitMatrix& b) {
+	// The padding bits are always zero, so the buffers can be compared directly
+	return a.m_rows == b.m_rows && a.m_columns == b.m_columns && a.m_data == b.m_data;
+}
+
+std::ostream& operator<<(std::ostream& output, const BitMatrix& matrix) {
+	for (size_t i = 0; i < matrix.m_rows; ++i) {
+		for (size_t j = 0; j < matrix.m_columns; ++j) {
+			output << (matrix.get(i, j) ? '1' : '0');
+		}
+		output << '\n';
+	}
+	return output;
+}
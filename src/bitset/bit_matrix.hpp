@@ -0,0 +1,97 @@
+#ifndef BIT_MATRIX_HPP_INCLUDED
+#define BIT_MATRIX_HPP_INCLUDED
+
+#include <cstddef>
+#include <cstdint>
+
+#include <ostream>
+#include <vector>
+
+#include "bitset/aligned_allocator.hpp"
+#include "bitset/bitset.hpp"
+
+/// @brief A dense matrix of bits, e.g. the adjacency matrix of a directed graph
+///
+/// All of the rows live in a single contiguous buffer. Every row starts at a 64-byte boundary
+/// and is padded to a whole number of cache lines, so that row operations work on full 64-bit
+/// words and two threads writing different rows never share a cache line.
+class BitMatrix {
+public:
+	/// @brief Number of bits in a storage word
+	static constexpr size_t wordBits = 64;
+	/// @brief Number of words in a cache line. Rows are padded to a multiple of this value
+	static constexpr size_t lineWords = 8;
+
+	/// @brief Create an empty 0x0 matrix
+	BitMatrix() = default;
+
+	/// @brief Create a matrix of the given shape with all the bits set to zero
+	BitMatrix(size_t rows, size_t columns);
+
+	/// All of the special member functions are implicitly generated
+
+	size_t rowCount() const { return m_rows; }
+	size_t columnCount() const { return m_columns; }
+
+	bool get(size_t row, size_t column) const {
+		return (rowData(row)[column / wordBits] >> (column % wordBits)) & 1;
+	}
+
+	void set(size_t row, size_t column, bool value = true) {
+		uint64_t& word = rowData(row)[column / wordBits];
+		const uint64_t mask = uint64_t{1} << (column % wordBits);
+		word = (word & ~mask) | (value ? mask : 0);
+	}
+
+	/// @brief `row(dest) |= row(source)`
+	void orRow(size_t dest, size_t source);
+	/// @brief `row(dest) &= row(source)`
+	void andRow(size_t dest, size_t source);
+
+	/// @brief Copy a row into a `BitSet`
+	BitSet row(size_t index) const;
+	/// @brief Replace a row with the contents of `bitset`. Elements past `columnCount()`
+	/// are ignored
+	void setRow(size_t index, const BitSet& bitset);
+
+	/// @brief Replace the matrix with its transitive closure: afterwards `get(i, j)` is true iff
+	/// there is a path of one or more edges from `i` to `j`
+	/// @pre The matrix is square
+	/// @param threadCount The number of threads to use. 0 means `hardware_concurrency()`
+	///
+	/// Warshall's algorithm with word-parallel row updates. The pivots are processed in blocks of
+	/// 64 rows. The pivot rows of a block are closed first, then every other row is updated with
+	/// the whole block while it stays in cache. Rows are split between threads.
+	void transitiveClosure(unsigned threadCount = 0);
+
+	/// @brief Get the transposed matrix
+	/// @param threadCount The number of threads to use. 0 means `hardware_concurrency()`
+	///
+	/// The matrix is processed as 64x64 bit tiles, each transposed in registers in 6 rounds of
+	/// swapping progressively smaller sub-blocks (32x32, 16x16, ..., 1x1).
+	BitMatrix transposed(unsigned threadCount = 0) const;
+
+	friend bool operator==(const BitMatrix& a, const BitMatrix& b);
+	friend bool operator!=(const BitMatrix& a, const BitMatrix& b) {
+		return !(a == b);
+	}
+
+	/// @brief Write the matrix as rows of `0` and `1` characters
+	friend std::ostream& operator<<(std::ostream& output, const BitMatrix& matrix);
+
+private:
+	uint64_t* rowData(size_t row) {
+		return m_data.data() + row * m_rowWords;
+	}
+
+	const uint64_t* rowData(size_t row) const {
+		return m_data.data() + row * m_rowWords;
+	}
+
+	size_t m_rows = 0;
+	size_t m_columns = 0;
+	size_t m_rowWords = 0;
+	std::vector<uint64_t, AlignedAllocator<uint64_t, 64>> m_data;
+};
+
+#endif
@@ -0,0 +1,116 @@
+#include <chrono>
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include "bitset/bit_matrix.hpp"
+
+/// @brief Reference transitive closure: a depth-first search from every node
+static BitMatrix naiveClosure(const BitMatrix& graph) {
+	const size_t n = graph.rowCount();
+	BitMatrix result(n, n);
+	std::vector<size_t> stack;
+	for (size_t start = 0; start < n; ++start) {
+		stack.assign(1, start);
+		while (!stack.empty()) {
+			const size_t node = stack.back();
+			stack.pop_back();
+			for (size_t next = 0; next < n; ++next) {
+				if (graph.get(node, next) && !result.get(start, next)) {
+					result.set(start, next);
+					stack.push_back(next);
+				}
+			}
+		}
+	}
+	return result;
+}
+
+static BitMatrix randomGraph(size_t nodeCount, size_t edgeCount, unsigned seed) {
+	std::mt19937 random(seed);
+	std::uniform_int_distribution<size_t> node(0, nodeCount - 1);
+	BitMatrix graph(nodeCount, nodeCount);
+	for (size_t i = 0; i < edgeCount; ++i) {
+		graph.set(node(random), node(random));
+	}
+	return graph;
+}
+
+int main() {
+	std::cout << std::boolalpha;
+
+	{
+		std::cout << "Testing a small dependency graph:\n";
+		// 0 -> 1 -> 2 -> 3, 4 -> 0, 5 -> 5
+		BitMatrix graph(6, 6);
+		graph.set(0, 1);
+		graph.set(1, 2);
+		graph.set(2, 3);
+		graph.set(4, 0);
+		graph.set(5, 5);
+		std::cout << "Adjacency matrix:\n" << graph;
+
+		BitMatrix closure = graph;
+		closure.transitiveClosure();
+		std::cout << "Transitive closure:\n" << closure;
+		std::cout << "Transposed closure:\n" << closure.transposed();
+		std::cout << "Nodes reachable from 4: " << closure.row(4) << '\n';
+	}
+
+	{
+		std::cout << "\nTesting row operations:\n";
+		BitSet a;
+		a.set(1);
+		a.set(3);
+		a.set(100);
+		BitSet b;
+		b.set(3);
+		b.set(70);
+		BitMatrix matrix(2, 80);
+		matrix.setRow(0, a);
+		matrix.setRow(1, b);
+		std::cout << "row(0) -> " << matrix.row(0) << " (100 is past the last column)\n";
+		matrix.orRow(0, 1);
+		std::cout << "row(0) | row(1) -> " << matrix.row(0) << '\n';
+		matrix.andRow(0, 1);
+		std::cout << "(row(0) | row(1)) & row(1) -> " << matrix.row(0) << '\n';
+	}
+
+	{
+		std::cout << "\nTesting against the reference implementation:\n";
+		const BitMatrix graph = randomGraph(700, 900, 42);
+		const BitMatrix expected = naiveClosure(graph);
+		for (unsigned threads : {1u, 4u}) {
+			BitMatrix closure = graph;
+			closure.transitiveClosure(threads);
+			std::cout << "Closure with " << threads << " thread(s) matches -> "
+				<< (closure == expected) << '\n';
+		}
+
+		const BitMatrix transposed = graph.transposed(3);
+		bool isTransposeCorrect = transposed.rowCount() == graph.columnCount();
+		for (size_t i = 0; i < graph.rowCount(); ++i) {
+			for (size_t j = 0; j < graph.columnCount(); ++j) {
+				isTransposeCorrect = isTransposeCorrect && transposed.get(j, i) == graph.get(i, j);
+			}
+		}
+		std::cout << "Transpose matches -> " << isTransposeCorrect << '\n';
+		std::cout << "Double transpose is identity -> " << (transposed.transposed() == graph) << '\n';
+	}
+
+	{
+		constexpr size_t nodeCount = 8192;
+		std::cout << "\nTiming a " << nodeCount << "-node graph:\n";
+		BitMatrix closure = randomGraph(nodeCount, nodeCount, 7);
+
+		const auto start = std::chrono::steady_clock::now();
+		closure.transitiveClosure();
+		const auto middle = std::chrono::steady_clock::now();
+		const BitMatrix transposed = closure.transposed();
+		const auto end = std::chrono::steady_clock::now();
+
+		using Milliseconds = std::chrono::duration<double, std::milli>;
+		std::cout << "Transitive closure: " << Milliseconds(middle - start).count() << " ms\n";
+		std::cout << "Transpose: " << Milliseconds(end - middle).count() << " ms\n";
+	}
+}
@@ -1,10 +1,227 @@
 #include "bitset/bitset.hpp"
 
+#include <cassert>
 #include <cstring>
 
+#include <algorithm>
+#include <array>
+#include <bit>
 #include <iomanip>
 
+#if (defined(__GNUC__) || defined(__clang__)) && defined(__x86_64__) && defined(__linux__)
+#include <immintrin.h>
+
+/// @brief The hot loops of `count()` and `toIndices()` are compiled for the newer instruction
+/// sets as well, and the version for the processor is picked when the program is loaded
+#define BITSET_ISA_VERSIONS 1
+#endif
+
+namespace {
+
+/// @brief Positions of the set bits of a byte
+struct BytePositions {
+	uint8_t count;
+	uint8_t positions[8];
+};
+
+/// @brief Lookup table of the set bit positions for every possible byte value, built at compile
+/// time. Unused positions are padded with zeros, so that all 8 of them can always be copied
+constexpr std::array<BytePositions, 256> makeBytePositionsTable() {
+	std::array<BytePositions, 256> table{};
+	for (unsigned byte = 0; byte < 256; ++byte) {
+		BytePositions& entry = table[byte];
+		for (uint8_t bit = 0; bit < 8; ++bit) {
+			if (byte & (1u << bit)) {
+				entry.positions[entry.count++] = bit;
+			}
+		}
+	}
+	return table;
+}
+
+constexpr std::array<BytePositions, 256> bytePositionsTable = makeBytePositionsTable();
+
+/// @brief The number of entries past the last index that the decoders may write
+constexpr size_t decodeSlack = 16;
+
+/// @brief Write the indices of the set bits of `bytes` to `out`, every bit numbered from `base`.
+/// Returns the end of the written indices
+template<typename T>
+T* decodeBytesScalar(const uint8_t* bytes, size_t size, size_t base, T* out) {
+	// No branches on the individual bytes: zero bytes just don't advance the output
+	for (size_t i = 0; i < size; ++i) {
+		const BytePositions& entry = bytePositionsTable[bytes[i]];
+		const T byteBase = static_cast<T>(base + i * 8);
+		for (size_t j = 0; j < 8; ++j) {
+			out[j] = static_cast<T>(byteBase + entry.positions[j]);
+		}
+		out += entry.count;
+	}
+	return out;
+}
+
+/// @brief Read the 8-byte word of `bytes` at `offset`, zero-padded past the end
+uint64_t loadWord(ArrayView<const uint8_t> bytes, size_t offset) {
+	uint64_t word = 0;
+	std::memcpy(&word, &bytes[offset], std::min<size_t>(8, bytes.size() - offset));
+	return word;
+}
+
+#ifdef BITSET_ISA_VERSIONS
+
+/// @brief The baseline versions: the table lookup one entry at a time
+__attribute__((target("default")))
+uint32_t* decodeBytes(const uint8_t* bytes, size_t size, size_t base, uint32_t* out) {
+	return decodeBytesScalar(bytes, size, base, out);
+}
+
+__attribute__((target("default")))
+uint64_t* decodeBytes(const uint8_t* bytes, size_t size, size_t base, uint64_t* out) {
+	return decodeBytesScalar(bytes, size, base, out);
+}
+
+/// @brief The scalar table lookup, with the 8 positions of a byte widened and offset at once
+__attribute__((target("avx2")))
+uint32_t* decodeBytes(const uint8_t* bytes, size_t size, size_t base, uint32_t* out) {
+	for (size_t i = 0; i < size; ++i) {
+		const BytePositions& entry = bytePositionsTable[bytes[i]];
+		const __m256i positions = _mm256_cvtepu8_epi32(_mm_loadl_epi64(
+			reinterpret_cast<const __m128i*>(entry.positions)));
+		const __m256i byteBase = _mm256_set1_epi32(static_cast<int>(base + i * 8));
+		_mm256_storeu_si256(reinterpret_cast<__m256i*>(out),
+			_mm256_add_epi32(positions, byteBase));
+		out += entry.count;
+	}
+	return out;
+}
+
+__attribute__((target("avx2")))
+uint64_t* decodeBytes(const uint8_t* bytes, size_t size, size_t base, uint64_t* out) {
+	for (size_t i = 0; i < size; ++i) {
+		const BytePositions& entry = bytePositionsTable[bytes[i]];
+		const __m128i packed = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(entry.positions));
+		const __m256i byteBase = _mm256_set1_epi64x(static_cast<long long>(base + i * 8));
+		_mm256_storeu_si256(reinterpret_cast<__m256i*>(out),
+			_mm256_add_epi64(_mm256_cvtepu8_epi64(packed), byteBase));
+		_mm256_storeu_si256(reinterpret_cast<__m256i*>(out + 4),
+			_mm256_add_epi64(_mm256_cvtepu8_epi64(_mm_srli_si128(packed, 4)), byteBase));
+		out += entry.count;
+	}
+	return out;
+}
+
+/// @brief No table: every 16 bits select the lanes of a vector of consecutive indices, which are
+/// packed to the front with a compress. The 4 stores of a word only depend on its popcounts,
+/// which come from the table: `popcnt` is not a part of the baseline of the AVX-512 version
+__attribute__((target("avx512f")))
+uint32_t* decodeBytes(const uint8_t* bytes, size_t size, size_t base, uint32_t* out) {
+	// The indices of the bits of every 16-bit part of a word from the start of the word
+	__m512i partLanes[4];
+	for (int part = 0; part < 4; ++part) {
+		partLanes[part] = _mm512_add_epi32(_mm512_set1_epi32(part * 16),
+			_mm512_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15));
+	}
+	for (size_t offset = 0; offset < size; offset += 8) {
+		uint64_t word = 0;
+		std::memcpy(&word, bytes + offset, std::min<size_t>(8, size - offset));
+		const __m512i wordBase = _mm512_set1_epi32(static_cast<int>(base + offset * 8));
+		for (int part = 0; part < 4; ++part) {
+			const uint16_t mask = static_cast<uint16_t>(word >> (part * 16));
+			const __m512i indices = _mm512_add_epi32(wordBase, partLanes[part]);
+			_mm512_storeu_si512(out, _mm512_maskz_compress_epi32(mask, indices));
+			out += bytePositionsTable[mask & 0xff].count + bytePositionsTable[mask >> 8].count;
+		}
+	}
+	return out;
+}
+
+__attribute__((target("avx512f")))
+uint64_t* decodeBytes(const uint8_t* bytes, size_t size, size_t base, uint64_t* out) {
+	const __m512i lanes = _mm512_setr_epi64(0, 1, 2, 3, 4, 5, 6, 7);
+	for (size_t offset = 0; offset < size; offset += 8) {
+		uint64_t word = 0;
+		std::memcpy(&word, bytes + offset, std::min<size_t>(8, size - offset));
+		const __m512i wordBase = _mm512_add_epi64(lanes,
+			_mm512_set1_epi64(static_cast<long long>(base + offset * 8)));
+		for (int part = 0; part < 8; ++part) {
+			const uint8_t mask = static_cast<uint8_t>(word >> (part * 8));
+			const __m512i indices = _mm512_add_epi64(wordBase, _mm512_set1_epi64(part * 8));
+			_mm512_storeu_si512(out, _mm512_maskz_compress_epi64(mask, indices));
+			out += bytePositionsTable[mask].count;
+		}
+	}
+	return out;
+}
+
+#else
+
+template<typename T>
+T* decodeBytes(const uint8_t* bytes, size_t size, size_t base, T* out) {
+	return decodeBytesScalar(bytes, size, base, out);
+}
+
+#endif
+
+template<typename T>
+void toIndicesImpl(ArrayView<const uint8_t> bytes, size_t count, std::vector<T>& output) {
+	// Every non-zero byte writes past its own indices, so reserve some slack at the end
+	output.resize(count + decodeSlack);
+	T* out = output.data();
+
+	size_t offset = 0;
+	while (offset < bytes.size()) {
+		// Skip 8 zero bytes at a time. Sparse sets spend most of the time here
+		if (loadWord(bytes, offset) == 0) {
+			offset += 8;
+			continue;
+		}
+		// Decode the whole run of non-zero words at once, with a single dispatch
+		size_t end = offset + 8;
+		while (end < bytes.size() && loadWord(bytes, end) != 0) {
+			end += 8;
+		}
+		end = std::min(end, bytes.size());
+		out = decodeBytes(&bytes[offset], end - offset, offset * 8, out);
+		offset = end;
+	}
+
+	output.resize(count);
+}
+
+/// @brief Number of change tracking blocks covering `byteCount` bytes
+size_t trackedBlockCount(size_t byteCount) {
+	return (byteCount + BitSet::trackedBlockSize - 1) / BitSet::trackedBlockSize;
+}
+
+/// @brief Write `value` as an unsigned LEB128 varint
+void writeVarint(std::ostream& output, uint64_t value) {
+	do {
+		const uint8_t byte = static_cast<uint8_t>((value & 0x7f) | (value > 0x7f ? 0x80 : 0));
+		output.put(static_cast<char>(byte));
+		value >>= 7;
+	} while (value != 0);
+}
+
+/// @brief Read an unsigned LEB128 varint. Returns `false` on a truncated or overlong varint
+bool readVarint(std::istream& input, uint64_t& value) {
+	value = 0;
+	for (int shift = 0; shift <= 63; shift += 7) {
+		const int byte = input.get();
+		if (byte == std::istream::traits_type::eof()) {
+			return false;
+		}
+		value |= uint64_t(byte & 0x7f) << shift;
+		if ((byte & 0x80) == 0) {
+			return true;
+		}
+	}
+	return false;
+}
+
+} // namespace
+
 BitSet::BitSet(const BitSet& other):
+	m_data(nullptr),
 	m_size(other.m_size)
 {
 	if (other.m_size != 0) {
@@ -17,33 +234,162 @@ BitSet::~BitSet() {
 	delete[] m_data;
 }
 
+void BitSet::grow(size_t newSize) {
+	// The new buffer is created uninitialized. We will owerwrite it later anyway
+	uint8_t* newData = new uint8_t[newSize];
+	if (m_data) {
+		std::memcpy(newData, m_data, m_size);
+	}
+	std::memset(newData + m_size, 0, newSize - m_size);
+	delete[] m_data;
+	m_data = newData;
+	m_size = newSize;
+
+	// The new bytes are zeros, which the replicas assume anyway past the end of their storage.
+	// They don't need to be marked as changed
+	if (m_tracker) {
+		m_tracker->blockEpochs.resize(trackedBlockCount(m_size), 0);
+	}
+}
+
+void BitSet::reserve(size_t bitCount) {
+	const size_t newSize = (bitCount + 7) / 8;
+	if (newSize > m_size) {
+		grow(newSize);
+	}
+}
+
 void BitSet::set(size_t pos, bool value) {
 	const size_t byteIdx = pos / 8;
 	if (byteIdx >= m_size) {
 		// We ran out of storage and need to allocate a new buffer
-		const size_t newSize = byteIdx + 1;
-		// The new buffer is created uninitialized. We will owerwrite it later anyway
-		uint8_t* newData = new uint8_t[newSize];
-		if (m_data) {
-			std::memcpy(newData, m_data, m_size);
-		}
-		std::memset(newData + m_size, 0, newSize - m_size);
-		delete[] m_data;
-		m_data = newData;
-		m_size = newSize;
+		grow(byteIdx + 1);
 	}
 
 	// Branchless bit assignment. Compare with the conditional version:
 	// https://godbolt.org/z/3fTfor58b [extra]
 	const size_t bitIdx = pos % 8;
+	const uint8_t oldByte = m_data[byteIdx];
 	m_data[byteIdx] &= static_cast<uint8_t>(~(1 << bitIdx)); // clear the old bit value
 	m_data[byteIdx] |= static_cast<uint8_t>(value * (1 << bitIdx)); // set the new bit value
+
+	if (m_tracker && m_data[byteIdx] != oldByte) {
+		markChanged(byteIdx, byteIdx + 1);
+	}
 }
 
 void BitSet::clear() {
-	if (m_data) {
-		std::memset(m_data, 0, m_size);
+	if (!m_data) {
+		return;
+	}
+	if (m_tracker) {
+		// Only the blocks that had some elements change
+		for (size_t begin = 0; begin < m_size; begin += trackedBlockSize) {
+			const size_t end = std::min(begin + trackedBlockSize, m_size);
+			if (std::any_of(m_data + begin, m_data + end, [](uint8_t byte) { return byte != 0; })) {
+				markChanged(begin, end);
+			}
+		}
 	}
+	std::memset(m_data, 0, m_size);
+}
+
+BitSet BitSet::fromBytes(ArrayView<const uint8_t> bytes) {
+	BitSet result;
+	if (!bytes.empty()) {
+		result.m_data = new uint8_t[bytes.size()];
+		result.m_size = bytes.size();
+		std::memcpy(result.m_data, bytes.data(), bytes.size());
+	}
+	return result;
+}
+
+template<typename T>
+BitSet BitSet::fromSortedImpl(ArrayView<const T> values) {
+	assert(std::is_sorted(values.begin(), values.end()));
+	if (values.empty()) {
+		return {};
+	}
+
+	BitSet result;
+	result.m_size = static_cast<size_t>(values.back() / 8 + 1);
+	result.m_data = new uint8_t[result.m_size];
+
+	// Accumulate the bits of a single 64-bit word in a register and flush it once the values
+	// move to the next word. Every byte is written exactly once, so the buffer needs no zeroing
+	size_t flushedSize = 0;
+	const auto flush = [&result, &flushedSize](uint64_t wordIndex, uint64_t word) {
+		const size_t offset = static_cast<size_t>(wordIndex * 8);
+		std::memset(result.m_data + flushedSize, 0, offset - flushedSize);
+		const size_t count = std::min<size_t>(8, result.m_size - offset);
+		for (size_t i = 0; i < count; ++i) {
+			result.m_data[offset + i] = static_cast<uint8_t>(word >> (8 * i));
+		}
+		flushedSize = offset + count;
+	};
+
+	uint64_t wordIndex = uint64_t{values.front()} / 64;
+	uint64_t word = 0;
+	for (const T value : values) {
+		const uint64_t index = uint64_t{value} / 64;
+		if (index != wordIndex) {
+			flush(wordIndex, word);
+			wordIndex = index;
+			word = 0;
+		}
+		word |= uint64_t{1} << (value % 64);
+	}
+	flush(wordIndex, word);
+
+	return result;
+}
+
+void BitSet::writeBytes(size_t byteOffset, ArrayView<const uint8_t> bytes) {
+	if (bytes.empty()) {
+		return;
+	}
+	if (byteOffset + bytes.size() > m_size) {
+		grow(byteOffset + bytes.size());
+	}
+	std::memcpy(m_data + byteOffset, bytes.data(), bytes.size());
+
+	if (m_tracker) {
+		markChanged(byteOffset, byteOffset + bytes.size());
+	}
+}
+
+BitSet BitSet::fromSorted(ArrayView<const uint32_t> values) {
+	return fromSortedImpl(values);
+}
+
+BitSet BitSet::fromSorted(ArrayView<const uint64_t> values) {
+	return fromSortedImpl(values);
+}
+
+#ifdef BITSET_ISA_VERSIONS
+// The baseline x86-64 has no `popcnt`, and `std::popcount()` is a dozen instructions there
+__attribute__((target_clones("popcnt", "default")))
+#endif
+size_t BitSet::count() const {
+	size_t result = 0;
+	size_t i = 0;
+	for (; i + 8 <= m_size; i += 8) {
+		uint64_t word;
+		std::memcpy(&word, m_data + i, sizeof(word));
+		result += static_cast<size_t>(std::popcount(word));
+	}
+	for (; i < m_size; ++i) {
+		result += static_cast<size_t>(std::popcount(m_data[i]));
+	}
+	return result;
+}
+
+void BitSet::toIndices(std::vector<uint32_t>& output) const {
+	toIndicesImpl(bytes(), count(), output);
+}
+
+void BitSet::toIndices(std::vector<uint64_t>& output) const {
+	toIndicesImpl(bytes(), count(), output);
 }
 
 BitSet& BitSet::operator=(const BitSet& other) {
@@ -68,6 +414,165 @@ BitSet& BitSet::operator=(const BitSet& other) {
 		std::memcpy(m_data, other.m_data, m_size);
 	}
 
+	if (m_tracker) {
+		markAllChanged();
+	}
+
+	return *this;
+}
+
+void BitSet::enableChangeTracking() {
+	if (!m_tracker) {
+		m_tracker = std::make_unique<ChangeTracker>();
+		markAllChanged();
+	}
+}
+
+void BitSet::markChanged(size_t firstByte, size_t endByte) {
+	const uint64_t epoch = ++m_tracker->epoch;
+	const size_t lastBlock = (endByte - 1) / trackedBlockSize;
+	for (size_t block = firstByte / trackedBlockSize; block <= lastBlock; ++block) {
+		m_tracker->blockEpochs[block] = epoch;
+	}
+}
+
+void BitSet::markAllChanged() {
+	const uint64_t epoch = ++m_tracker->epoch;
+	m_tracker->blockEpochs.assign(trackedBlockCount(m_size), epoch);
+}
+
+void BitSet::diffSince(uint64_t sinceEpoch, std::ostream& output) const {
+	const size_t blockCount = trackedBlockCount(m_size);
+	const auto isChanged = [this, sinceEpoch](size_t block) {
+		return !m_tracker || m_tracker->blockEpochs[block] > sinceEpoch;
+	};
+
+	size_t changedCount = 0;
+	for (size_t block = 0; block < blockCount; ++block) {
+		changedCount += isChanged(block);
+	}
+
+	writeVarint(output, m_size);
+	writeVarint(output, epoch());
+	writeVarint(output, changedCount);
+
+	size_t nextBlock = 0;
+	for (size_t block = 0; block < blockCount; ++block) {
+		if (!isChanged(block)) {
+			continue;
+		}
+		writeVarint(output, block - nextBlock);
+		nextBlock = block + 1;
+
+		const size_t begin = block * trackedBlockSize;
+		const size_t end = std::min(begin + trackedBlockSize, m_size);
+		output.write(reinterpret_cast<const char*>(m_data + begin),
+			static_cast<std::streamsize>(end - begin));
+	}
+}
+
+uint64_t BitSet::applyDelta(std::istream& input, size_t maxSize) {
+	uint64_t size = 0;
+	uint64_t epoch = 0;
+	uint64_t changedCount = 0;
+	if (!readVarint(input, size) || !readVarint(input, epoch) || !readVarint(input, changedCount)
+		|| size > maxSize
+	) {
+		input.setstate(std::ios::failbit);
+		return 0;
+	}
+
+	// Read and validate the whole delta before touching the set. Don't trust the counts blindly,
+	// the buffers grow as the blocks are actually read
+	const size_t blockCount = trackedBlockCount(static_cast<size_t>(size));
+	std::vector<size_t> blocks;
+	std::vector<uint8_t> contents;
+	uint64_t nextBlock = 0;
+	for (uint64_t i = 0; i < changedCount; ++i) {
+		uint64_t gap = 0;
+		if (!readVarint(input, gap) || gap >= blockCount - std::min(nextBlock, blockCount)) {
+			input.setstate(std::ios::failbit);
+			return 0;
+		}
+		const size_t block = static_cast<size_t>(nextBlock + gap);
+		nextBlock = block + 1;
+
+		const size_t begin = block * trackedBlockSize;
+		const size_t length = std::min(static_cast<size_t>(size) - begin, trackedBlockSize);
+		const size_t offset = contents.size();
+		contents.resize(offset + length);
+		if (!input.read(reinterpret_cast<char*>(contents.data() + offset),
+			static_cast<std::streamsize>(length))
+		) {
+			return 0;
+		}
+		blocks.push_back(block);
+	}
+
+	// The source may have become smaller, e.g. by an assignment. The bytes past its end are zeros
+	if (size < m_size) {
+		const size_t end = m_size;
+		if (m_tracker) {
+			markChanged(static_cast<size_t>(size), end);
+		}
+		std::memset(m_data + static_cast<size_t>(size), 0, end - static_cast<size_t>(size));
+	}
+	else if (size > m_size) {
+		grow(static_cast<size_t>(size));
+	}
+
+	size_t offset = 0;
+	for (size_t block : blocks) {
+		const size_t begin = block * trackedBlockSize;
+		// As read above: the last block of the source may be shorter than that of the replica
+		const size_t length = std::min(static_cast<size_t>(size) - begin, trackedBlockSize);
+		writeBytes(begin, {contents.data() + offset, length});
+		offset += length;
+	}
+	return epoch;
+}
+
+template<typename ByteOp>
+void BitSet::combineInPlace(const BitSet& other, ByteOp op) {
+	// Bytes past the end of `other` are zeros
+	for (size_t begin = 0; begin < m_size; begin += trackedBlockSize) {
+		const size_t end = std::min(begin + trackedBlockSize, m_size);
+		const size_t commonEnd = std::clamp(other.m_size, begin, end);
+		uint8_t changed = 0;
+		for (size_t i = begin; i < commonEnd; ++i) {
+			const uint8_t byte = op(m_data[i], other.m_data[i]);
+			changed = static_cast<uint8_t>(changed | (byte ^ m_data[i]));
+			m_data[i] = byte;
+		}
+		for (size_t i = commonEnd; i < end; ++i) {
+			const uint8_t byte = op(m_data[i], uint8_t{0});
+			changed = static_cast<uint8_t>(changed | (byte ^ m_data[i]));
+			m_data[i] = byte;
+		}
+		if (m_tracker && changed != 0) {
+			markChanged(begin, end);
+		}
+	}
+}
+
+BitSet& BitSet::operator|=(const BitSet& other) {
+	if (other.m_size > m_size) {
+		grow(other.m_size);
+	}
+	combineInPlace(other, [](uint8_t a, uint8_t b) { return static_cast<uint8_t>(a | b); });
+	return *this;
+}
+
+BitSet& BitSet::operator&=(const BitSet& other) {
+	combineInPlace(other, [](uint8_t a, uint8_t b) { return static_cast<uint8_t>(a & b); });
+	return *this;
+}
+
+BitSet& BitSet::operator^=(const BitSet& other) {
+	if (other.m_size > m_size) {
+		grow(other.m_size);
+	}
+	combineInPlace(other, [](uint8_t a, uint8_t b) { return static_cast<uint8_t>(a ^ b); });
 	return *this;
 }
 
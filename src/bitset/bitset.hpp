@@ -6,10 +6,16 @@
 
 #include <ostream>
 #include <istream>
+#include <memory>
+#include <vector>
+
+#include "array_view/array_view.hpp"
 
 /// Ensure that we don't have to type std:: every time we use size_t
 using std::size_t;
 using std::uint8_t;
+using std::uint32_t;
+using std::uint64_t;
 
 /// @brief A set of unique nsigned numbers that uses a dynamically sized sequence of bits
 /// to represent the elements of the set
@@ -49,13 +55,16 @@ public:
 	/// @brief Move constructor [extra]
 	BitSet(BitSet&& other) noexcept:
 		m_data(other.m_data),
-		m_size(other.m_size)
+		m_size(other.m_size),
+		m_tracker(std::move(other.m_tracker))
 	{
 		other.m_data = nullptr;
 		other.m_size = 0;
 	}
 
 	/// @brief Move assignment operator [extra]
+	/// @note Takes the change tracking state of `other` along with its contents, see
+	/// `enableChangeTracking()`
 	BitSet& operator=(BitSet&& other) noexcept {
 		if (this == &other) {
 			return *this;
@@ -65,6 +74,7 @@ public:
 
 		m_data = other.m_data;
 		m_size = other.m_size;
+		m_tracker = std::move(other.m_tracker);
 		other.m_data = nullptr;
 		other.m_size = 0;
 
@@ -91,6 +101,10 @@ public:
 	/// Alternatively, set the value of the bit at the position `pos`
 	void set(size_t pos, bool value = true);
 
+	/// @brief Allocate the storage for all the elements less than `bitCount` at once, so that
+	/// `set()` doesn't have to reallocate it later. Doesn't change the contents of the set
+	void reserve(size_t bitCount);
+
 	/// TODO: Add flip() function
 
 	/// @brief Equivalent to `get(pos)`
@@ -107,6 +121,92 @@ public:
 	/// @brief Remove all elements from the set. Alternatively, set all the bits to zero
 	void clear();
 
+	/// @brief Get a read-only view of the underlying storage. The element `pos` is stored in the
+	/// bit `pos % 8` of the byte `pos / 8`
+	ArrayView<const uint8_t> bytes() const {
+		return {m_data, m_size};
+	}
+
+	/// @brief Construct a set from its raw storage as returned by `bytes()`
+	static BitSet fromBytes(ArrayView<const uint8_t> bytes);
+
+	/// @brief Overwrite the storage starting at the byte `byteOffset` with `bytes`, i.e. replace
+	/// the elements from `byteOffset * 8` to `(byteOffset + bytes.size()) * 8 - 1` at once
+	/// @note Several threads may write disjoint ranges at the same time if the storage has been
+	/// allocated with `reserve()` beforehand and the changes are not tracked
+	void writeBytes(size_t byteOffset, ArrayView<const uint8_t> bytes);
+
+	/// @brief Construct a set from a sorted sequence of elements. Much faster than calling `set()`
+	/// for every element: the storage is allocated once and the bits are accumulated in 64-bit
+	/// words before being written to memory
+	/// @pre `values` is sorted in ascending order. Duplicates are allowed
+	static BitSet fromSorted(ArrayView<const uint32_t> values);
+	static BitSet fromSorted(ArrayView<const uint64_t> values);
+
+	/// @brief Get the number of elements in the set
+	size_t count() const;
+
+	/// @brief Replace the contents of `output` with the elements of the set in ascending order
+	/// @note Expands every byte into up to 8 indices at once, with a lookup table or with the
+	/// AVX2 or AVX-512 instructions where the processor has them, so the cost depends on the
+	/// number of non-zero bytes rather than on the number of bits
+	/// @pre For the `uint32_t` overload, every element must fit into `uint32_t`
+	void toIndices(std::vector<uint32_t>& output) const;
+	void toIndices(std::vector<uint64_t>& output) const;
+
+	/// @brief Size of the blocks in bytes at which the changes are tracked
+	static constexpr size_t trackedBlockSize = 4096;
+
+	/// @brief Start recording which blocks of `trackedBlockSize` bytes are modified, so that
+	/// `diffSince()` can produce a delta that only contains the changed blocks. All the existing
+	/// blocks are considered changed in epoch 1, i.e. `diffSince(0)` contains the whole set
+	/// @note The tracking state goes along with the contents it describes: the move constructor,
+	/// the move assignment and `swap()` all hand it over to the set that receives the contents,
+	/// and leave a moved-from set empty and not tracked. Copies are not tracked, and a copy
+	/// assignment to a tracked set keeps it tracked and marks the whole set as changed
+	void enableChangeTracking();
+	/// @brief Stop recording the changes and free the tracking state
+	void disableChangeTracking() {
+		m_tracker.reset();
+	}
+	bool isTrackingChanges() const {
+		return m_tracker != nullptr;
+	}
+
+	/// @brief Get the epoch of the latest change. Every change increments the epoch by one.
+	/// Returns 0 if the changes are not tracked
+	uint64_t epoch() const {
+		return m_tracker ? m_tracker->epoch : 0;
+	}
+
+	/// @brief Write a delta with the blocks changed after `sinceEpoch` to the stream `output`.
+	/// A replica that was equal to this set at `sinceEpoch` becomes equal to it again after
+	/// `applyDelta()`. The size of the delta is proportional to the number of changed blocks
+	/// @note If the changes are not tracked, the delta contains the whole set
+	///
+	/// Format: LEB128 varints for the size of the set in bytes, the current epoch and the number
+	/// of blocks, followed by the blocks. Every block is the varint gap to the previous block index
+	/// and the raw bytes of the block
+	void diffSince(uint64_t sinceEpoch, std::ostream& output) const;
+
+	/// @brief The default limit of the size of the set in bytes that `applyDelta()` accepts
+	static constexpr size_t defaultMaxDeltaSize = size_t{1} << 30;
+
+	/// @brief Read a delta produced by `diffSince()` from the stream `input` and apply it.
+	/// Returns the epoch of the source set the delta was taken at. Sets `failbit` on the stream
+	/// and leaves the set unchanged if the delta is malformed
+	/// @param maxSize The largest size of the set in bytes the delta may grow it to, so that a
+	/// corrupt header can't make it allocate an arbitrary amount of memory
+	uint64_t applyDelta(std::istream& input, size_t maxSize = defaultMaxDeltaSize);
+
+	/// @brief In-place union. Only the blocks whose contents actually change are marked as
+	/// changed, as for all the in-place operations
+	BitSet& operator|=(const BitSet& other);
+	/// @brief In-place intersection
+	BitSet& operator&=(const BitSet& other);
+	/// @brief In-place symmetric difference
+	BitSet& operator^=(const BitSet& other);
+
 	/// @brief Equality operator
 	friend bool operator==(const BitSet& a, const BitSet& b);
 	/// @brief Nonequality operator
@@ -121,12 +221,13 @@ public:
 	/// @brief Construct a symmetric difference of two sets
 	friend BitSet operator^(const BitSet& a, const BitSet& b);
 
-	/// @brief Swap the contents of two sets
+	/// @brief Swap the contents of two sets, with their change tracking states
 	friend void swap(BitSet& a, BitSet& b) noexcept {
 		using std::swap;
 
 		swap(a.m_data, b.m_data);
 		swap(a.m_size, b.m_size);
+		swap(a.m_tracker, b.m_tracker);
 	}
 
 	/// @brief Write to the stream `output` in the format of `{value1, value2, ..., valueN}`
@@ -135,8 +236,36 @@ public:
 	friend std::istream& operator>>(std::istream& input, BitSet& bitset);
 
 private:
+	/// @brief Reallocate the storage to `newSize` bytes, filling the new bytes with zeros
+	/// @pre `newSize > m_size`
+	void grow(size_t newSize);
+
+	template<typename T>
+	static BitSet fromSortedImpl(ArrayView<const T> values);
+
+	/// @brief Combine `other` into this set byte by byte, marking the changed blocks
+	template<typename ByteOp>
+	void combineInPlace(const BitSet& other, ByteOp op);
+
+	/// @brief Mark the blocks overlapping the bytes `[firstByte, endByte)` as changed
+	/// @pre The changes are tracked
+	void markChanged(size_t firstByte, size_t endByte);
+	/// @brief Mark every block as changed, e.g. after the whole contents have been replaced
+	/// @pre The changes are tracked
+	void markAllChanged();
+
+	/// @brief The state of the change tracking
+	struct ChangeTracker {
+		uint64_t epoch = 0;
+		/// @brief The epoch of the latest change of every block
+		std::vector<uint64_t> blockEpochs;
+	};
+
 	uint8_t* m_data;
 	size_t m_size; // TODO: replace byte count with bit count
+	/// @brief `nullptr` unless the changes are tracked, so that untracked sets only pay for
+	/// a pointer and a predictable branch
+	std::unique_ptr<ChangeTracker> m_tracker;
 };
 
 #endif
@@ -0,0 +1,437 @@
+#include <cstdlib>
+
+#include <algorithm>
+#include <bitset>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <ostream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+#include "benchmark/benchmark.hpp"
+#include "bitset/bitset.hpp"
+
+namespace {
+
+/// @brief The cases with more elements are skipped: the element lists alone would take gigabytes
+constexpr size_t maxElementCount = size_t{1} << 26;
+/// @brief The hash set needs some 30-40 bytes per element, so it gets a lower limit
+constexpr size_t maxHashSetElementCount = size_t{1} << 22;
+/// @brief Number of random lookups per run of the `get` benchmark
+constexpr size_t queryCount = size_t{1} << 16;
+
+constexpr double densities[] = {0.00001, 0.0001, 0.001, 0.01, 0.1, 0.5};
+
+/// @brief The inputs shared by all the implementations for one size and density
+struct BenchmarkCase {
+	size_t sizeBits;
+	double density;
+	/// @brief Two random sets, sorted
+	std::vector<uint32_t> a;
+	std::vector<uint32_t> b;
+	/// @brief The elements of `a` in random order, for the insertion benchmark
+	std::vector<uint32_t> shuffledA;
+	/// @brief Uniformly random values less than `sizeBits`, about `density` of them are in `a`
+	std::vector<uint32_t> queries;
+	/// @brief The elements of `a` in the input format of `operator>>`
+	std::string textA;
+};
+
+/// @brief Pick every value less than `sizeBits` with the probability `density`. The gaps between
+/// the picked values are geometrically distributed, so the cost depends on the number of elements
+/// rather than on `sizeBits`
+std::vector<uint32_t> randomElements(size_t sizeBits, double density, std::mt19937_64& random) {
+	std::geometric_distribution<uint64_t> gap(density);
+	std::vector<uint32_t> result;
+	result.reserve(static_cast<size_t>(static_cast<double>(sizeBits) * density * 1.1) + 16);
+	for (uint64_t value = gap(random); value < sizeBits; value += gap(random) + 1) {
+		result.push_back(static_cast<uint32_t>(value));
+	}
+	return result;
+}
+
+BenchmarkCase makeCase(size_t sizeBits, double density) {
+	std::mt19937_64 random(sizeBits ^ static_cast<uint64_t>(density * 1e9));
+
+	BenchmarkCase result{sizeBits, density, {}, {}, {}, {}, {}};
+	result.a = randomElements(sizeBits, density, random);
+	result.b = randomElements(sizeBits, density, random);
+	result.shuffledA = result.a;
+	std::shuffle(result.shuffledA.begin(), result.shuffledA.end(), random);
+
+	std::uniform_int_distribution<uint32_t> value(0, static_cast<uint32_t>(sizeBits - 1));
+	result.queries.resize(queryCount);
+	for (uint32_t& query : result.queries) {
+		query = value(random);
+	}
+
+	std::ostringstream text;
+	for (uint32_t element : result.a) {
+		text << element << ' ';
+	}
+	result.textA = text.str();
+	return result;
+}
+
+/// @brief The format of `BitSet::operator<<` for the baselines that don't have their own
+template<typename Adapter>
+void writeElements(std::ostream& output, const typename Adapter::Set& set) {
+	output << '{';
+	bool isFirstElement = true;
+	Adapter::forEach(set, [&output, &isFirstElement](size_t value) {
+		output << (isFirstElement ? "" : ", ") << value;
+		isFirstElement = false;
+	});
+	output << '}';
+}
+
+template<typename Adapter>
+void readElements(std::istream& input, typename Adapter::Set& set) {
+	size_t value{};
+	while (input >> value) {
+		Adapter::insert(set, value);
+	}
+}
+
+struct BitSetAdapter {
+	using Set = BitSet;
+	static constexpr const char* name = "BitSet";
+
+	static std::unique_ptr<Set> make(size_t) {
+		return std::make_unique<Set>();
+	}
+	static void insert(Set& set, size_t value) {
+		set.set(value);
+	}
+	static bool contains(const Set& set, size_t value) {
+		return set.get(value);
+	}
+	static void unite(Set& result, const Set& a, const Set& b) {
+		result = a | b;
+	}
+	static void intersect(Set& result, const Set& a, const Set& b) {
+		result = a & b;
+	}
+	static void symmetricDifference(Set& result, const Set& a, const Set& b) {
+		result = a ^ b;
+	}
+	static bool equal(const Set& a, const Set& b) {
+		return a == b;
+	}
+	template<typename Visit>
+	static void forEach(const Set& set, Visit visit) {
+		std::vector<uint32_t> indices;
+		set.toIndices(indices);
+		for (uint32_t index : indices) {
+			visit(index);
+		}
+	}
+	static void write(std::ostream& output, const Set& set) {
+		output << set;
+	}
+	static void read(std::istream& input, Set& set) {
+		input >> set;
+	}
+};
+
+/// @brief `std::bitset` has its size fixed at compile time, so the objects are allocated on the
+/// heap: one of 1 Gbit would overflow the stack
+template<size_t Size>
+struct StdBitsetAdapter {
+	using Set = std::bitset<Size>;
+	static constexpr const char* name = "std::bitset";
+
+	static std::unique_ptr<Set> make(size_t) {
+		return std::make_unique<Set>();
+	}
+	static void insert(Set& set, size_t value) {
+		set.set(value);
+	}
+	static bool contains(const Set& set, size_t value) {
+		return set.test(value);
+	}
+	// The in-place operators avoid temporaries on the stack
+	static void unite(Set& result, const Set& a, const Set& b) {
+		result = a;
+		result |= b;
+	}
+	static void intersect(Set& result, const Set& a, const Set& b) {
+		result = a;
+		result &= b;
+	}
+	static void symmetricDifference(Set& result, const Set& a, const Set& b) {
+		result = a;
+		result ^= b;
+	}
+	static bool equal(const Set& a, const Set& b) {
+		return a == b;
+	}
+	template<typename Visit>
+	static void forEach(const Set& set, Visit visit) {
+		for (size_t i = 0; i < Size; ++i) {
+			if (set.test(i)) {
+				visit(i);
+			}
+		}
+	}
+	static void write(std::ostream& output, const Set& set) {
+		writeElements<StdBitsetAdapter>(output, set);
+	}
+	static void read(std::istream& input, Set& set) {
+		readElements<StdBitsetAdapter>(input, set);
+	}
+};
+
+struct VectorBoolAdapter {
+	using Set = std::vector<bool>;
+	static constexpr const char* name = "std::vector<bool>";
+
+	static std::unique_ptr<Set> make(size_t size) {
+		return std::make_unique<Set>(size);
+	}
+	static void insert(Set& set, size_t value) {
+		set[value] = true;
+	}
+	static bool contains(const Set& set, size_t value) {
+		return set[value];
+	}
+	// There are no set operations, the generic algorithms go bit by bit
+	static void unite(Set& result, const Set& a, const Set& b) {
+		std::transform(a.begin(), a.end(), b.begin(), result.begin(), std::bit_or<bool>());
+	}
+	static void intersect(Set& result, const Set& a, const Set& b) {
+		std::transform(a.begin(), a.end(), b.begin(), result.begin(), std::bit_and<bool>());
+	}
+	static void symmetricDifference(Set& result, const Set& a, const Set& b) {
+		std::transform(a.begin(), a.end(), b.begin(), result.begin(), std::bit_xor<bool>());
+	}
+	static bool equal(const Set& a, const Set& b) {
+		return a == b;
+	}
+	template<typename Visit>
+	static void forEach(const Set& set, Visit visit) {
+		for (size_t i = 0; i < set.size(); ++i) {
+			if (set[i]) {
+				visit(i);
+			}
+		}
+	}
+	static void write(std::ostream& output, const Set& set) {
+		writeElements<VectorBoolAdapter>(output, set);
+	}
+	static void read(std::istream& input, Set& set) {
+		readElements<VectorBoolAdapter>(input, set);
+	}
+};
+
+struct HashSetAdapter {
+	using Set = std::unordered_set<size_t>;
+	static constexpr const char* name = "std::unordered_set";
+
+	static std::unique_ptr<Set> make(size_t) {
+		return std::make_unique<Set>();
+	}
+	static void insert(Set& set, size_t value) {
+		set.insert(value);
+	}
+	static bool contains(const Set& set, size_t value) {
+		return set.count(value) != 0;
+	}
+	static void unite(Set& result, const Set& a, const Set& b) {
+		result = a;
+		result.insert(b.begin(), b.end());
+	}
+	static void intersect(Set& result, const Set& a, const Set& b) {
+		result.clear();
+		const Set& smaller = a.size() <= b.size() ? a : b;
+		const Set& larger = a.size() <= b.size() ? b : a;
+		for (size_t value : smaller) {
+			if (larger.count(value) != 0) {
+				result.insert(value);
+			}
+		}
+	}
+	static void symmetricDifference(Set& result, const Set& a, const Set& b) {
+		result.clear();
+		for (size_t value : a) {
+			if (b.count(value) == 0) {
+				result.insert(value);
+			}
+		}
+		for (size_t value : b) {
+			if (a.count(value) == 0) {
+				result.insert(value);
+			}
+		}
+	}
+	static bool equal(const Set& a, const Set& b) {
+		return a == b;
+	}
+	template<typename Visit>
+	static void forEach(const Set& set, Visit visit) {
+		for (size_t value : set) {
+			visit(value);
+		}
+	}
+	static void write(std::ostream& output, const Set& set) {
+		writeElements<HashSetAdapter>(output, set);
+	}
+	static void read(std::istream& input, Set& set) {
+		readElements<HashSetAdapter>(input, set);
+	}
+};
+
+std::string formatDensity(double density) {
+	std::ostringstream result;
+	result << density * 100 << '%';
+	return result.str();
+}
+
+/// @brief Run all the operations for one implementation on one case
+template<typename Adapter>
+void benchmarkImplementation(BenchmarkSuite& suite, const BenchmarkCase& input, std::ostream& log) {
+	using Set = typename Adapter::Set;
+
+	const auto labels = [&input](const char* operation) {
+		return BenchmarkSuite::Labels{
+			{"implementation", Adapter::name},
+			{"operation", operation},
+			{"sizeBits", std::to_string(input.sizeBits)},
+			{"density", formatDensity(input.density)},
+		};
+	};
+	const auto report = [&log](const BenchmarkResult& result) {
+		BenchmarkSuite::writeSummary(log, result);
+	};
+
+	const auto build = [&input](const std::vector<uint32_t>& elements) {
+		std::unique_ptr<Set> set = Adapter::make(input.sizeBits);
+		for (uint32_t element : elements) {
+			Adapter::insert(*set, element);
+		}
+		return set;
+	};
+	const std::unique_ptr<Set> a = build(input.a);
+	const std::unique_ptr<Set> b = build(input.b);
+	const std::unique_ptr<Set> copyOfA = build(input.a);
+	const size_t elementCount = std::max<size_t>(input.a.size(), 1);
+	const size_t pairCount = std::max<size_t>(input.a.size() + input.b.size(), 1);
+
+	std::unique_ptr<Set> result;
+	const auto resetResult = [&result, &input] {
+		result = Adapter::make(input.sizeBits);
+	};
+
+	report(suite.run(labels("set"), elementCount, resetResult, [&] {
+		for (uint32_t element : input.shuffledA) {
+			Adapter::insert(*result, element);
+		}
+	}));
+
+	report(suite.run(labels("get"), input.queries.size(), [&] {
+		size_t hits = 0;
+		for (uint32_t query : input.queries) {
+			hits += Adapter::contains(*a, query);
+		}
+		doNotOptimize(hits);
+	}));
+
+	// The set operations overwrite the whole result, so it is made once for all of them
+	resetResult();
+	report(suite.run(labels("union"), pairCount, [&] {
+		Adapter::unite(*result, *a, *b);
+		doNotOptimize(*result);
+	}));
+	report(suite.run(labels("intersection"), pairCount, [&] {
+		Adapter::intersect(*result, *a, *b);
+		doNotOptimize(*result);
+	}));
+	report(suite.run(labels("symmetricDifference"), pairCount, [&] {
+		Adapter::symmetricDifference(*result, *a, *b);
+		doNotOptimize(*result);
+	}));
+
+	report(suite.run(labels("equality"), elementCount, [&] {
+		const bool isEqual = Adapter::equal(*a, *copyOfA);
+		doNotOptimize(isEqual);
+	}));
+
+	report(suite.run(labels("iterate"), elementCount, [&] {
+		size_t sum = 0;
+		Adapter::forEach(*a, [&sum](size_t value) {
+			sum += value;
+		});
+		doNotOptimize(sum);
+	}));
+
+	report(suite.run(labels("write"), elementCount, [&] {
+		std::ostringstream output;
+		Adapter::write(output, *a);
+		doNotOptimize(output);
+	}));
+	report(suite.run(labels("read"), elementCount, resetResult, [&] {
+		std::istringstream stream(input.textA);
+		Adapter::read(stream, *result);
+	}));
+}
+
+template<size_t Log2>
+void benchmarkSize(BenchmarkSuite& suite, size_t maxSizeLog2, std::ostream& log) {
+	if (Log2 > maxSizeLog2) {
+		return;
+	}
+
+	constexpr size_t sizeBits = size_t{1} << Log2;
+	for (double density : densities) {
+		if (static_cast<double>(sizeBits) * density > static_cast<double>(maxElementCount)) {
+			log << "Skipping 2^" << Log2 << " bits at " << formatDensity(density)
+				<< ": too many elements\n";
+			continue;
+		}
+
+		const BenchmarkCase input = makeCase(sizeBits, density);
+		benchmarkImplementation<BitSetAdapter>(suite, input, log);
+		benchmarkImplementation<StdBitsetAdapter<sizeBits>>(suite, input, log);
+		benchmarkImplementation<VectorBoolAdapter>(suite, input, log);
+		if (input.a.size() <= maxHashSetElementCount) {
+			benchmarkImplementation<HashSetAdapter>(suite, input, log);
+		}
+	}
+}
+
+template<size_t... Log2s>
+void benchmarkSizes(std::index_sequence<Log2s...>, BenchmarkSuite& suite, size_t maxSizeLog2,
+	std::ostream& log
+) {
+	(benchmarkSize<Log2s>(suite, maxSizeLog2, log), ...);
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+	size_t maxSizeLog2 = 24;
+	const std::optional<BenchmarkCommandLine> commandLine = parseBenchmarkCommandLine(argc, argv,
+		"  --max-size-log2 N  Largest set size as a power of two: 10, 16, 20, 24 or 30"
+		" (default 24)\n",
+		[&maxSizeLog2](std::string_view name, const char* value) {
+			if (name != "--max-size-log2") {
+				return false;
+			}
+			maxSizeLog2 = std::strtoul(value, nullptr, 10);
+			return true;
+		});
+	if (!commandLine) {
+		return 1;
+	}
+
+	BenchmarkSuite suite(commandLine->options);
+	benchmarkSizes(std::index_sequence<10, 16, 20, 24, 30>(), suite, maxSizeLog2,
+		commandLine->log());
+	return commandLine->writeJson(suite) ? 0 : 1;
+}
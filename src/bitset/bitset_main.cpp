@@ -1,5 +1,9 @@
+#include <algorithm>
 #include <iostream>
 #include <iomanip>
+#include <sstream>
+#include <utility>
+#include <vector>
 
 #include "bitset/bitset.hpp"
 
@@ -87,6 +91,91 @@ int main() {
 		std::cout << "b -> " << b << '\n';
 	}
 
+	{
+		std::cout << line << "Testing bulk conversion: \n\n";
+
+		const uint32_t values[] = {0, 7, 8, 63, 64, 64, 65, 200, 1000};
+		const BitSet fromSorted = BitSet::fromSorted(values);
+		std::cout << "BitSet::fromSorted -> " << fromSorted << '\n';
+		std::cout << "count() -> " << fromSorted.count() << '\n';
+
+		std::vector<uint32_t> indices;
+		fromSorted.toIndices(indices);
+		std::cout << "toIndices ->";
+		for (uint32_t index : indices) {
+			std::cout << ' ' << index;
+		}
+		std::cout << '\n';
+	}
+
+	{
+		std::cout << line << "Testing change tracking and deltas: \n\n";
+
+		// 1 MiB of storage, of which only a few blocks change
+		BitSet source;
+		source.reserve(size_t{1} << 23);
+		for (size_t i = 0; i < (size_t{1} << 23); i += 1000) {
+			source.set(i);
+		}
+		source.enableChangeTracking();
+
+		// Bring a replica up to date with the delta from epoch 0, which contains the whole set
+		std::stringstream full;
+		source.diffSince(0, full);
+		BitSet replica;
+		uint64_t syncedEpoch = replica.applyDelta(full);
+		std::cout << "Full delta: " << full.str().size() << " bytes, replica == source -> "
+			<< (replica == source) << '\n';
+
+		source.set(5);
+		source.set(1000, false);
+		source.set((size_t{1} << 23) + 17);
+		source ^= b;
+
+		std::stringstream delta;
+		source.diffSince(syncedEpoch, delta);
+		syncedEpoch = replica.applyDelta(delta);
+		std::cout << "Delta after 4 changes: " << delta.str().size()
+			<< " bytes, replica == source -> " << (replica == source) << ", epoch " << syncedEpoch
+			<< '\n';
+
+		std::stringstream truncated(delta.str().substr(0, 100));
+		replica.applyDelta(truncated);
+		std::cout << "Truncated delta fails -> " << truncated.fail() << ", replica == source -> "
+			<< (replica == source) << '\n';
+
+		// A header that claims a huge set is rejected before anything is allocated
+		std::stringstream huge;
+		huge << '\xff' << '\xff' << '\xff' << '\xff' << '\xff' << '\x7f' << '\x01' << '\x00';
+		replica.applyDelta(huge);
+		std::cout << "Delta of a 4 TiB set fails -> " << huge.fail() << ", replica == source -> "
+			<< (replica == source) << '\n';
+
+		// A replica with more storage than the source, its extra bytes set, takes only the bytes
+		// of the source, even from the partial last block of the source. The rest become zeros
+		BitSet small;
+		small.reserve(5000 * 8);
+		small.enableChangeTracking();
+		std::vector<uint8_t> largeBytes(8192, 0);
+		std::fill(largeBytes.begin() + 5000, largeBytes.end(), uint8_t{0xff});
+		BitSet large = BitSet::fromBytes({largeBytes.begin(), largeBytes.end()});
+		const uint64_t smallEpoch = small.epoch();
+		small.set(4500 * 8 + 1);
+		std::stringstream smallDelta;
+		small.diffSince(smallEpoch, smallDelta);
+		large.applyDelta(smallDelta);
+		std::cout << "Delta of a smaller set, replica == source -> " << (large == small) << '\n';
+
+		// `std::swap()` moves and `swap()` exchanges, both carry the tracking with the contents
+		BitSet untracked;
+		std::swap(source, untracked);
+		std::cout << "std::swap() with an untracked set, tracked -> " << source.isTrackingChanges()
+			<< ", " << untracked.isTrackingChanges() << '\n';
+		swap(source, untracked);
+		std::cout << "swap() back, tracked -> " << source.isTrackingChanges() << ", "
+			<< untracked.isTrackingChanges() << '\n';
+	}
+
 	{
 		std::cout << line << "Testing BitSet::clear: \n\n";
 
@@ -0,0 +1,258 @@
+#include "bitset/bitset_stream.hpp"
+
+#include <cassert>
+#include <cstring>
+
+#include <algorithm>
+#include <condition_variable>
+#include <exception>
+#include <fstream>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <thread>
+#include <vector>
+
+namespace {
+
+/// @brief Throw `std::runtime_error` mentioning the offending file
+[[noreturn]] void throwIoError(const char* what, const std::filesystem::path& path) {
+	throw std::runtime_error(std::string(what) + " '" + path.string() + "'");
+}
+
+/// @brief A chunk of every input file, all of the same length
+struct ChunkBuffer {
+	std::vector<std::vector<uint8_t>> inputs;
+	size_t size = 0;
+	bool isReady = false;
+};
+
+/// @brief Reads consecutive chunks of several files on a background thread. While the consumer
+/// processes one buffer, the reader fills the other one
+class DoubleBufferedReader {
+public:
+	DoubleBufferedReader(ArrayView<const std::filesystem::path> paths, std::uint64_t totalSize,
+		size_t chunkSize
+	):
+		m_totalSize(totalSize),
+		m_chunkSize(chunkSize)
+	{
+		for (const std::filesystem::path& path : paths) {
+			std::ifstream& file = m_files.emplace_back(path, std::ios::binary);
+			if (!file) {
+				throwIoError("Cannot open bitset file", path);
+			}
+			m_paths.push_back(path);
+			m_fileSizes.push_back(std::filesystem::file_size(path));
+		}
+
+		const size_t bufferSize =
+			static_cast<size_t>(std::min<std::uint64_t>(chunkSize, totalSize));
+		for (ChunkBuffer& buffer : m_buffers) {
+			buffer.inputs.assign(m_files.size(), std::vector<uint8_t>(bufferSize));
+		}
+
+		// Start the thread last so that it never observes a partially constructed object
+		m_thread = std::thread(&DoubleBufferedReader::run, this);
+	}
+
+	DoubleBufferedReader(const DoubleBufferedReader&) = delete;
+	DoubleBufferedReader& operator=(const DoubleBufferedReader&) = delete;
+
+	~DoubleBufferedReader() {
+		{
+			std::lock_guard lock(m_mutex);
+			m_isStopping = true;
+		}
+		m_cv.notify_all();
+		m_thread.join();
+	}
+
+	/// @brief Wait until the next chunk is read and return it. The returned buffer stays valid
+	/// until `release()` is called
+	/// @throws std::runtime_error if the reader thread failed
+	const ChunkBuffer& acquire() {
+		ChunkBuffer& buffer = m_buffers[m_consumerIndex % 2];
+		std::unique_lock lock(m_mutex);
+		m_cv.wait(lock, [&] { return buffer.isReady || m_error; });
+		if (!buffer.isReady) {
+			std::rethrow_exception(m_error);
+		}
+		return buffer;
+	}
+
+	/// @brief Give the last acquired buffer back to the reader thread
+	void release() {
+		{
+			std::lock_guard lock(m_mutex);
+			m_buffers[m_consumerIndex % 2].isReady = false;
+		}
+		++m_consumerIndex;
+		m_cv.notify_all();
+	}
+
+private:
+	void run() {
+		try {
+			size_t chunkIndex = 0;
+			for (std::uint64_t offset = 0; offset < m_totalSize; offset += m_chunkSize) {
+				ChunkBuffer& buffer = m_buffers[chunkIndex++ % 2];
+				{
+					std::unique_lock lock(m_mutex);
+					m_cv.wait(lock, [&] { return !buffer.isReady || m_isStopping; });
+					if (m_isStopping) {
+						return;
+					}
+				}
+
+				// The consumer doesn't touch a buffer that is not ready, so no lock is needed here
+				buffer.size = static_cast<size_t>(std::min<std::uint64_t>(m_chunkSize,
+					m_totalSize - offset));
+				for (size_t i = 0; i < m_files.size(); ++i) {
+					readChunk(i, offset, buffer.inputs[i].data(), buffer.size);
+				}
+
+				{
+					std::lock_guard lock(m_mutex);
+					buffer.isReady = true;
+				}
+				m_cv.notify_all();
+			}
+		}
+		catch (...) {
+			{
+				std::lock_guard lock(m_mutex);
+				m_error = std::current_exception();
+			}
+			m_cv.notify_all();
+		}
+	}
+
+	/// @brief Read `size` bytes of the file `fileIndex` starting at `offset`. The part past
+	/// the end of the file is filled with zeros
+	void readChunk(size_t fileIndex, std::uint64_t offset, uint8_t* dest, size_t size) {
+		const std::uint64_t fileSize = m_fileSizes[fileIndex];
+		const size_t available = offset >= fileSize ? 0 :
+			static_cast<size_t>(std::min<std::uint64_t>(size, fileSize - offset));
+
+		if (available != 0) {
+			std::ifstream& file = m_files[fileIndex];
+			file.read(reinterpret_cast<char*>(dest), static_cast<std::streamsize>(available));
+			if (static_cast<size_t>(file.gcount()) != available) {
+				throwIoError("Cannot read bitset file", m_paths[fileIndex]);
+			}
+		}
+		std::memset(dest + available, 0, size - available);
+	}
+
+	std::vector<std::ifstream> m_files;
+	std::vector<std::filesystem::path> m_paths;
+	std::vector<std::uint64_t> m_fileSizes;
+	std::uint64_t m_totalSize;
+	size_t m_chunkSize;
+
+	ChunkBuffer m_buffers[2];
+	size_t m_consumerIndex = 0;
+
+	std::mutex m_mutex;
+	std::condition_variable m_cv;
+	std::exception_ptr m_error;
+	bool m_isStopping = false;
+
+	std::thread m_thread;
+};
+
+/// @brief `result = result <op> input`. Plain byte loops are auto-vectorized by the compiler
+void applyOperation(SetOperation op, uint8_t* result, const uint8_t* input, size_t size) {
+	switch (op) {
+	case SetOperation::Union:
+		for (size_t i = 0; i < size; ++i) {
+			result[i] |= input[i];
+		}
+		break;
+	case SetOperation::Intersection:
+		for (size_t i = 0; i < size; ++i) {
+			result[i] &= input[i];
+		}
+		break;
+	case SetOperation::SymmetricDifference:
+		for (size_t i = 0; i < size; ++i) {
+			result[i] ^= input[i];
+		}
+		break;
+	}
+}
+
+} // namespace
+
+void writeBitSetFile(const std::filesystem::path& path, const BitSet& bitset) {
+	std::ofstream file(path, std::ios::binary | std::ios::trunc);
+	const ArrayView<const uint8_t> bytes = bitset.bytes();
+	file.write(reinterpret_cast<const char*>(bytes.data()),
+		static_cast<std::streamsize>(bytes.size()));
+	if (!file) {
+		throwIoError("Cannot write bitset file", path);
+	}
+}
+
+BitSet readBitSetFile(const std::filesystem::path& path) {
+	std::ifstream file(path, std::ios::binary);
+	if (!file) {
+		throwIoError("Cannot open bitset file", path);
+	}
+	std::vector<uint8_t> bytes(static_cast<size_t>(std::filesystem::file_size(path)));
+	file.read(reinterpret_cast<char*>(bytes.data()), static_cast<std::streamsize>(bytes.size()));
+	if (static_cast<size_t>(file.gcount()) != bytes.size()) {
+		throwIoError("Cannot read bitset file", path);
+	}
+	return BitSet::fromBytes({bytes.begin(), bytes.end()});
+}
+
+std::uint64_t streamSetOperation(SetOperation op, ArrayView<const std::filesystem::path> inputPaths,
+	const std::filesystem::path& outputPath, size_t chunkSize
+) {
+	assert(inputPaths.size() >= 2);
+	assert(chunkSize > 0);
+
+	// The intersection can't be longer than the shortest input. Other operations keep
+	// every byte of the longest input
+	std::uint64_t totalSize = op == SetOperation::Intersection ? UINT64_MAX : 0;
+	for (const std::filesystem::path& path : inputPaths) {
+		// Creating the output would truncate the input before it is read. The error is set
+		// when the output doesn't exist yet, which is fine
+		std::error_code error;
+		if (std::filesystem::equivalent(path, outputPath, error)) {
+			throwIoError("Cannot write the result over the input", outputPath);
+		}
+		const std::uint64_t fileSize = std::filesystem::file_size(path);
+		totalSize = op == SetOperation::Intersection ?
+			std::min(totalSize, fileSize) :
+			std::max(totalSize, fileSize);
+	}
+
+	std::ofstream output(outputPath, std::ios::binary | std::ios::trunc);
+	if (!output) {
+		throwIoError("Cannot create bitset file", outputPath);
+	}
+
+	DoubleBufferedReader reader(inputPaths, totalSize, chunkSize);
+	std::vector<uint8_t> result;
+	for (std::uint64_t offset = 0; offset < totalSize; offset += chunkSize) {
+		const ChunkBuffer& chunk = reader.acquire();
+		result.assign(chunk.inputs[0].begin(), chunk.inputs[0].begin()
+			+ static_cast<std::ptrdiff_t>(chunk.size));
+		for (size_t i = 1; i < chunk.inputs.size(); ++i) {
+			applyOperation(op, result.data(), chunk.inputs[i].data(), chunk.size);
+		}
+		reader.release();
+
+		output.write(reinterpret_cast<const char*>(result.data()),
+			static_cast<std::streamsize>(result.size()));
+		if (!output) {
+			throwIoError("Cannot write bitset file", outputPath);
+		}
+	}
+
+	return totalSize;
+}
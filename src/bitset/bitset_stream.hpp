@@ -0,0 +1,49 @@
+#ifndef BITSET_STREAM_HPP_INCLUDED
+#define BITSET_STREAM_HPP_INCLUDED
+
+#include <cstddef>
+#include <cstdint>
+
+#include <filesystem>
+
+#include "array_view/array_view.hpp"
+#include "bitset/bitset.hpp"
+
+/// Out-of-core set operations for bitsets that don't fit into RAM.
+///
+/// A bitset file has exactly the same layout as the in-memory storage of `BitSet` returned by
+/// `BitSet::bytes()`: the element `pos` is stored in the bit `pos % 8` of the byte `pos / 8`.
+/// Files of different length are treated as if the shorter ones were padded with zero bytes.
+
+/// @brief Set operation applied by `streamSetOperation`
+enum class SetOperation {
+	Union,
+	Intersection,
+	SymmetricDifference,
+};
+
+/// @brief Write the storage of `bitset` to the file at `path`, overwriting it
+/// @throws std::runtime_error if the file can't be written
+void writeBitSetFile(const std::filesystem::path& path, const BitSet& bitset);
+
+/// @brief Load the whole file at `path` into memory
+/// @throws std::runtime_error if the file can't be read
+BitSet readBitSetFile(const std::filesystem::path& path);
+
+/// @brief Default amount of bytes read from every input file at once
+inline constexpr size_t defaultStreamChunkSize = size_t{1} << 20;
+
+/// @brief Apply `op` to all of the `inputPaths` (left to right) and write the result into
+/// `outputPath` chunk by chunk.
+///
+/// The files are read on a separate thread into two sets of buffers, so that reading the next
+/// chunk overlaps with computing and writing the current one. Memory usage is bounded by
+/// `(2 * inputPaths.size() + 1) * chunkSize` bytes regardless of the file sizes.
+///
+/// @pre `inputPaths.size() >= 2` and `chunkSize > 0`
+/// @return The size of the output file in bytes
+/// @throws std::runtime_error on I/O errors, or if `outputPath` is one of the `inputPaths`
+std::uint64_t streamSetOperation(SetOperation op, ArrayView<const std::filesystem::path> inputPaths,
+	const std::filesystem::path& outputPath, size_t chunkSize = defaultStreamChunkSize);
+
+#endif
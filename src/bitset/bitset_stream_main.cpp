@@ -0,0 +1,66 @@
+#include <iostream>
+#include <stdexcept>
+
+#include "bitset/bitset.hpp"
+#include "bitset/bitset_stream.hpp"
+
+namespace fs = std::filesystem;
+
+int main() {
+	BitSet a;
+	for (size_t i = 0; i < 200; i += 3) {
+		a.set(i);
+	}
+	BitSet b;
+	for (size_t i = 0; i < 120; i += 5) {
+		b.set(i);
+	}
+	BitSet c;
+	c.set(1);
+	c.set(30);
+	c.set(299);
+
+	const fs::path dir = fs::temp_directory_path();
+	const fs::path inputs[] = {dir / "bitset_stream_a.bin", dir / "bitset_stream_b.bin",
+		dir / "bitset_stream_c.bin"};
+	const fs::path output = dir / "bitset_stream_result.bin";
+
+	writeBitSetFile(inputs[0], a);
+	writeBitSetFile(inputs[1], b);
+	writeBitSetFile(inputs[2], c);
+
+	std::cout << "a -> " << a << '\n';
+	std::cout << "b -> " << b << '\n';
+	std::cout << "c -> " << c << '\n';
+	std::cout << std::boolalpha;
+
+	struct TestCase { const char* name; SetOperation op; BitSet expected; };
+	const TestCase testCases[] = {
+		{"a | b | c", SetOperation::Union, a | b | c},
+		{"a & b & c", SetOperation::Intersection, a & b & c},
+		{"a ^ b ^ c", SetOperation::SymmetricDifference, a ^ b ^ c},
+	};
+
+	// A tiny chunk size makes the reader thread go through many chunks
+	constexpr size_t chunkSize = 4;
+	for (const TestCase& testCase : testCases) {
+		const std::uint64_t size = streamSetOperation(testCase.op, inputs, output, chunkSize);
+		const BitSet result = readBitSetFile(output);
+		std::cout << '\n' << testCase.name << " -> " << result << '\n';
+		std::cout << "Output size: " << size << " bytes, matches in-memory result: "
+			<< (result == testCase.expected) << '\n';
+	}
+
+	try {
+		streamSetOperation(SetOperation::Union, inputs, inputs[1], chunkSize);
+	}
+	catch (const std::runtime_error& error) {
+		std::cout << "\nWriting over an input: " << error.what() << '\n';
+	}
+	std::cout << "The input is intact: " << (readBitSetFile(inputs[1]) == b) << '\n';
+
+	for (const fs::path& path : inputs) {
+		fs::remove(path);
+	}
+	fs::remove(output);
+}
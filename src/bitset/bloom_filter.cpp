@@ -0,0 +1,212 @@
+#include "bitset/bloom_filter.hpp"
+
+#include <cassert>
+#include <cmath>
+
+#include <algorithm>
+
+#include "bitset/mix_hash.hpp"
+
+namespace {
+
+/// @brief Number of keys whose hashes are computed together by the batch functions
+constexpr size_t batchSize = 16;
+
+/// @brief Second hash for the double hashing scheme `h1 + i * h2`. Odd, so that the probes
+/// never collapse into a single position
+uint64_t secondHash(uint64_t hash) {
+	return ((hash >> 32) | (hash << 32)) | 1;
+}
+
+/// @brief Split `keys` into batches and pass the precomputed hashes of every batch to `func`
+template<typename Func>
+void forEachHashBatch(ArrayView<const uint64_t> keys, Func func) {
+	uint64_t hashes[batchSize];
+	for (size_t offset = 0; offset < keys.size(); offset += batchSize) {
+		const size_t count = std::min(batchSize, keys.size() - offset);
+		// A separate loop without any memory accesses except for the keys, so it can be vectorized
+		for (size_t i = 0; i < count; ++i) {
+			hashes[i] = mixHash(keys[offset + i]);
+		}
+		func(offset, ArrayView<const uint64_t>(hashes, count));
+	}
+}
+
+} // namespace
+
+size_t BloomFilterSizing::optimalBitCount(size_t expectedCount, double falsePositiveRate) {
+	assert(falsePositiveRate > 0 && falsePositiveRate < 1);
+	const double ln2 = std::log(2.0);
+	const double bits = -static_cast<double>(expectedCount) * std::log(falsePositiveRate)
+		/ (ln2 * ln2);
+	return std::max<size_t>(static_cast<size_t>(std::ceil(bits)), 1);
+}
+
+unsigned BloomFilterSizing::optimalHashCount(size_t bitCount, size_t expectedCount) {
+	if (expectedCount == 0) {
+		return 1;
+	}
+	const double count = static_cast<double>(bitCount) / static_cast<double>(expectedCount)
+		* std::log(2.0);
+	return std::clamp(static_cast<unsigned>(std::lround(count)), 1u, 32u);
+}
+
+double BloomFilterSizing::falsePositiveRate(size_t bitCount, size_t count, unsigned hashCount) {
+	const double k = hashCount;
+	return std::pow(1 - std::exp(-k * static_cast<double>(count) / static_cast<double>(bitCount)),
+		k);
+}
+
+BloomFilter::BloomFilter(size_t bitCount, unsigned hashCount):
+	m_bitCount(bitCount),
+	m_hashCount(hashCount)
+{
+	assert(bitCount > 0 && hashCount > 0);
+	m_bits.reserve(bitCount);
+}
+
+BloomFilter BloomFilter::forCapacity(size_t expectedCount, double falsePositiveRate) {
+	const size_t bitCount = BloomFilterSizing::optimalBitCount(expectedCount, falsePositiveRate);
+	return {bitCount, BloomFilterSizing::optimalHashCount(bitCount, expectedCount)};
+}
+
+void BloomFilter::insert(uint64_t key) {
+	const uint64_t hash = mixHash(key);
+	const uint64_t step = secondHash(hash);
+	for (unsigned i = 0; i < m_hashCount; ++i) {
+		m_bits.set(static_cast<size_t>((hash + i * step) % m_bitCount));
+	}
+}
+
+bool BloomFilter::mayContain(uint64_t key) const {
+	const uint64_t hash = mixHash(key);
+	const uint64_t step = secondHash(hash);
+	for (unsigned i = 0; i < m_hashCount; ++i) {
+		if (!m_bits.get(static_cast<size_t>((hash + i * step) % m_bitCount))) {
+			return false;
+		}
+	}
+	return true;
+}
+
+void BloomFilter::insert(ArrayView<const uint64_t> keys) {
+	forEachHashBatch(keys, [this](size_t, ArrayView<const uint64_t> hashes) {
+		for (uint64_t hash : hashes) {
+			const uint64_t step = secondHash(hash);
+			for (unsigned i = 0; i < m_hashCount; ++i) {
+				m_bits.set(static_cast<size_t>((hash + i * step) % m_bitCount));
+			}
+		}
+	});
+}
+
+void BloomFilter::mayContain(ArrayView<const uint64_t> keys, ArrayView<bool> results) const {
+	assert(results.size() == keys.size());
+	forEachHashBatch(keys, [this, results](size_t offset, ArrayView<const uint64_t> hashes) {
+		for (size_t j = 0; j < hashes.size(); ++j) {
+			const uint64_t step = secondHash(hashes[j]);
+			// Check all the probes without an early exit, which is mispredicted half of the time
+			bool isFound = true;
+			for (unsigned i = 0; i < m_hashCount; ++i) {
+				isFound &= m_bits.get(static_cast<size_t>((hashes[j] + i * step) % m_bitCount));
+			}
+			results[offset + j] = isFound;
+		}
+	});
+}
+
+BloomFilter& BloomFilter::operator|=(const BloomFilter& other) {
+	assert(m_bitCount == other.m_bitCount && m_hashCount == other.m_hashCount);
+	m_bits |= other.m_bits;
+	return *this;
+}
+
+namespace {
+
+/// @brief Position of the probe `index` inside a block. Takes the top 9 bits of a linear
+/// combination of the low and high halves of the hash
+size_t blockProbe(uint64_t hash, unsigned index) {
+	const uint32_t low = static_cast<uint32_t>(hash);
+	const uint32_t step = static_cast<uint32_t>(hash >> 32) | 1;
+	return static_cast<uint32_t>(low + index * step) >> 23;
+}
+
+/// @brief Map the hash to a block with a multiply-shift instead of a slow division
+size_t blockIndex(uint64_t hash, size_t blockCount) {
+	const uint64_t mixed = mixHash(hash);
+	return static_cast<size_t>(((mixed >> 32) * blockCount) >> 32);
+}
+
+} // namespace
+
+BlockedBloomFilter::BlockedBloomFilter(size_t bitCount, unsigned hashCount):
+	m_blockCount((bitCount + blockBits - 1) / blockBits),
+	m_hashCount(hashCount)
+{
+	assert(bitCount > 0 && hashCount > 0);
+	// The multiply-shift mapping only supports 32-bit block indices
+	assert(m_blockCount <= UINT32_MAX);
+	m_blocks.resize(m_blockCount * blockBytes);
+}
+
+BlockedBloomFilter BlockedBloomFilter::forCapacity(size_t expectedCount, double falsePositiveRate) {
+	const size_t bitCount = BloomFilterSizing::optimalBitCount(expectedCount, falsePositiveRate);
+	return {bitCount, BloomFilterSizing::optimalHashCount(bitCount, expectedCount)};
+}
+
+void BlockedBloomFilter::insert(uint64_t key) {
+	insertHashed(mixHash(key));
+}
+
+void BlockedBloomFilter::insertHashed(uint64_t hash) {
+	uint8_t* block = m_blocks.data() + blockIndex(hash, m_blockCount) * blockBytes;
+	for (unsigned i = 0; i < m_hashCount; ++i) {
+		const size_t probe = blockProbe(hash, i);
+		block[probe / 8] |= static_cast<uint8_t>(1u << (probe % 8));
+	}
+}
+
+bool BlockedBloomFilter::mayContain(uint64_t key) const {
+	return mayContainHashed(mixHash(key));
+}
+
+bool BlockedBloomFilter::mayContainHashed(uint64_t hash) const {
+	// Build the pattern of the probes first, then compare it with the whole block at once
+	uint8_t mask[blockBytes] = {};
+	for (unsigned i = 0; i < m_hashCount; ++i) {
+		const size_t probe = blockProbe(hash, i);
+		mask[probe / 8] |= static_cast<uint8_t>(1u << (probe % 8));
+	}
+
+	const uint8_t* block = m_blocks.data() + blockIndex(hash, m_blockCount) * blockBytes;
+	uint8_t missing = 0;
+	for (size_t i = 0; i < blockBytes; ++i) {
+		missing |= static_cast<uint8_t>(mask[i] & ~block[i]);
+	}
+	return missing == 0;
+}
+
+void BlockedBloomFilter::insert(ArrayView<const uint64_t> keys) {
+	forEachHashBatch(keys, [this](size_t, ArrayView<const uint64_t> hashes) {
+		for (uint64_t hash : hashes) {
+			insertHashed(hash);
+		}
+	});
+}
+
+void BlockedBloomFilter::mayContain(ArrayView<const uint64_t> keys, ArrayView<bool> results) const {
+	assert(results.size() == keys.size());
+	forEachHashBatch(keys, [this, results](size_t offset, ArrayView<const uint64_t> hashes) {
+		for (size_t j = 0; j < hashes.size(); ++j) {
+			results[offset + j] = mayContainHashed(hashes[j]);
+		}
+	});
+}
+
+BlockedBloomFilter& BlockedBloomFilter::operator|=(const BlockedBloomFilter& other) {
+	assert(m_blockCount == other.m_blockCount && m_hashCount == other.m_hashCount);
+	for (size_t i = 0; i < m_blocks.size(); ++i) {
+		m_blocks[i] |= other.m_blocks[i];
+	}
+	return *this;
+}
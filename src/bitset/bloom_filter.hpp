@@ -0,0 +1,117 @@
+#ifndef BLOOM_FILTER_HPP_INCLUDED
+#define BLOOM_FILTER_HPP_INCLUDED
+
+#include <cstddef>
+#include <cstdint>
+
+#include <vector>
+
+#include "array_view/array_view.hpp"
+#include "bitset/aligned_allocator.hpp"
+#include "bitset/bitset.hpp"
+
+/// @brief Sizing formulas shared by `BloomFilter` and `BlockedBloomFilter`
+struct BloomFilterSizing {
+	/// @brief Number of bits needed to store `expectedCount` keys with the given false positive
+	/// rate, assuming the optimal number of hash functions: `-n * ln(p) / ln(2)^2`
+	/// @pre `0 < falsePositiveRate < 1`
+	static size_t optimalBitCount(size_t expectedCount, double falsePositiveRate);
+
+	/// @brief Number of hash functions that minimizes the false positive rate: `m / n * ln(2)`
+	static unsigned optimalHashCount(size_t bitCount, size_t expectedCount);
+
+	/// @brief Expected false positive rate after inserting `count` keys: `(1 - e^(-kn/m))^k`
+	static double falsePositiveRate(size_t bitCount, size_t count, unsigned hashCount);
+};
+
+/// @brief An approximate set of 64-bit keys. `mayContain()` never gives false negatives, but
+/// gives false positives with a probability that depends on the size of the filter.
+/// The bits are stored in a `BitSet`, so filters of the same shape can be merged with `|`
+///
+/// Hash the keys with `std::hash` or any other hash function to store other types of keys.
+/// The keys are mixed again internally, so a weak hash function is fine
+class BloomFilter {
+public:
+	/// @pre `bitCount > 0` and `hashCount > 0`
+	BloomFilter(size_t bitCount, unsigned hashCount);
+
+	/// @brief Create a filter sized for `expectedCount` keys at the given false positive rate
+	static BloomFilter forCapacity(size_t expectedCount, double falsePositiveRate);
+
+	size_t bitCount() const { return m_bitCount; }
+	unsigned hashCount() const { return m_hashCount; }
+	const BitSet& bits() const { return m_bits; }
+
+	void insert(uint64_t key);
+	bool mayContain(uint64_t key) const;
+
+	/// @brief Insert many keys at once. The hashes of a batch of keys are computed in a separate
+	/// loop that the compiler can vectorize
+	void insert(ArrayView<const uint64_t> keys);
+	/// @brief Check many keys at once: `results[i] = mayContain(keys[i])`
+	/// @pre `results.size() == keys.size()`
+	void mayContain(ArrayView<const uint64_t> keys, ArrayView<bool> results) const;
+
+	/// @brief Add all of the keys of `other` to this filter
+	/// @pre Both filters have the same `bitCount()` and `hashCount()`
+	BloomFilter& operator|=(const BloomFilter& other);
+	friend BloomFilter operator|(BloomFilter a, const BloomFilter& b) {
+		return a |= b;
+	}
+
+private:
+	BitSet m_bits;
+	size_t m_bitCount;
+	unsigned m_hashCount;
+};
+
+/// @brief A Bloom filter that maps every key to a single 64-byte block and places all of its
+/// probes inside of it. Every operation touches one cache line instead of `hashCount()` random
+/// ones, at the cost of a somewhat higher false positive rate for the same number of bits.
+/// The blocks are stored in an array aligned to 64 bytes, so every block is a cache line
+class BlockedBloomFilter {
+public:
+	static constexpr size_t blockBits = 512;
+	static constexpr size_t blockBytes = blockBits / 8;
+
+	/// @pre `bitCount > 0` and `hashCount > 0`. `bitCount` is rounded up to a whole block
+	BlockedBloomFilter(size_t bitCount, unsigned hashCount);
+
+	/// @brief Create a filter sized for `expectedCount` keys at the given false positive rate
+	static BlockedBloomFilter forCapacity(size_t expectedCount, double falsePositiveRate);
+
+	size_t bitCount() const { return m_blockCount * blockBits; }
+	unsigned hashCount() const { return m_hashCount; }
+	/// @brief A copy of the bits of all of the blocks, in the layout of `BitSet`
+	BitSet bits() const { return BitSet::fromBytes({m_blocks.data(), m_blocks.size()}); }
+
+	void insert(uint64_t key);
+	bool mayContain(uint64_t key) const;
+
+	/// @brief Insert many keys at once
+	void insert(ArrayView<const uint64_t> keys);
+	/// @brief Check many keys at once: `results[i] = mayContain(keys[i])`.
+	/// Every check is a branch-free comparison of a 64-byte mask with the block, which the
+	/// compiler turns into a few SIMD instructions
+	/// @pre `results.size() == keys.size()`
+	void mayContain(ArrayView<const uint64_t> keys, ArrayView<bool> results) const;
+
+	/// @brief Add all of the keys of `other` to this filter
+	/// @pre Both filters have the same `bitCount()` and `hashCount()`
+	BlockedBloomFilter& operator|=(const BlockedBloomFilter& other);
+	friend BlockedBloomFilter operator|(BlockedBloomFilter a, const BlockedBloomFilter& b) {
+		return a |= b;
+	}
+
+private:
+	bool mayContainHashed(uint64_t hash) const;
+	void insertHashed(uint64_t hash);
+
+	/// @brief The bytes of the blocks, the bit `pos` of a block in the bit `pos % 8` of its byte
+	/// `pos / 8` as in `BitSet`
+	std::vector<uint8_t, AlignedAllocator<uint8_t, 64>> m_blocks;
+	size_t m_blockCount;
+	unsigned m_hashCount;
+};
+
+#endif
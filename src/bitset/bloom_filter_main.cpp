@@ -0,0 +1,88 @@
+#include <chrono>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <vector>
+
+#include "bitset/bloom_filter.hpp"
+
+/// @brief Insert `keys`, then check that all of them are found and measure the false positive rate
+/// on `absentKeys`
+template<typename Filter>
+static void testFilter(const char* name, Filter filter, const std::vector<uint64_t>& keys,
+	const std::vector<uint64_t>& absentKeys
+) {
+	using Milliseconds = std::chrono::duration<double, std::milli>;
+
+	const auto insertStart = std::chrono::steady_clock::now();
+	filter.insert({keys.begin(), keys.end()});
+	const auto insertEnd = std::chrono::steady_clock::now();
+
+	// std::vector<bool> is a bitset that can't provide a contiguous array of `bool`
+	std::unique_ptr<bool[]> results(new bool[absentKeys.size()]);
+	const auto queryStart = std::chrono::steady_clock::now();
+	filter.mayContain({absentKeys.begin(), absentKeys.end()}, {results.get(), absentKeys.size()});
+	const auto queryEnd = std::chrono::steady_clock::now();
+
+	size_t falsePositives = 0;
+	for (size_t i = 0; i < absentKeys.size(); ++i) {
+		falsePositives += results[i];
+	}
+
+	bool hasFalseNegatives = false;
+	for (uint64_t key : keys) {
+		hasFalseNegatives = hasFalseNegatives || !filter.mayContain(key);
+	}
+
+	std::cout << name << ": " << filter.bitCount() << " bits, " << filter.hashCount()
+		<< " hashes\n";
+	std::cout << "  False negatives: " << (hasFalseNegatives ? "yes (bug!)" : "none") << '\n';
+	std::cout << "  False positive rate: "
+		<< static_cast<double>(falsePositives) / static_cast<double>(absentKeys.size())
+		<< " (expected "
+		<< BloomFilterSizing::falsePositiveRate(filter.bitCount(), keys.size(), filter.hashCount())
+		<< " for a classic filter)\n";
+	std::cout << "  Batch insert: " << Milliseconds(insertEnd - insertStart).count() << " ms, "
+		<< "batch query: " << Milliseconds(queryEnd - queryStart).count() << " ms\n";
+}
+
+int main() {
+	constexpr size_t keyCount = 1'000'000;
+	constexpr double falsePositiveRate = 0.01;
+
+	std::mt19937_64 random(123);
+	std::vector<uint64_t> keys(keyCount);
+	for (uint64_t& key : keys) {
+		key = random();
+	}
+	// The inserted keys have the top bit cleared and the absent ones have it set
+	std::vector<uint64_t> absentKeys(keyCount);
+	for (uint64_t& key : absentKeys) {
+		key = random() | (uint64_t{1} << 63);
+	}
+	for (uint64_t& key : keys) {
+		key &= ~(uint64_t{1} << 63);
+	}
+
+	std::cout << "Target false positive rate: " << falsePositiveRate << " for " << keyCount
+		<< " keys\n";
+	std::cout << "Optimal size: "
+		<< BloomFilterSizing::optimalBitCount(keyCount, falsePositiveRate) << " bits\n\n";
+
+	testFilter("BloomFilter", BloomFilter::forCapacity(keyCount, falsePositiveRate),
+		keys, absentKeys);
+	testFilter("BlockedBloomFilter", BlockedBloomFilter::forCapacity(keyCount, falsePositiveRate),
+		keys, absentKeys);
+
+	std::cout << "\nTesting union:\n";
+	BloomFilter a(1 << 16, 5);
+	BloomFilter b(1 << 16, 5);
+	a.insert(1);
+	a.insert(2);
+	b.insert(3);
+	const BloomFilter merged = a | b;
+	std::cout << std::boolalpha;
+	std::cout << "(a | b).mayContain(1) -> " << merged.mayContain(1) << '\n';
+	std::cout << "(a | b).mayContain(3) -> " << merged.mayContain(3) << '\n';
+	std::cout << "(a | b).mayContain(4) -> " << merged.mayContain(4) << '\n';
+}
@@ -0,0 +1,268 @@
+#include "bitset/ewah_bitmap.hpp"
+
+#include <algorithm>
+
+/// @brief Walk over two compressed streams in lockstep, combining them word by word with `op`
+/// and feeding the result into `sink`. Pairs of runs are combined in O(1), so are runs that
+/// dominate the other operand (e.g. a run of zeros in an intersection)
+template<typename WordOp, typename Sink>
+void mergeRuns(const EwahBitmap& a, const EwahBitmap& b, WordOp op, Sink& sink) {
+	constexpr uint64_t zeros = 0;
+	constexpr uint64_t ones = ~uint64_t{0};
+
+	EwahBitmap::RunCursor cursorA(a.m_words);
+	EwahBitmap::RunCursor cursorB(b.m_words);
+	while (!cursorA.isDone() || !cursorB.isDone()) {
+		if (cursorA.isRun() && cursorB.isRun()) {
+			const uint64_t count = std::min(cursorA.runLeft(), cursorB.runLeft());
+			const uint64_t fillA = cursorA.runBit() ? ones : zeros;
+			const uint64_t fillB = cursorB.runBit() ? ones : zeros;
+			sink.appendRun(op(fillA, fillB) != 0, count);
+			cursorA.skipRun(count);
+			cursorB.skipRun(count);
+			continue;
+		}
+
+		if (cursorA.isRun() || cursorB.isRun()) {
+			// One side is a run, the other one is a sequence of dirty words
+			const bool isRunA = cursorA.isRun();
+			EwahBitmap::RunCursor& run = isRunA ? cursorA : cursorB;
+			EwahBitmap::RunCursor& dirty = isRunA ? cursorB : cursorA;
+			const uint64_t count = std::min(run.runLeft(), dirty.dirtyLeft());
+			const uint64_t fill = run.runBit() ? ones : zeros;
+
+			const uint64_t withZeros = isRunA ? op(fill, zeros) : op(zeros, fill);
+			const uint64_t withOnes = isRunA ? op(fill, ones) : op(ones, fill);
+			if (withZeros == withOnes) {
+				// The run decides the result regardless of the dirty words
+				sink.appendRun(withZeros != 0, count);
+				dirty.skipDirty(count);
+			}
+			else {
+				for (uint64_t i = 0; i < count; ++i) {
+					const uint64_t word = dirty.dirtyWord();
+					sink.appendWord(isRunA ? op(fill, word) : op(word, fill));
+					dirty.skipDirty(1);
+				}
+			}
+			run.skipRun(count);
+			continue;
+		}
+
+		const uint64_t count = std::min(cursorA.dirtyLeft(), cursorB.dirtyLeft());
+		for (uint64_t i = 0; i < count; ++i) {
+			sink.appendWord(op(cursorA.dirtyWord(), cursorB.dirtyWord()));
+			cursorA.skipDirty(1);
+			cursorB.skipDirty(1);
+		}
+	}
+}
+
+namespace {
+
+/// @brief A sink for `mergeRuns` that only checks whether the result is empty
+struct EmptinessSink {
+	bool isEmpty = true;
+
+	void appendRun(bool bit, uint64_t) {
+		isEmpty = isEmpty && !bit;
+	}
+
+	void appendWord(uint64_t word) {
+		isEmpty = isEmpty && word == 0;
+	}
+};
+
+} // namespace
+
+void EwahBitmap::appendRun(bool bit, uint64_t count) {
+	while (count != 0) {
+		if (!m_words.empty()) {
+			uint64_t& marker = lastMarker();
+			const uint64_t runLength = (marker >> 1) & maxRunLength;
+			const bool hasDirtyWords = (marker >> 33) != 0;
+			const bool canExtend = runLength == 0 || (marker & 1) == bit;
+			if (!hasDirtyWords && canExtend && runLength < maxRunLength) {
+				const uint64_t added = std::min(count, maxRunLength - runLength);
+				marker = ((runLength + added) << 1) | uint64_t{bit};
+				count -= added;
+				continue;
+			}
+		}
+
+		m_lastMarker = m_words.size();
+		m_words.push_back(0);
+	}
+}
+
+void EwahBitmap::appendWord(uint64_t word) {
+	if (word == 0 || word == ~uint64_t{0}) {
+		appendRun(word != 0, 1);
+		return;
+	}
+
+	if (m_words.empty() || (lastMarker() >> 33) == maxDirtyCount) {
+		m_lastMarker = m_words.size();
+		m_words.push_back(0);
+	}
+	lastMarker() += uint64_t{1} << 33;
+	m_words.push_back(word);
+}
+
+EwahBitmap EwahBitmap::fromBitSet(const BitSet& bitset) {
+	EwahBitmap result;
+	const ArrayView<const uint8_t> bytes = bitset.bytes();
+	for (size_t offset = 0; offset < bytes.size(); offset += 8) {
+		// Assemble the word byte by byte so that the result doesn't depend on the host endianness
+		uint64_t word = 0;
+		const size_t count = std::min<size_t>(8, bytes.size() - offset);
+		for (size_t i = 0; i < count; ++i) {
+			word |= uint64_t{bytes[offset + i]} << (8 * i);
+		}
+		result.appendWord(word);
+	}
+	return result;
+}
+
+BitSet EwahBitmap::toBitSet() const {
+	std::vector<uint8_t> bytes;
+	const auto appendBytes = [&bytes](uint64_t word) {
+		for (size_t i = 0; i < 8; ++i) {
+			bytes.push_back(static_cast<uint8_t>(word >> (8 * i)));
+		}
+	};
+
+	RunCursor cursor(m_words);
+	while (!cursor.isDone()) {
+		if (cursor.isRun()) {
+			const uint64_t count = cursor.runLeft();
+			bytes.insert(bytes.end(), static_cast<size_t>(count * 8),
+				cursor.runBit() ? uint8_t{0xff} : uint8_t{0});
+			cursor.skipRun(count);
+		}
+		else {
+			appendBytes(cursor.dirtyWord());
+			cursor.skipDirty(1);
+		}
+	}
+	return BitSet::fromBytes({bytes.begin(), bytes.end()});
+}
+
+size_t EwahBitmap::count() const {
+	size_t result = 0;
+	RunCursor cursor(m_words);
+	while (!cursor.isDone()) {
+		if (cursor.isRun()) {
+			const uint64_t count = cursor.runLeft();
+			result += cursor.runBit() ? static_cast<size_t>(count * 64) : 0;
+			cursor.skipRun(count);
+		}
+		else {
+			result += static_cast<size_t>(std::popcount(cursor.dirtyWord()));
+			cursor.skipDirty(1);
+		}
+	}
+	return result;
+}
+
+bool operator==(const EwahBitmap& a, const EwahBitmap& b) {
+	// Trailing runs of zeros don't change the set, so the streams can't be compared directly
+	EmptinessSink sink;
+	mergeRuns(a, b, [](uint64_t x, uint64_t y) { return x ^ y; }, sink);
+	return sink.isEmpty;
+}
+
+EwahBitmap operator|(const EwahBitmap& a, const EwahBitmap& b) {
+	EwahBitmap result;
+	mergeRuns(a, b, [](uint64_t x, uint64_t y) { return x | y; }, result);
+	return result;
+}
+
+EwahBitmap operator&(const EwahBitmap& a, const EwahBitmap& b) {
+	EwahBitmap result;
+	mergeRuns(a, b, [](uint64_t x, uint64_t y) { return x & y; }, result);
+	return result;
+}
+
+EwahBitmap operator^(const EwahBitmap& a, const EwahBitmap& b) {
+	EwahBitmap result;
+	mergeRuns(a, b, [](uint64_t x, uint64_t y) { return x ^ y; }, result);
+	return result;
+}
+
+std::ostream& operator<<(std::ostream& output, const EwahBitmap& bitmap) {
+	output << "{";
+	bool isFirstElement = true;
+	for (size_t value : bitmap) {
+		if (!isFirstElement) {
+			output << ", ";
+		}
+		isFirstElement = false;
+		output << value;
+	}
+	output << "}";
+	return output;
+}
+
+void EwahBitmap::writeBinary(std::ostream& output) const {
+	uint64_t count = m_words.size();
+	do {
+		const uint8_t byte = static_cast<uint8_t>((count & 0x7f) | (count > 0x7f ? 0x80 : 0));
+		output.put(static_cast<char>(byte));
+		count >>= 7;
+	} while (count != 0);
+
+	for (uint64_t word : m_words) {
+		char bytes[8];
+		for (size_t i = 0; i < 8; ++i) {
+			bytes[i] = static_cast<char>(static_cast<uint8_t>(word >> (8 * i)));
+		}
+		output.write(bytes, 8);
+	}
+}
+
+EwahBitmap EwahBitmap::readBinary(std::istream& input) {
+	EwahBitmap result;
+
+	uint64_t count = 0;
+	for (int shift = 0; ; shift += 7) {
+		const int byte = input.get();
+		if (byte == std::istream::traits_type::eof() || shift > 63) {
+			input.setstate(std::ios::failbit);
+			return {};
+		}
+		count |= uint64_t(byte & 0x7f) << shift;
+		if ((byte & 0x80) == 0) {
+			break;
+		}
+	}
+
+	// Don't trust the count blindly, the vector grows as the words are actually read
+	uint64_t dirtyLeft = 0;
+	for (uint64_t i = 0; i < count; ++i) {
+		char bytes[8];
+		if (!input.read(bytes, 8)) {
+			return {};
+		}
+		uint64_t word = 0;
+		for (size_t j = 0; j < 8; ++j) {
+			word |= uint64_t{static_cast<uint8_t>(bytes[j])} << (8 * j);
+		}
+
+		if (dirtyLeft == 0) {
+			result.m_lastMarker = result.m_words.size();
+			dirtyLeft = word >> 33;
+		}
+		else {
+			--dirtyLeft;
+		}
+		result.m_words.push_back(word);
+	}
+
+	if (dirtyLeft != 0) {
+		// The last marker announces more dirty words than there are in the stream
+		input.setstate(std::ios::failbit);
+		return {};
+	}
+	return result;
+}
@@ -0,0 +1,230 @@
+#ifndef EWAH_BITMAP_HPP_INCLUDED
+#define EWAH_BITMAP_HPP_INCLUDED
+
+#include <cstddef>
+#include <cstdint>
+
+#include <bit>
+#include <iterator>
+#include <istream>
+#include <ostream>
+#include <vector>
+
+#include "bitset/bitset.hpp"
+
+/// @brief A set of unsigned numbers stored as an EWAH (Enhanced Word-Aligned Hybrid) compressed
+/// bitmap
+///
+/// The bits are split into 64-bit words. Sequences of words that are all zeros or all ones ("clean"
+/// words) are replaced by a counter, the rest of the words ("dirty" words) are stored verbatim.
+/// The compressed stream is a sequence of marker words, each followed by the dirty words it
+/// announces. A marker word is laid out as follows:
+///   - bit 0: the value of the bits in the clean words;
+///   - bits 1..32: the number of clean words;
+///   - bits 33..63: the number of dirty words that follow the marker.
+///
+/// Set operations, counting and iteration work directly on the compressed stream, so their cost
+/// is proportional to the compressed size rather than to the max element.
+/// @note Well suited for clustered sets with long runs of ones or zeros. Use `BitSet` for
+/// uniformly dense sets, where compression only adds overhead
+class EwahBitmap {
+private:
+	/// @brief Walks over the compressed stream, presenting it as a sequence of clean runs and
+	/// dirty words. When the stream is exhausted, it acts as an infinite run of zeros
+	class RunCursor {
+	public:
+		RunCursor() = default;
+		explicit RunCursor(const std::vector<uint64_t>& words):
+			m_words(words.data()),
+			m_end(words.data() + words.size())
+		{
+			loadMarker();
+		}
+
+		bool isDone() const { return m_runLeft == 0 && m_dirtyLeft == 0 && m_words == m_end; }
+
+		/// @brief Whether the cursor currently points to a clean run
+		bool isRun() const { return m_runLeft != 0 || m_dirtyLeft == 0; }
+		bool runBit() const { return m_runBit; }
+		/// @brief Number of clean words left in the current run
+		uint64_t runLeft() const { return isDone() ? UINT64_MAX : m_runLeft; }
+		/// @brief Number of dirty words left after the current marker
+		uint64_t dirtyLeft() const { return m_dirtyLeft; }
+		uint64_t dirtyWord() const { return *m_words; }
+
+		void skipRun(uint64_t count) {
+			if (isDone()) {
+				return;
+			}
+			m_runLeft -= count;
+			if (m_runLeft == 0 && m_dirtyLeft == 0) {
+				loadMarker();
+			}
+		}
+
+		void skipDirty(uint64_t count) {
+			m_words += count;
+			m_dirtyLeft -= count;
+			if (m_dirtyLeft == 0) {
+				loadMarker();
+			}
+		}
+
+	private:
+		void loadMarker() {
+			// Skip empty markers so that the cursor never stops on an empty run
+			while (m_runLeft == 0 && m_dirtyLeft == 0 && m_words != m_end) {
+				const uint64_t marker = *m_words++;
+				m_runBit = marker & 1;
+				m_runLeft = (marker >> 1) & maxRunLength;
+				m_dirtyLeft = marker >> 33;
+			}
+			if (isDone()) {
+				m_runBit = false;
+			}
+		}
+
+		const uint64_t* m_words = nullptr;
+		const uint64_t* m_end = nullptr;
+		bool m_runBit = false;
+		uint64_t m_runLeft = 0;
+		uint64_t m_dirtyLeft = 0;
+	};
+
+public:
+	static constexpr uint64_t maxRunLength = (uint64_t{1} << 32) - 1;
+	static constexpr uint64_t maxDirtyCount = (uint64_t{1} << 31) - 1;
+
+	/// @brief Iterates over the elements of the set in ascending order
+	class ConstIterator {
+	public:
+		using iterator_category = std::forward_iterator_tag;
+		using value_type = size_t;
+		using pointer = const size_t*;
+		using reference = size_t;
+		using difference_type = std::ptrdiff_t;
+
+		ConstIterator() = default;
+
+		reference operator*() const {
+			const uint64_t bitIndex = static_cast<uint64_t>(std::countr_zero(m_bits));
+			return static_cast<size_t>(m_wordIndex * 64 + bitIndex);
+		}
+
+		ConstIterator& operator++() {
+			m_bits &= m_bits - 1;
+			advance();
+			return *this;
+		}
+
+		ConstIterator operator++(int) {
+			ConstIterator tmp = *this;
+			++*this;
+			return tmp;
+		}
+
+		friend bool operator==(const ConstIterator& a, const ConstIterator& b) {
+			return a.m_bits == b.m_bits && (a.m_bits == 0 || a.m_wordIndex == b.m_wordIndex);
+		}
+
+		friend bool operator!=(const ConstIterator& a, const ConstIterator& b) {
+			return !(a == b);
+		}
+
+	private:
+		explicit ConstIterator(const std::vector<uint64_t>& words): m_cursor(words) {
+			advance();
+		}
+
+		/// @brief Find the next non-zero word, jumping over the runs of zeros
+		void advance() {
+			while (m_bits == 0 && !m_cursor.isDone()) {
+				m_wordIndex = m_nextWordIndex;
+				if (m_cursor.isRun()) {
+					if (m_cursor.runBit()) {
+						m_bits = ~uint64_t{0};
+						m_cursor.skipRun(1);
+						++m_nextWordIndex;
+					}
+					else {
+						m_nextWordIndex += m_cursor.runLeft();
+						m_cursor.skipRun(m_cursor.runLeft());
+					}
+				}
+				else {
+					m_bits = m_cursor.dirtyWord();
+					m_cursor.skipDirty(1);
+					++m_nextWordIndex;
+				}
+			}
+		}
+
+		RunCursor m_cursor;
+		uint64_t m_bits = 0;
+		uint64_t m_wordIndex = 0;
+		uint64_t m_nextWordIndex = 0;
+
+		friend class EwahBitmap;
+	};
+
+	/// All of the special member functions are implicitly generated
+
+	/// @brief Compress the contents of a `BitSet`
+	static EwahBitmap fromBitSet(const BitSet& bitset);
+
+	/// @brief Decompress into a `BitSet`
+	BitSet toBitSet() const;
+
+	/// @brief Get the number of elements in the set
+	size_t count() const;
+
+	/// @brief Get the size of the compressed stream in bytes
+	size_t sizeBytes() const {
+		return m_words.size() * sizeof(uint64_t);
+	}
+
+	ConstIterator begin() const { return ConstIterator(m_words); }
+	ConstIterator end() const { return ConstIterator(); }
+
+	friend bool operator==(const EwahBitmap& a, const EwahBitmap& b);
+	friend bool operator!=(const EwahBitmap& a, const EwahBitmap& b) {
+		return !(a == b);
+	}
+
+	/// @brief Construct a union of two sets
+	friend EwahBitmap operator|(const EwahBitmap& a, const EwahBitmap& b);
+	/// @brief Construct an intersection of two sets
+	friend EwahBitmap operator&(const EwahBitmap& a, const EwahBitmap& b);
+	/// @brief Construct a symmetric difference of two sets
+	friend EwahBitmap operator^(const EwahBitmap& a, const EwahBitmap& b);
+
+	/// @brief Write to the stream `output` in the format of `{value1, value2, ..., valueN}`
+	friend std::ostream& operator<<(std::ostream& output, const EwahBitmap& bitmap);
+
+	/// @brief Write the compressed stream to a binary stream: the number of words as
+	/// a LEB128 varint followed by the words in little-endian byte order
+	void writeBinary(std::ostream& output) const;
+
+	/// @brief Read the format produced by `writeBinary()`. Sets `failbit` on the stream if
+	/// the data is truncated or malformed
+	static EwahBitmap readBinary(std::istream& input);
+
+	/// @brief Append `count` clean words with all the bits equal to `bit`
+	void appendRun(bool bit, uint64_t count);
+	/// @brief Append an arbitrary word. Clean words are turned into runs automatically
+	void appendWord(uint64_t word);
+
+private:
+	uint64_t& lastMarker() {
+		return m_words[m_lastMarker];
+	}
+
+	std::vector<uint64_t> m_words;
+	/// Index of the marker word that new runs and dirty words are added to
+	size_t m_lastMarker = 0;
+
+	template<typename WordOp, typename Sink>
+	friend void mergeRuns(const EwahBitmap& a, const EwahBitmap& b, WordOp op, Sink& sink);
+};
+
+#endif
@@ -0,0 +1,63 @@
+#include <iostream>
+#include <sstream>
+
+#include "bitset/bitset.hpp"
+#include "bitset/ewah_bitmap.hpp"
+
+int main() {
+	// Clustered sets: a few long runs of ones and some scattered elements
+	BitSet a;
+	for (size_t i = 1000; i < 5000; ++i) {
+		a.set(i);
+	}
+	a.set(3);
+	a.set(70000);
+
+	BitSet b;
+	for (size_t i = 4500; i < 9000; ++i) {
+		b.set(i);
+	}
+	b.set(3);
+	b.set(65);
+
+	const EwahBitmap ewahA = EwahBitmap::fromBitSet(a);
+	const EwahBitmap ewahB = EwahBitmap::fromBitSet(b);
+
+	std::cout << std::boolalpha;
+	std::cout << "a: " << a.bytes().size() << " bytes as BitSet, "
+		<< ewahA.sizeBytes() << " bytes as EwahBitmap, " << ewahA.count() << " elements\n";
+	std::cout << "b: " << b.bytes().size() << " bytes as BitSet, "
+		<< ewahB.sizeBytes() << " bytes as EwahBitmap, " << ewahB.count() << " elements\n";
+	std::cout << "Round trip a == toBitSet(fromBitSet(a)) -> " << (ewahA.toBitSet() == a) << '\n';
+
+	std::cout << "\nTesting set operations on the compressed representation:\n";
+	std::cout << "(a | b) matches BitSet -> " << ((ewahA | ewahB).toBitSet() == (a | b)) << '\n';
+	std::cout << "(a & b) matches BitSet -> " << ((ewahA & ewahB).toBitSet() == (a & b)) << '\n';
+	std::cout << "(a ^ b) matches BitSet -> " << ((ewahA ^ ewahB).toBitSet() == (a ^ b)) << '\n';
+	std::cout << "(a & b).count() -> " << (ewahA & ewahB).count() << '\n';
+
+	std::cout << "\nTesting comparison operators:\n";
+	std::cout << "a == b -> " << (ewahA == ewahB) << '\n';
+	std::cout << "a == a -> " << (ewahA == ewahA) << '\n';
+	std::cout << "(a ^ b) ^ b == a -> " << (((ewahA ^ ewahB) ^ ewahB) == ewahA) << '\n';
+
+	std::cout << "\nTesting iteration:\n";
+	BitSet small;
+	small.set(1);
+	small.set(64);
+	small.set(65);
+	small.set(1000);
+	std::cout << "EwahBitmap -> " << EwahBitmap::fromBitSet(small) << '\n';
+	std::cout << "BitSet     -> " << small << '\n';
+
+	std::cout << "\nTesting binary serialization:\n";
+	std::stringstream stream;
+	ewahA.writeBinary(stream);
+	std::cout << "Serialized size of a: " << stream.str().size() << " bytes\n";
+	const EwahBitmap loaded = EwahBitmap::readBinary(stream);
+	std::cout << "Loaded == a -> " << (!stream.fail() && loaded == ewahA) << '\n';
+
+	std::stringstream truncated(stream.str().substr(0, 5));
+	EwahBitmap::readBinary(truncated);
+	std::cout << "Truncated stream fails -> " << truncated.fail() << '\n';
+}
@@ -0,0 +1,16 @@
+#ifndef MIX_HASH_HPP_INCLUDED
+#define MIX_HASH_HPP_INCLUDED
+
+#include <cstdint>
+
+/// @brief The finalizer of MurmurHash3. Spreads every bit of the key over the whole hash
+inline uint64_t mixHash(uint64_t key) {
+	key ^= key >> 33;
+	key *= 0xff51afd7ed558ccd;
+	key ^= key >> 33;
+	key *= 0xc4ceb9fe1a85ec53;
+	key ^= key >> 33;
+	return key;
+}
+
+#endif
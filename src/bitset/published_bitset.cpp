@@ -0,0 +1,91 @@
+#include "bitset/published_bitset.hpp"
+
+#include <cassert>
+
+#include <algorithm>
+#include <stdexcept>
+
+PublishedBitSet::Reader::~Reader() {
+	if (m_owner) {
+		std::lock_guard lock(m_owner->m_writerMutex);
+		m_slot->isRegistered = false;
+	}
+}
+
+PublishedBitSet::Snapshot PublishedBitSet::Reader::read() {
+	assert(m_slot->epoch.load(std::memory_order_relaxed) == 0);
+
+	// Announce the epoch before loading the pointer. Both are sequentially consistent, pairing
+	// with the exchange and the scan in the writer: if the writer's scan misses this slot, this
+	// load comes after the exchange and sees the new version
+	m_slot->epoch.store(m_owner->m_epoch.load());
+	return {m_slot, m_owner->m_current.load()};
+}
+
+PublishedBitSet::PublishedBitSet(BitSet initial, size_t maxReaders):
+	m_current(new BitSet(std::move(initial))),
+	m_slots(new ReaderSlot[maxReaders]),
+	m_slotCount(maxReaders)
+{ }
+
+PublishedBitSet::~PublishedBitSet() {
+	delete m_current.load();
+}
+
+PublishedBitSet::Reader PublishedBitSet::registerReader() {
+	std::lock_guard lock(m_writerMutex);
+	for (size_t i = 0; i < m_slotCount; ++i) {
+		if (!m_slots[i].isRegistered) {
+			m_slots[i].isRegistered = true;
+			return {*this, m_slots[i]};
+		}
+	}
+	throw std::runtime_error("PublishedBitSet: too many readers");
+}
+
+void PublishedBitSet::publish(BitSet set) {
+	std::lock_guard lock(m_writerMutex);
+	publishLocked(std::move(set));
+}
+
+void PublishedBitSet::publishLocked(BitSet set) {
+	// Allocate before the swap, so that a failed allocation leaves everything as it was
+	m_retired.reserve(m_retired.size() + 1);
+	std::unique_ptr<const BitSet> next(new BitSet(std::move(set)));
+
+	const BitSet* previous = m_current.exchange(next.release());
+	// Readers that may have loaded `previous` announced an epoch before this increment
+	const uint64_t epoch = m_epoch.fetch_add(1) + 1;
+	m_retired.push_back({std::unique_ptr<const BitSet>(previous), epoch});
+
+	reclaimLocked();
+}
+
+void PublishedBitSet::reclaim() {
+	std::lock_guard lock(m_writerMutex);
+	reclaimLocked();
+}
+
+void PublishedBitSet::reclaimLocked() {
+	if (m_retired.empty()) {
+		return;
+	}
+
+	uint64_t oldestEpoch = UINT64_MAX;
+	for (size_t i = 0; i < m_slotCount; ++i) {
+		const uint64_t epoch = m_slots[i].epoch.load();
+		if (epoch != 0) {
+			oldestEpoch = std::min(oldestEpoch, epoch);
+		}
+	}
+
+	// A version retired in epoch `E` is still visible to the readers that entered before `E`
+	std::erase_if(m_retired, [oldestEpoch](const RetiredVersion& version) {
+		return version.epoch <= oldestEpoch;
+	});
+}
+
+size_t PublishedBitSet::retiredCount() const {
+	std::lock_guard lock(m_writerMutex);
+	return m_retired.size();
+}
@@ -0,0 +1,156 @@
+#ifndef PUBLISHED_BITSET_HPP_INCLUDED
+#define PUBLISHED_BITSET_HPP_INCLUDED
+
+#include <cstddef>
+#include <cstdint>
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "bitset/bitset.hpp"
+
+/// @brief A `BitSet` for read-mostly concurrent use. Readers query an immutable snapshot without
+/// taking any locks or touching shared counters, a writer builds a new version and publishes it
+/// with a single atomic pointer swap.
+///
+/// The old versions are reclaimed with epoch-based reclamation: every reader announces the global
+/// epoch it entered in, and a version replaced in epoch `E` is freed once no reader is left that
+/// entered before `E`. A reader costs a load and a store to its own cache line per snapshot.
+///
+/// Usage:
+///
+///     PublishedBitSet allowList(initial);
+///     // On every reader thread
+///     PublishedBitSet::Reader reader = allowList.registerReader();
+///     {
+///         PublishedBitSet::Snapshot snapshot = reader.read();
+///         if (snapshot->get(id)) { ... }
+///     }
+///     // On the writer thread
+///     allowList.publish(rebuiltSet);
+class PublishedBitSet {
+	struct ReaderSlot;
+
+public:
+	/// @brief A pinned version of the set. The version stays alive until the snapshot is
+	/// destroyed, even if newer versions are published in the meantime
+	/// @note Keep snapshots short-lived: while one exists, no version replaced after it was taken
+	/// can be freed
+	class Snapshot {
+	public:
+		Snapshot(const Snapshot&) = delete;
+		Snapshot& operator=(const Snapshot&) = delete;
+
+		~Snapshot() {
+			m_slot->epoch.store(0, std::memory_order_release);
+		}
+
+		const BitSet& operator*() const { return *m_set; }
+		const BitSet* operator->() const { return m_set; }
+
+	private:
+		friend class PublishedBitSet;
+
+		Snapshot(ReaderSlot* slot, const BitSet* set): m_slot(slot), m_set(set) { }
+
+		ReaderSlot* m_slot;
+		const BitSet* m_set;
+	};
+
+	/// @brief A registered reader, to be used by one thread at a time. A reader holds at most one
+	/// snapshot at a time
+	class Reader {
+	public:
+		Reader(Reader&& other) noexcept:
+			m_owner(other.m_owner),
+			m_slot(other.m_slot)
+		{
+			other.m_owner = nullptr;
+			other.m_slot = nullptr;
+		}
+		Reader& operator=(Reader&&) = delete;
+
+		~Reader();
+
+		/// @brief Pin the current version of the set
+		/// @pre This reader doesn't hold another snapshot
+		Snapshot read();
+
+	private:
+		friend class PublishedBitSet;
+
+		Reader(PublishedBitSet& owner, ReaderSlot& slot): m_owner(&owner), m_slot(&slot) { }
+
+		PublishedBitSet* m_owner;
+		ReaderSlot* m_slot;
+	};
+
+	/// @param maxReaders The maximum number of readers registered at the same time. The slots are
+	/// allocated up front, so that the writer can scan them without synchronizing with
+	/// the registration
+	explicit PublishedBitSet(BitSet initial = {}, size_t maxReaders = 128);
+
+	PublishedBitSet(const PublishedBitSet&) = delete;
+	PublishedBitSet& operator=(const PublishedBitSet&) = delete;
+
+	/// @pre All the readers have been destroyed
+	~PublishedBitSet();
+
+	/// @brief Register a reader. Takes a lock, so register once per thread rather than per query
+	/// @throws std::runtime_error if `maxReaders` readers are registered already
+	Reader registerReader();
+
+	/// @brief Replace the current version with `set`. Readers that already hold a snapshot keep
+	/// seeing the old version, new snapshots see `set`. Frees the old versions that no reader
+	/// can see anymore
+	void publish(BitSet set);
+
+	/// @brief Publish a modified copy of the current version: `update(copy); publish(copy)`.
+	/// Writers are serialized, so concurrent updates are never lost
+	template<typename Update>
+	void update(Update update) {
+		std::lock_guard lock(m_writerMutex);
+		BitSet copy(*m_current.load(std::memory_order_relaxed));
+		update(copy);
+		publishLocked(std::move(copy));
+	}
+
+	/// @brief Free the old versions that no reader can see anymore. `publish()` does this
+	/// automatically, call it if readers held snapshots for long during the last publications
+	void reclaim();
+
+	/// @brief Number of replaced versions that are still waiting for their readers to leave
+	size_t retiredCount() const;
+
+private:
+	/// @brief The epoch the reader entered in, or 0 if it is outside of any snapshot. Each slot
+	/// has a cache line of its own, so that readers don't invalidate each other's caches
+	struct alignas(64) ReaderSlot {
+		std::atomic<uint64_t> epoch{0};
+		/// @brief Guarded by `m_writerMutex`
+		bool isRegistered = false;
+	};
+
+	struct RetiredVersion {
+		std::unique_ptr<const BitSet> set;
+		/// @brief The global epoch right after the version was replaced
+		uint64_t epoch;
+	};
+
+	void publishLocked(BitSet set);
+	void reclaimLocked();
+
+	std::atomic<const BitSet*> m_current;
+	/// @brief Starts from 1, a reader slot with the epoch 0 is inactive
+	std::atomic<uint64_t> m_epoch{1};
+
+	std::unique_ptr<ReaderSlot[]> m_slots;
+	size_t m_slotCount;
+
+	mutable std::mutex m_writerMutex;
+	std::vector<RetiredVersion> m_retired;
+};
+
+#endif
@@ -0,0 +1,131 @@
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <random>
+#include <shared_mutex>
+#include <thread>
+#include <vector>
+
+#include "bitset/published_bitset.hpp"
+
+namespace {
+
+constexpr size_t universe = size_t{1} << 20;
+
+/// @brief Build the version `version` of the allow-list: every 7th id, shifted by the version.
+/// Every version contains the id 0, which the readers check to catch use-after-free bugs
+BitSet buildAllowList(size_t version) {
+	BitSet result;
+	result.reserve(universe);
+	for (size_t id = version % 7; id < universe; id += 7) {
+		result.set(id);
+	}
+	result.set(0);
+	return result;
+}
+
+struct RunResult {
+	double lookupsPerSecond;
+	size_t versions;
+	bool isConsistent;
+};
+
+/// @brief Run `readerCount` readers doing lookups with `lookup(readerIndex, id)` while the writer
+/// publishes a new version with `publish(version)` every few milliseconds
+template<typename Lookup, typename Publish>
+RunResult run(unsigned readerCount, Lookup lookup, Publish publish) {
+	using Seconds = std::chrono::duration<double>;
+	constexpr auto duration = std::chrono::milliseconds(500);
+
+	std::atomic<bool> isDone{false};
+	std::atomic<bool> isConsistent{true};
+	std::atomic<size_t> totalLookups{0};
+
+	std::vector<std::thread> readers;
+	for (unsigned i = 0; i < readerCount; ++i) {
+		readers.emplace_back([&, i] {
+			std::mt19937_64 random(i);
+			size_t lookups = 0;
+			size_t hits = 0;
+			while (!isDone.load(std::memory_order_relaxed)) {
+				for (int j = 0; j < 256; ++j) {
+					hits += lookup(i, random() % universe);
+				}
+				if (!lookup(i, 0)) {
+					isConsistent = false;
+				}
+				lookups += 257;
+			}
+			totalLookups += lookups;
+			// Keep the hits alive
+			if (hits == SIZE_MAX) {
+				std::cout << hits;
+			}
+		});
+	}
+
+	const auto start = std::chrono::steady_clock::now();
+	size_t version = 1;
+	while (std::chrono::steady_clock::now() - start < duration) {
+		publish(buildAllowList(version++));
+		std::this_thread::sleep_for(std::chrono::milliseconds(5));
+	}
+	isDone = true;
+	for (std::thread& reader : readers) {
+		reader.join();
+	}
+	const double seconds = Seconds(std::chrono::steady_clock::now() - start).count();
+
+	return {static_cast<double>(totalLookups.load()) / seconds, version - 1, isConsistent};
+}
+
+void printResult(const char* name, const RunResult& result) {
+	std::cout << name << ": " << result.lookupsPerSecond / 1e6 << " Mlookups/s, "
+		<< result.versions << " versions published, consistent: "
+		<< (result.isConsistent ? "yes" : "NO") << '\n';
+}
+
+} // namespace
+
+int main() {
+	const unsigned readerCount = std::max(std::thread::hardware_concurrency(), 4u);
+	std::cout << readerCount << " readers, 1 writer\n\n";
+
+	{
+		BitSet current = buildAllowList(0);
+		std::shared_mutex mutex;
+		const RunResult result = run(readerCount,
+			[&](unsigned, size_t id) {
+				std::shared_lock lock(mutex);
+				return current.get(id);
+			},
+			[&](BitSet next) {
+				std::unique_lock lock(mutex);
+				current = std::move(next);
+			});
+		printResult("std::shared_mutex, lock per lookup", result);
+	}
+
+	{
+		PublishedBitSet allowList(buildAllowList(0));
+		std::vector<PublishedBitSet::Reader> readers;
+		readers.reserve(readerCount);
+		for (unsigned i = 0; i < readerCount; ++i) {
+			readers.push_back(allowList.registerReader());
+		}
+
+		const RunResult result = run(readerCount,
+			[&](unsigned reader, size_t id) {
+				const PublishedBitSet::Snapshot snapshot = readers[reader].read();
+				return snapshot->get(id);
+			},
+			[&](BitSet next) {
+				allowList.publish(std::move(next));
+			});
+		printResult("PublishedBitSet, snapshot per lookup", result);
+
+		allowList.reclaim();
+		std::cout << "Versions still waiting for readers after the run: "
+			<< allowList.retiredCount() << '\n';
+	}
+}
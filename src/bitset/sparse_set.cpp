@@ -0,0 +1,332 @@
+#include "bitset/sparse_set.hpp"
+
+#include <cstring>
+
+#include <algorithm>
+#include <bit>
+
+#include "bitset/mix_hash.hpp"
+
+namespace {
+
+/// @brief Number of control bytes probed at once, the bytes of a 64-bit word
+constexpr size_t groupSize = 8;
+
+constexpr uint64_t lowBits = 0x0101010101010101;
+constexpr uint64_t highBits = 0x8080808080808080;
+
+/// @brief The 7 bits of the hash stored in the control byte. The rest of the hash picks the group
+uint8_t controlHash(uint64_t hash) {
+	return static_cast<uint8_t>(hash & 0x7f);
+}
+
+/// @brief Iterates over the slots of a group selected by a mask with the high bit of every
+/// selected byte set
+class GroupMask {
+public:
+	explicit GroupMask(uint64_t mask): m_mask(mask) { }
+
+	explicit operator bool() const {
+		return m_mask != 0;
+	}
+
+	/// @brief The index of the lowest selected slot
+	size_t lowest() const {
+		return static_cast<size_t>(std::countr_zero(m_mask)) / 8;
+	}
+
+	void removeLowest() {
+		m_mask &= m_mask - 1;
+	}
+
+private:
+	uint64_t m_mask;
+};
+
+/// @brief The control bytes of a group, the byte of the first slot being the lowest one
+class Group {
+public:
+	explicit Group(const uint8_t* control) {
+		// The compilers turn this into a single load on little-endian targets
+		for (size_t i = 0; i < groupSize; ++i) {
+			m_word |= uint64_t{control[i]} << (8 * i);
+		}
+	}
+
+	/// @brief The slots that may hold the control hash `hash`. There can be false positives next
+	/// to the true matches, the keys have to be compared anyway
+	GroupMask match(uint8_t hash) const {
+		const uint64_t x = m_word ^ (lowBits * hash);
+		return GroupMask((x - lowBits) & ~x & highBits);
+	}
+
+	/// @brief The empty slots: 0x80 has the bit 1 clear, while 0xfe (deleted) has it set
+	GroupMask matchEmpty() const {
+		return GroupMask(m_word & ~(m_word << 6) & highBits);
+	}
+
+	/// @brief The empty or deleted slots: the bit 7 set and the bit 0 clear
+	GroupMask matchEmptyOrDeleted() const {
+		return GroupMask(m_word & ~(m_word << 7) & highBits);
+	}
+
+private:
+	uint64_t m_word = 0;
+};
+
+/// @brief Visits the groups with triangular probing: `h, h + 1, h + 3, h + 6, ...` groups. With
+/// a power-of-two number of groups the sequence visits every group exactly once
+class ProbeSequence {
+public:
+	ProbeSequence(uint64_t hash, size_t capacity):
+		m_mask(capacity / groupSize - 1),
+		m_group(static_cast<size_t>(hash >> 7) & m_mask)
+	{ }
+
+	/// @brief Index of the first slot of the current group
+	size_t offset() const {
+		return m_group * groupSize;
+	}
+
+	void next() {
+		++m_step;
+		m_group = (m_group + m_step) & m_mask;
+	}
+
+private:
+	size_t m_mask;
+	size_t m_group;
+	size_t m_step = 0;
+};
+
+/// @brief The most elements a table of `capacity` slots holds before it grows: 7/8 of the slots
+size_t maxLoad(size_t capacity) {
+	return capacity - capacity / 8;
+}
+
+} // namespace
+
+SparseSet::SparseSet(const SparseSet& other) {
+	reserve(other.m_count);
+	other.forEach([this](uint64_t key) {
+		insertAbsent(key, mixHash(key));
+	});
+}
+
+SparseSet& SparseSet::operator=(const SparseSet& other) {
+	if (this != &other) {
+		SparseSet copy(other);
+		swap(*this, copy);
+	}
+	return *this;
+}
+
+size_t SparseSet::find(uint64_t pos, uint64_t hash) const {
+	if (m_capacity == 0) {
+		return m_capacity;
+	}
+
+	const uint8_t control = controlHash(hash);
+	for (ProbeSequence probe(hash, m_capacity); ; probe.next()) {
+		const Group group(&m_control[probe.offset()]);
+		for (GroupMask match = group.match(control); match; match.removeLowest()) {
+			const size_t slot = probe.offset() + match.lowest();
+			if (isFull(m_control[slot]) && m_keys[slot] == pos) {
+				return slot;
+			}
+		}
+		// The element would have been put into this group if it had an empty slot
+		if (group.matchEmpty()) {
+			return m_capacity;
+		}
+	}
+}
+
+bool SparseSet::get(uint64_t pos) const {
+	return find(pos, mixHash(pos)) != m_capacity;
+}
+
+void SparseSet::insertAbsent(uint64_t pos, uint64_t hash) {
+	if (m_growthLeft == 0) {
+		// Many deleted slots: clean them up in place instead of growing
+		const bool isMostlyDeleted = m_count < maxLoad(m_capacity) / 2;
+		rehash(isMostlyDeleted ? m_capacity : std::max(m_capacity * 2, groupSize));
+	}
+
+	for (ProbeSequence probe(hash, m_capacity); ; probe.next()) {
+		const GroupMask free = Group(&m_control[probe.offset()]).matchEmptyOrDeleted();
+		if (free) {
+			const size_t slot = probe.offset() + free.lowest();
+			if (m_control[slot] == emptyControl) {
+				--m_growthLeft;
+			}
+			m_control[slot] = controlHash(hash);
+			m_keys[slot] = pos;
+			++m_count;
+			return;
+		}
+	}
+}
+
+void SparseSet::set(uint64_t pos, bool value) {
+	const uint64_t hash = mixHash(pos);
+	const size_t slot = find(pos, hash);
+	if (value && slot == m_capacity) {
+		insertAbsent(pos, hash);
+	}
+	else if (!value && slot != m_capacity) {
+		// Groups are aligned, so a group that still has an empty slot has never been full and no
+		// probe sequence has ever passed it. The slot can become empty again, there is no need
+		// for a tombstone
+		const size_t groupOffset = slot / groupSize * groupSize;
+		if (Group(&m_control[groupOffset]).matchEmpty()) {
+			m_control[slot] = emptyControl;
+			++m_growthLeft;
+		}
+		else {
+			m_control[slot] = deletedControl;
+		}
+		--m_count;
+	}
+}
+
+void SparseSet::rehash(size_t capacity) {
+	std::unique_ptr<uint8_t[]> oldControl = std::move(m_control);
+	std::unique_ptr<uint64_t[]> oldKeys = std::move(m_keys);
+	const size_t oldCapacity = m_capacity;
+
+	m_control.reset(new uint8_t[capacity]);
+	m_keys.reset(new uint64_t[capacity]);
+	std::memset(m_control.get(), emptyControl, capacity);
+	m_capacity = capacity;
+	m_count = 0;
+	m_growthLeft = maxLoad(capacity);
+
+	for (size_t i = 0; i < oldCapacity; ++i) {
+		if (isFull(oldControl[i])) {
+			insertAbsent(oldKeys[i], mixHash(oldKeys[i]));
+		}
+	}
+}
+
+void SparseSet::reserve(size_t count) {
+	size_t capacity = std::max(m_capacity, groupSize);
+	while (maxLoad(capacity) < count) {
+		capacity *= 2;
+	}
+	if (capacity != m_capacity) {
+		rehash(capacity);
+	}
+}
+
+void SparseSet::clear() {
+	if (m_capacity != 0) {
+		std::memset(m_control.get(), emptyControl, m_capacity);
+	}
+	m_count = 0;
+	m_growthLeft = maxLoad(m_capacity);
+}
+
+void SparseSet::toSorted(std::vector<uint64_t>& output) const {
+	output.clear();
+	output.reserve(m_count);
+	forEach([&output](uint64_t key) {
+		output.push_back(key);
+	});
+	std::sort(output.begin(), output.end());
+}
+
+SparseSet SparseSet::fromBitSet(const BitSet& set) {
+	std::vector<uint64_t> elements;
+	set.toIndices(elements);
+
+	SparseSet result;
+	result.reserve(elements.size());
+	for (uint64_t element : elements) {
+		result.insertAbsent(element, mixHash(element));
+	}
+	return result;
+}
+
+BitSet SparseSet::toBitSet() const {
+	std::vector<uint64_t> elements;
+	toSorted(elements);
+	return BitSet::fromSorted({elements.begin(), elements.end()});
+}
+
+bool operator==(const SparseSet& a, const SparseSet& b) {
+	if (a.m_count != b.m_count) {
+		return false;
+	}
+	for (size_t i = 0; i < a.m_capacity; ++i) {
+		if (SparseSet::isFull(a.m_control[i]) && !b.get(a.m_keys[i])) {
+			return false;
+		}
+	}
+	return true;
+}
+
+SparseSet operator|(const SparseSet& a, const SparseSet& b) {
+	const SparseSet& larger = a.m_count >= b.m_count ? a : b;
+	const SparseSet& smaller = a.m_count >= b.m_count ? b : a;
+
+	SparseSet result(larger);
+	result.reserve(larger.m_count + smaller.m_count);
+	smaller.forEach([&result](uint64_t key) {
+		result.set(key);
+	});
+	return result;
+}
+
+SparseSet operator&(const SparseSet& a, const SparseSet& b) {
+	const SparseSet& larger = a.m_count >= b.m_count ? a : b;
+	const SparseSet& smaller = a.m_count >= b.m_count ? b : a;
+
+	SparseSet result;
+	smaller.forEach([&result, &larger](uint64_t key) {
+		const uint64_t hash = mixHash(key);
+		if (larger.find(key, hash) != larger.m_capacity) {
+			result.insertAbsent(key, hash);
+		}
+	});
+	return result;
+}
+
+SparseSet operator^(const SparseSet& a, const SparseSet& b) {
+	SparseSet result;
+	const auto addMissing = [&result](const SparseSet& from, const SparseSet& other) {
+		from.forEach([&result, &other](uint64_t key) {
+			const uint64_t hash = mixHash(key);
+			if (other.find(key, hash) == other.m_capacity) {
+				result.insertAbsent(key, hash);
+			}
+		});
+	};
+	addMissing(a, b);
+	addMissing(b, a);
+	return result;
+}
+
+std::ostream& operator<<(std::ostream& output, const SparseSet& set) {
+	std::vector<uint64_t> elements;
+	set.toSorted(elements);
+
+	output << "{";
+	for (size_t i = 0; i < elements.size(); ++i) {
+		output << (i == 0 ? "" : ", ") << elements[i];
+	}
+	output << "}";
+	return output;
+}
+
+std::istream& operator>>(std::istream& input, SparseSet& set) {
+	set.clear();
+	uint64_t value{};
+	while (input >> value) {
+		if (input.peek() == '\n') {
+			input.setstate(std::ios::eofbit);
+		}
+		set.set(value);
+	}
+	return input;
+}
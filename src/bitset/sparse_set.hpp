@@ -0,0 +1,159 @@
+#ifndef SPARSE_SET_HPP_INCLUDED
+#define SPARSE_SET_HPP_INCLUDED
+
+#include <cstddef>
+#include <cstdint>
+
+#include <istream>
+#include <memory>
+#include <ostream>
+#include <vector>
+
+#include "bitset/bitset.hpp"
+
+/// @brief A set of unique unsigned 64-bit numbers stored in a flat open-addressing hash table.
+/// The counterpart of `BitSet` for sparse sets: the memory is proportional to the number of
+/// elements, not to the largest one
+///
+/// The table follows the design of the Swiss tables: every slot has a control byte that is
+/// either empty, deleted or holds 7 bits of the hash of the key. The control bytes are probed in
+/// groups of 8 with word-wide bit tricks (SIMD within a register), so that most of the lookups
+/// compare a single key, and the keys live in a separate flat array without any nodes
+class SparseSet {
+public:
+	/// @brief A wrapper that acts like a reference to a specific element, as `BitSet::BitReference`
+	class BitReference {
+	public:
+		BitReference(SparseSet& set, uint64_t pos): m_set(&set), m_pos(pos) { }
+
+		explicit operator bool() const {
+			return m_set->get(m_pos);
+		}
+
+		BitReference& operator=(bool value) {
+			m_set->set(m_pos, value);
+			return *this;
+		}
+
+	private:
+		SparseSet* m_set;
+		uint64_t m_pos;
+	};
+
+	SparseSet() = default;
+
+	SparseSet(const SparseSet& other);
+	SparseSet& operator=(const SparseSet& other);
+
+	SparseSet(SparseSet&& other) noexcept {
+		swap(*this, other);
+	}
+	SparseSet& operator=(SparseSet&& other) noexcept {
+		SparseSet moved(std::move(other));
+		swap(*this, moved);
+		return *this;
+	}
+
+	~SparseSet() = default;
+
+	/// @brief Check whether a given element is contained in the set
+	bool get(uint64_t pos) const;
+
+	/// @brief Add or remove a given element to/from the set
+	void set(uint64_t pos, bool value = true);
+
+	bool operator[](uint64_t pos) const {
+		return get(pos);
+	}
+	BitReference operator[](uint64_t pos) {
+		return {*this, pos};
+	}
+
+	/// @brief Make room for `count` elements, so that inserting them doesn't rehash the table
+	void reserve(size_t count);
+
+	/// @brief Remove all elements from the set. Keeps the allocated table
+	void clear();
+
+	/// @brief Get the number of elements in the set
+	size_t count() const {
+		return m_count;
+	}
+
+	/// @brief The memory taken by the table in bytes
+	size_t sizeBytes() const {
+		return m_capacity * (sizeof(uint64_t) + 1);
+	}
+
+	/// @brief Call `visit(element)` for every element, in no particular order
+	template<typename Visit>
+	void forEach(Visit visit) const {
+		for (size_t i = 0; i < m_capacity; ++i) {
+			if (isFull(m_control[i])) {
+				visit(m_keys[i]);
+			}
+		}
+	}
+
+	/// @brief Replace the contents of `output` with the elements of the set in ascending order
+	void toSorted(std::vector<uint64_t>& output) const;
+
+	static SparseSet fromBitSet(const BitSet& set);
+	BitSet toBitSet() const;
+
+	friend bool operator==(const SparseSet& a, const SparseSet& b);
+	friend bool operator!=(const SparseSet& a, const SparseSet& b) {
+		return !(a == b);
+	}
+
+	/// @brief Construct a union of two sets
+	friend SparseSet operator|(const SparseSet& a, const SparseSet& b);
+	/// @brief Construct an intersection of two sets
+	friend SparseSet operator&(const SparseSet& a, const SparseSet& b);
+	/// @brief Construct a symmetric difference of two sets
+	friend SparseSet operator^(const SparseSet& a, const SparseSet& b);
+
+	friend void swap(SparseSet& a, SparseSet& b) noexcept {
+		using std::swap;
+
+		swap(a.m_control, b.m_control);
+		swap(a.m_keys, b.m_keys);
+		swap(a.m_capacity, b.m_capacity);
+		swap(a.m_count, b.m_count);
+		swap(a.m_growthLeft, b.m_growthLeft);
+	}
+
+	/// @brief Write to the stream `output` in the format of `{value1, value2, ..., valueN}` with
+	/// the values in ascending order, as `BitSet` does
+	friend std::ostream& operator<<(std::ostream& output, const SparseSet& set);
+	/// @brief Read from the stream `input` in the format of `value1 value2 ... valueN`
+	friend std::istream& operator>>(std::istream& input, SparseSet& set);
+
+private:
+	/// @brief A control byte with the high bit clear is a full slot holding 7 bits of the hash
+	static constexpr uint8_t emptyControl = 0x80;
+	static constexpr uint8_t deletedControl = 0xfe;
+
+	static bool isFull(uint8_t control) {
+		return (control & 0x80) == 0;
+	}
+
+	/// @brief Find the slot of `pos`. Returns `m_capacity` if there is no such element
+	size_t find(uint64_t pos, uint64_t hash) const;
+	/// @brief Insert `pos` that is known to be absent
+	void insertAbsent(uint64_t pos, uint64_t hash);
+	/// @brief Rebuild the table with `capacity` slots, dropping the deleted ones
+	void rehash(size_t capacity);
+
+	/// @brief Control bytes, one per slot
+	std::unique_ptr<uint8_t[]> m_control;
+	std::unique_ptr<uint64_t[]> m_keys;
+	/// @brief Number of slots, a power of two and a multiple of the group size, or 0
+	size_t m_capacity = 0;
+	size_t m_count = 0;
+	/// @brief Number of elements that can be inserted before the table has to grow. Deleted slots
+	/// aren't reused by this count, so they are cleaned up by the rehash eventually
+	size_t m_growthLeft = 0;
+};
+
+#endif
@@ -0,0 +1,153 @@
+#include <chrono>
+#include <iostream>
+#include <random>
+#include <set>
+#include <sstream>
+#include <unordered_set>
+#include <vector>
+
+#include "bitset/adaptive_set.hpp"
+#include "bitset/sparse_set.hpp"
+
+/// @brief Apply the same random insertions and removals to a `SparseSet`, an `AdaptiveSet` and
+/// a `std::set` and compare them along the way
+static bool checkAgainstStdSet(uint64_t range, size_t operationCount, unsigned seed) {
+	std::mt19937_64 random(seed);
+	std::uniform_int_distribution<uint64_t> value(0, range - 1);
+
+	SparseSet sparse;
+	AdaptiveSet adaptive;
+	std::set<uint64_t> reference;
+	for (size_t i = 0; i < operationCount; ++i) {
+		const uint64_t element = value(random);
+		// Insert more often than remove, so that the sets grow and cross the density threshold
+		const bool isInsertion = random() % 3 != 0;
+		sparse.set(element, isInsertion);
+		adaptive[element] = isInsertion;
+		if (isInsertion) {
+			reference.insert(element);
+		}
+		else {
+			reference.erase(element);
+		}
+
+		if (sparse.count() != reference.size() || adaptive.count() != reference.size()) {
+			return false;
+		}
+	}
+
+	for (uint64_t element = 0; element < std::min<uint64_t>(range, 100'000); ++element) {
+		const bool isExpected = reference.count(element) != 0;
+		if (sparse.get(element) != isExpected || adaptive.get(element) != isExpected) {
+			return false;
+		}
+	}
+	// A BitSet of the sparse range would take petabytes
+	const bool canConvert = range <= uint64_t{1} << 32;
+	return sparse == adaptive.toSparseSet()
+		&& (!canConvert || sparse.toBitSet() == adaptive.toBitSet());
+}
+
+int main() {
+	std::cout << std::boolalpha;
+
+	{
+		std::cout << "Basic operations:\n";
+
+		SparseSet a;
+		std::istringstream("3 7 1000000000000 42") >> a;
+		SparseSet b;
+		b.set(7);
+		b[42] = true;
+		b.set(5'000'000'000);
+
+		std::cout << "  a -> " << a << '\n';
+		std::cout << "  b -> " << b << '\n';
+		std::cout << "  a | b -> " << (a | b) << '\n';
+		std::cout << "  a & b -> " << (a & b) << '\n';
+		std::cout << "  a ^ b -> " << (a ^ b) << '\n';
+		std::cout << "  a == b -> " << (a == b) << ", (a | b) == (b | a) -> "
+			<< ((a | b) == (b | a)) << '\n';
+	}
+
+	{
+		std::cout << "\nRandomized checks against std::set:\n";
+		std::cout << "  Sparse range: " << checkAgainstStdSet(uint64_t{1} << 60, 200'000, 1)
+			<< '\n';
+		std::cout << "  Dense range: " << checkAgainstStdSet(50'000, 200'000, 2) << '\n';
+		std::cout << "  Mixed range: " << checkAgainstStdSet(10'000'000, 300'000, 3) << '\n';
+	}
+
+	{
+		std::cout << "\nAdaptive representation:\n";
+
+		AdaptiveSet set;
+		const auto print = [&set](const char* what) {
+			std::cout << "  " << what << ": " << set.count() << " elements, "
+				<< (set.isDense() ? "dense" : "sparse") << ", " << set.sizeBytes() << " bytes\n";
+		};
+
+		for (uint64_t i = 0; i < 1'000'000; i += 1000) {
+			set.set(i);
+		}
+		print("every 1000th number below 10^6");
+		for (uint64_t i = 0; i < 1'000'000; i += 10) {
+			set.set(i);
+		}
+		print("every 10th number below 10^6");
+		for (uint64_t i = 0; i < 1'000'000; i += 10) {
+			if (i % 10'000 != 0) {
+				set.set(i, false);
+			}
+		}
+		print("every 10000th number below 10^6");
+		set.set(uint64_t{1} << 50);
+		print("plus 2^50");
+	}
+
+	{
+		std::cout << "\nLookups of 64-bit keys, 1M elements:\n";
+		using Seconds = std::chrono::duration<double>;
+
+		std::mt19937_64 random(4);
+		std::vector<uint64_t> keys(1'000'000);
+		for (uint64_t& key : keys) {
+			key = random();
+		}
+		std::vector<uint64_t> queries(4'000'000);
+		for (size_t i = 0; i < queries.size(); ++i) {
+			// Half of the queries hit
+			queries[i] = i % 2 == 0 ? keys[random() % keys.size()] : random();
+		}
+
+		const auto measure = [&](const char* name, auto& set) {
+			auto start = std::chrono::steady_clock::now();
+			for (uint64_t key : keys) {
+				set.insert(key);
+			}
+			const double insertSeconds = Seconds(std::chrono::steady_clock::now() - start).count();
+
+			start = std::chrono::steady_clock::now();
+			size_t hits = 0;
+			for (uint64_t query : queries) {
+				hits += set.contains(query);
+			}
+			const double querySeconds = Seconds(std::chrono::steady_clock::now() - start).count();
+
+			std::cout << "  " << name << ": insert " << insertSeconds * 1e9 / 1e6
+				<< " ns/key, lookup " << querySeconds * 1e9 / 4e6 << " ns/key, " << hits
+				<< " hits\n";
+		};
+
+		struct SparseSetAdapter {
+			SparseSet set;
+			void insert(uint64_t key) { set.set(key); }
+			bool contains(uint64_t key) const { return set.get(key); }
+		};
+		SparseSetAdapter sparse;
+		std::unordered_set<uint64_t> hashSet;
+		measure("SparseSet", sparse);
+		measure("std::unordered_set", hashSet);
+		std::cout << "  SparseSet table: " << sparse.set.sizeBytes() / 1024 << " KiB\n";
+	}
+}
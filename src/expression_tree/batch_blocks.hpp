@@ -0,0 +1,47 @@
+#ifndef BATCH_BLOCKS_HPP_INCLUDED
+#define BATCH_BLOCKS_HPP_INCLUDED
+
+#include <cstddef>
+
+#include "expression_tree/bytecode.hpp"
+
+// The loops over the blocks of `Program::batchBlockSize` values shared by the batch evaluations
+// of the programs and of the schedules of `ExpressionPool`
+
+#if (defined(__GNUC__) || defined(__clang__)) && defined(__x86_64__) && defined(__linux__)
+/// @brief Compile the loops over the blocks for AVX-512 and AVX2 as well, as "vector_math.cpp"
+/// does, and pick the version for the processor when the program is loaded
+#define BATCH_CLONES __attribute__((target_clones("avx512f", "avx2", "default")))
+#else
+#define BATCH_CLONES
+#endif
+
+#if defined(__GNUC__) || defined(__clang__)
+/// @brief Inline a block loop into each of the versions of `BATCH_CLONES`, which a call to the
+/// baseline version would defeat
+#define BATCH_INLINE __attribute__((always_inline)) inline
+#else
+#define BATCH_INLINE inline
+#endif
+
+/// @brief Set every value of the block `result` to `operation(value)` of the block `values`.
+/// The blocks may be the same one
+template<typename Operation>
+BATCH_INLINE void applyUnaryBlock(double* result, const double* values, Operation operation) {
+	for (size_t i = 0; i < Program::batchBlockSize; ++i) {
+		result[i] = operation(values[i]);
+	}
+}
+
+/// @brief Set every value of the block `result` to `operation(firstValue, secondValue)`. The
+/// blocks may be the same ones
+template<typename Operation>
+BATCH_INLINE void applyBinaryBlock(double* result, const double* first, const double* second,
+	Operation operation)
+{
+	for (size_t i = 0; i < Program::batchBlockSize; ++i) {
+		result[i] = operation(first[i], second[i]);
+	}
+}
+
+#endif
@@ -0,0 +1,273 @@
+#include "expression_tree/bytecode.hpp"
+
+#include <cassert>
+#include <cmath>
+
+#include <algorithm>
+#include <memory>
+
+#include "expression_tree/batch_blocks.hpp"
+#include "expression_tree/expression.hpp"
+#include "expression_tree/vector_math.hpp"
+
+namespace {
+
+/// @brief Programs up to this deep are run with a stack on the call stack
+constexpr size_t localStackSize = 64;
+
+const char* mnemonic(OpCode op) {
+	switch (op) {
+	case OpCode::Constant: return "const";
+	case OpCode::Variable: return "var";
+	case OpCode::Negate: return "neg";
+	case OpCode::Add: return "add";
+	case OpCode::Subtract: return "sub";
+	case OpCode::Multiply: return "mul";
+	case OpCode::Divide: return "div";
+	case OpCode::Sin: return "sin";
+	case OpCode::Cos: return "cos";
+	case OpCode::Sqrt: return "sqrt";
+	case OpCode::Pow: return "pow";
+	}
+	return "?";
+}
+
+} // namespace
+
+size_t operandCount(OpCode op) {
+	switch (op) {
+	case OpCode::Constant:
+	case OpCode::Variable:
+		return 0;
+	case OpCode::Negate:
+	case OpCode::Sin:
+	case OpCode::Cos:
+	case OpCode::Sqrt:
+		return 1;
+	case OpCode::Add:
+	case OpCode::Subtract:
+	case OpCode::Multiply:
+	case OpCode::Divide:
+	case OpCode::Pow:
+		return 2;
+	}
+	return 0;
+}
+
+void Program::emit(OpCode op) {
+	assert(op != OpCode::Constant && op != OpCode::Variable);
+	assert(m_stackDepth >= operandCount(op));
+	m_code.push_back(op);
+	m_stackDepth = m_stackDepth - operandCount(op) + 1;
+}
+
+void Program::emitConstant(double value) {
+	m_code.push_back(OpCode::Constant);
+	m_constants.push_back(value);
+	++m_stackDepth;
+	m_maxStackDepth = std::max(m_maxStackDepth, m_stackDepth);
+}
+
+void Program::emitVariable(size_t index) {
+	m_code.push_back(OpCode::Variable);
+	m_variableIndices.push_back(index);
+	m_variableCount = std::max(m_variableCount, index + 1);
+	++m_stackDepth;
+	m_maxStackDepth = std::max(m_maxStackDepth, m_stackDepth);
+}
+
+double Program::eval(ArrayView<const double> variables) const {
+	if (m_maxStackDepth <= localStackSize) {
+		double stack[localStackSize];
+		return eval(variables, stack);
+	}
+	std::unique_ptr<double[]> stack(new double[m_maxStackDepth]);
+	return eval(variables, {stack.get(), m_maxStackDepth});
+}
+
+double Program::eval(ArrayView<const double> variables, ArrayView<double> stack) const {
+	assert(stack.size() >= m_maxStackDepth && m_stackDepth == 1);
+	assert(variables.size() >= m_variableCount);
+
+	// The topmost value is kept in `top`, a register, and only the values below it live in
+	// `stack`, `below` pointing past the last of them. Unary instructions then don't touch the
+	// memory at all, and the binary ones load a single operand
+	double top = 0;
+	double* below = stack.data();
+	const double* constant = m_constants.data();
+	const size_t* variable = m_variableIndices.data();
+	for (const OpCode op : m_code) {
+		switch (op) {
+		case OpCode::Constant:
+			*below++ = top;
+			top = *constant++;
+			break;
+		case OpCode::Variable:
+			*below++ = top;
+			top = variables[*variable++];
+			break;
+		case OpCode::Negate:
+			top = -top;
+			break;
+		case OpCode::Add:
+			top = *--below + top;
+			break;
+		case OpCode::Subtract:
+			top = *--below - top;
+			break;
+		case OpCode::Multiply:
+			top = *--below * top;
+			break;
+		case OpCode::Divide:
+			top = *--below / top;
+			break;
+		case OpCode::Sin:
+			top = std::sin(top);
+			break;
+		case OpCode::Cos:
+			top = std::cos(top);
+			break;
+		case OpCode::Sqrt:
+			top = std::sqrt(top);
+			break;
+		case OpCode::Pow:
+			top = std::pow(*--below, top);
+			break;
+		}
+	}
+	return top;
+}
+
+void Program::evalBatch(ArrayView<const ArrayView<const double>> variables,
+	ArrayView<double> output, MathKernels kernels) const
+{
+	std::unique_ptr<double[]> stack(new double[batchStackSize()]);
+	evalBatch(variables, output, {stack.get(), batchStackSize()}, kernels);
+}
+
+BATCH_CLONES void Program::evalBatch(ArrayView<const ArrayView<const double>> variables,
+	ArrayView<double> output, ArrayView<double> stack, MathKernels kernels) const
+{
+	assert(m_stackDepth == 1 && variables.size() >= m_variableCount);
+	assert(stack.size() >= batchStackSize());
+	constexpr size_t blockSize = batchBlockSize;
+
+	// The stack holds blocks of values instead of values, the block `i` starting at
+	// `i * blockSize`
+	const auto block = [&stack](size_t index) {
+		return stack.data() + index * blockSize;
+	};
+
+	for (size_t begin = 0; begin < output.size(); begin += blockSize) {
+		const size_t count = std::min(blockSize, output.size() - begin);
+		size_t depth = 0;
+		const double* constant = m_constants.data();
+		const size_t* variable = m_variableIndices.data();
+		for (const OpCode op : m_code) {
+			switch (op) {
+			case OpCode::Constant:
+				std::fill_n(block(depth++), blockSize, *constant++);
+				break;
+			case OpCode::Variable: {
+				const ArrayView<const double>& column = variables[*variable++];
+				assert(column.size() >= output.size());
+				double* values = block(depth++);
+				std::copy_n(column.data() + begin, count, values);
+				// Pad the last block with copies of its last row, so that every loop runs over
+				// whole blocks and the padding raises no floating point exceptions of its own
+				std::fill(values + count, values + blockSize, values[count - 1]);
+				break;
+			}
+			case OpCode::Negate:
+				applyUnaryBlock(block(depth - 1), block(depth - 1), [](double x) { return -x; });
+				break;
+			case OpCode::Add:
+				--depth;
+				applyBinaryBlock(block(depth - 1), block(depth - 1), block(depth),
+					[](double x, double y) { return x + y; });
+				break;
+			case OpCode::Subtract:
+				--depth;
+				applyBinaryBlock(block(depth - 1), block(depth - 1), block(depth),
+					[](double x, double y) { return x - y; });
+				break;
+			case OpCode::Multiply:
+				--depth;
+				applyBinaryBlock(block(depth - 1), block(depth - 1), block(depth),
+					[](double x, double y) { return x * y; });
+				break;
+			case OpCode::Divide:
+				--depth;
+				applyBinaryBlock(block(depth - 1), block(depth - 1), block(depth),
+					[](double x, double y) { return x / y; });
+				break;
+			case OpCode::Sin:
+				if (kernels == MathKernels::Vectorized) {
+					vectorSin(block(depth - 1), blockSize);
+				}
+				else {
+					applyUnaryBlock(block(depth - 1), block(depth - 1),
+						[](double x) { return std::sin(x); });
+				}
+				break;
+			case OpCode::Cos:
+				if (kernels == MathKernels::Vectorized) {
+					vectorCos(block(depth - 1), blockSize);
+				}
+				else {
+					applyUnaryBlock(block(depth - 1), block(depth - 1),
+						[](double x) { return std::cos(x); });
+				}
+				break;
+			case OpCode::Sqrt:
+				if (kernels == MathKernels::Vectorized) {
+					vectorSqrt(block(depth - 1), blockSize);
+				}
+				else {
+					applyUnaryBlock(block(depth - 1), block(depth - 1),
+						[](double x) { return std::sqrt(x); });
+				}
+				break;
+			case OpCode::Pow:
+				--depth;
+				if (kernels == MathKernels::Vectorized) {
+					vectorPow(block(depth - 1), block(depth), blockSize);
+				}
+				else {
+					applyBinaryBlock(block(depth - 1), block(depth - 1), block(depth),
+						[](double x, double y) { return std::pow(x, y); });
+				}
+				break;
+			}
+		}
+		std::copy_n(block(0), count, output.data() + begin);
+	}
+}
+
+std::ostream& operator<<(std::ostream& output, const Program& program) {
+	size_t constantIndex = 0;
+	size_t variableIndex = 0;
+	for (const OpCode op : program.m_code) {
+		output << mnemonic(op);
+		if (op == OpCode::Constant) {
+			output << ' ' << program.m_constants[constantIndex++];
+		}
+		else if (op == OpCode::Variable) {
+			output << ' ' << program.m_variableIndices[variableIndex++];
+		}
+		output << '\n';
+	}
+	return output;
+}
+
+Program compile(const Expression& expr) {
+	assert(expr.isComplete());
+	Program program;
+	// A complete expression has no missing children to skip
+	expr.visitPostOrder([&program](const Expression* node) {
+		if (node) {
+			node->compileNode(program);
+		}
+	});
+	return program;
+}
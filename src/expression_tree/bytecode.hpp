@@ -0,0 +1,135 @@
+#ifndef BYTECODE_HPP_INCLUDED
+#define BYTECODE_HPP_INCLUDED
+
+#include <cstddef>
+#include <cstdint>
+
+#include <ostream>
+#include <vector>
+
+#include "array_view/array_view.hpp"
+
+class Expression;
+
+/// @brief The instructions of the stack machine that runs a `Program`. Every instruction pops its
+/// operands from the stack and pushes the result
+enum class OpCode: std::uint8_t {
+	/// @brief Push the next value of the constant pool
+	Constant,
+	/// @brief Push the value of the variable at the next index of the variable table
+	Variable,
+	Negate,
+	Add,
+	Subtract,
+	Multiply,
+	Divide,
+	Sin,
+	Cos,
+	Sqrt,
+	Pow,
+};
+
+/// @brief Number of operands popped by the instruction
+size_t operandCount(OpCode op);
+
+/// @brief The implementations of `sin`, `cos`, `sqrt` and `pow` that `Program::evalBatch()` uses
+enum class MathKernels {
+	/// @brief The functions of <cmath>, which give the same results as `Program::eval()`
+	Libm,
+	/// @brief The functions of "vector_math.hpp", vectorized for the widest instruction set of the
+	/// processor. Faster, but the results differ from those of <cmath> in the last few bits
+	Vectorized,
+};
+
+/// @brief An expression compiled into a flat postfix program: the instructions in the order of
+/// a post-order traversal of the tree, and the constants and the variable indices in the order
+/// they are pushed. Evaluating a program makes no allocations, virtual calls or pointer chasing,
+/// just a loop over a contiguous array with a `switch`
+class Program {
+public:
+	/// @brief Number of rows `evalBatch()` runs every instruction over at once
+	static constexpr size_t batchBlockSize = 256;
+
+	/// @brief Append an instruction other than `OpCode::Constant` and `OpCode::Variable`
+	void emit(OpCode op);
+	/// @brief Append an instruction that pushes `value`
+	void emitConstant(double value);
+	/// @brief Append an instruction that pushes the value of the variable at `index`
+	void emitVariable(size_t index);
+
+	/// @brief Run the program and return the value left on the stack. Uses a stack on the
+	/// call stack if the program is shallow enough, otherwise allocates one
+	/// @param variables The values of the variables, as for `Expression::eval()`
+	/// @pre The program is not empty and leaves exactly one value on the stack, as the programs
+	/// made by `compile()` do
+	/// @pre `variables.size() >= variableCount()`
+	/// @note Computes the same value as `Expression::eval()`, with the same floating point
+	/// exceptions raised
+	double eval(ArrayView<const double> variables = {}) const;
+	/// @brief Run the program using `stack` for the intermediate values, without any allocations
+	/// @pre `stack.size() >= maxStackDepth()`
+	double eval(ArrayView<const double> variables, ArrayView<double> stack) const;
+
+	/// @brief Run the program for every row of a table of inputs: `output[i]` is set to the value
+	/// of the program with the variable `j` equal to `variables[j][i]`.
+	///
+	/// Every instruction is run over a block of `batchBlockSize` rows before the next one, so
+	/// the dispatch is paid once per block and the arithmetic is a plain loop over arrays that
+	/// the compiler vectorizes. The loops are compiled for AVX-512 and AVX2 as well where the
+	/// compiler supports `target_clones`, and the widest version the processor has is run. The
+	/// results are the same as those of `eval()` row by row with `MathKernels::Libm`
+	/// @param variables The columns of the variables, `variables[j]` holding the values of the
+	/// variable `j` for all rows
+	/// @param kernels The implementations of the functions that are called
+	/// @pre `variables.size() >= variableCount()`, and every column has at least
+	/// `output.size()` values
+	void evalBatch(ArrayView<const ArrayView<const double>> variables, ArrayView<double> output,
+		MathKernels kernels = MathKernels::Libm) const;
+	/// @brief Run `evalBatch()` using `stack` for the blocks of the intermediate values, without
+	/// any allocations
+	/// @pre `stack.size() >= batchStackSize()`
+	void evalBatch(ArrayView<const ArrayView<const double>> variables, ArrayView<double> output,
+		ArrayView<double> stack, MathKernels kernels = MathKernels::Libm) const;
+
+	/// @brief The size of the stack of `evalBatch()`: a block of values per stack slot
+	size_t batchStackSize() const {
+		return m_maxStackDepth * batchBlockSize;
+	}
+
+	ArrayView<const OpCode> code() const {
+		return {m_code.data(), m_code.size()};
+	}
+	ArrayView<const double> constants() const {
+		return {m_constants.data(), m_constants.size()};
+	}
+	ArrayView<const size_t> variableIndices() const {
+		return {m_variableIndices.data(), m_variableIndices.size()};
+	}
+
+	/// @brief The number of values the program reads, one past the largest variable index
+	size_t variableCount() const {
+		return m_variableCount;
+	}
+
+	/// @brief The maximum number of values on the stack during the evaluation
+	size_t maxStackDepth() const {
+		return m_maxStackDepth;
+	}
+
+	/// @brief Write the instructions one per line, e.g. `const 3`, `var 0`, `add`
+	friend std::ostream& operator<<(std::ostream& output, const Program& program);
+
+private:
+	std::vector<OpCode> m_code;
+	std::vector<double> m_constants;
+	std::vector<size_t> m_variableIndices;
+	size_t m_variableCount = 0;
+	size_t m_stackDepth = 0;
+	size_t m_maxStackDepth = 0;
+};
+
+/// @brief Compile an expression into a program
+/// @pre `expr.isComplete()`
+Program compile(const Expression& expr);
+
+#endif
@@ -0,0 +1,267 @@
+#include "expression_tree/derivative.hpp"
+
+#include <cassert>
+#include <cfenv>
+#include <cmath>
+
+#include <bit>
+#include <stdexcept>
+#include <string_view>
+#include <vector>
+
+namespace {
+
+using NodeId = ExpressionPool::NodeId;
+
+/// @brief Makes the nodes of a derivative, simplifying them as they are made
+class DerivativeBuilder {
+public:
+	explicit DerivativeBuilder(ExpressionPool& pool):
+		m_pool(pool),
+		m_zero(pool.constant(0)),
+		m_one(pool.constant(1))
+	{ }
+
+	NodeId zero() const {
+		return m_zero;
+	}
+
+	NodeId one() const {
+		return m_one;
+	}
+
+	bool isZero(NodeId id) const {
+		return isConstant(id) && value(id) == 0;
+	}
+
+	NodeId constant(double value) {
+		return m_pool.constant(value);
+	}
+
+	NodeId negate(NodeId a) {
+		if (isConstant(a)) {
+			return constant(-value(a));
+		}
+		if (m_pool[a].op == OpCode::Negate) {
+			return m_pool[a].first;
+		}
+		return m_pool.intern(OpCode::Negate, a);
+	}
+
+	NodeId add(NodeId a, NodeId b) {
+		if (isZero(a)) {
+			return b;
+		}
+		if (isZero(b)) {
+			return a;
+		}
+		return fold(OpCode::Add, a, b);
+	}
+
+	NodeId subtract(NodeId a, NodeId b) {
+		if (isZero(b)) {
+			return a;
+		}
+		if (isZero(a)) {
+			return negate(b);
+		}
+		return fold(OpCode::Subtract, a, b);
+	}
+
+	NodeId multiply(NodeId a, NodeId b) {
+		if (isZero(a) || isZero(b)) {
+			return m_zero;
+		}
+		if (a == m_one) {
+			return b;
+		}
+		if (b == m_one) {
+			return a;
+		}
+		return fold(OpCode::Multiply, a, b);
+	}
+
+	NodeId divide(NodeId a, NodeId b) {
+		if (isZero(a)) {
+			return m_zero;
+		}
+		if (b == m_one) {
+			return a;
+		}
+		return fold(OpCode::Divide, a, b);
+	}
+
+	NodeId pow(NodeId a, NodeId b) {
+		if (b == m_one) {
+			return a;
+		}
+		if (isZero(b)) {
+			return m_one;
+		}
+		return fold(OpCode::Pow, a, b);
+	}
+
+	NodeId function(OpCode op, NodeId a) {
+		return m_pool.intern(op, a);
+	}
+
+private:
+	bool isConstant(NodeId id) const {
+		return m_pool[id].op == OpCode::Constant;
+	}
+
+	double value(NodeId id) const {
+		return std::bit_cast<double>(m_pool[id].token);
+	}
+
+	/// @brief Replace the operation on two constants with its value if it is finite, otherwise
+	/// intern the operation
+	NodeId fold(OpCode op, NodeId a, NodeId b) {
+		if (isConstant(a) && isConstant(b)) {
+			const double x = value(a);
+			const double y = value(b);
+			double result = 0;
+			switch (op) {
+			case OpCode::Add:
+				result = x + y;
+				break;
+			case OpCode::Subtract:
+				result = x - y;
+				break;
+			case OpCode::Multiply:
+				result = x * y;
+				break;
+			case OpCode::Divide:
+				result = x / y;
+				break;
+			case OpCode::Pow:
+				result = std::pow(x, y);
+				break;
+			default:
+				assert(false);
+			}
+			if (std::isfinite(result)) {
+				return constant(result);
+			}
+		}
+		return m_pool.intern(op, a, b);
+	}
+
+	ExpressionPool& m_pool;
+	NodeId m_zero;
+	NodeId m_one;
+};
+
+/// @brief Restores the floating point exception flags on the destruction
+class ExceptFlagsGuard {
+public:
+	ExceptFlagsGuard() {
+		std::fegetexceptflag(&m_flags, FE_ALL_EXCEPT);
+	}
+
+	~ExceptFlagsGuard() {
+		std::fesetexceptflag(&m_flags, FE_ALL_EXCEPT);
+	}
+
+	ExceptFlagsGuard(const ExceptFlagsGuard&) = delete;
+	ExceptFlagsGuard& operator=(const ExceptFlagsGuard&) = delete;
+
+private:
+	std::fexcept_t m_flags;
+};
+
+/// @brief Set `names[i]` to the name of the variable with the index `i` in `expr`
+void collectVariableNames(const Expression& expr, std::vector<std::string_view>& names) {
+	expr.visitPostOrder([&names](const Expression* node) {
+		if (const Variable* variable = dynamic_cast<const Variable*>(node)) {
+			if (variable->index() >= names.size()) {
+				names.resize(variable->index() + 1);
+			}
+			names[variable->index()] = variable->name();
+		}
+	});
+}
+
+} // namespace
+
+ExpressionPool::NodeId derivative(ExpressionPool& pool, ExpressionPool::NodeId root,
+	size_t variable)
+{
+	// Don't let the folding of the constants change the exceptions raised by the caller
+	const ExceptFlagsGuard guard;
+	DerivativeBuilder builder(pool);
+
+	// The nodes are in topological order, so a pass upwards differentiates the children first.
+	// `derivatives[id]` is the derivative of the node `id`
+	const std::vector<bool> isReachable = pool.reachableNodes(root);
+	std::vector<NodeId> derivatives(isReachable.size(), ExpressionPool::noChild);
+	for (NodeId id = 0; id < isReachable.size(); ++id) {
+		if (!isReachable[id]) {
+			continue;
+		}
+		// A copy, the nodes move when the pool grows
+		const ExpressionPool::Node node = pool[id];
+		const NodeId a = node.first;
+		const NodeId b = node.second;
+		const NodeId da = a != ExpressionPool::noChild ? derivatives[a] : builder.zero();
+		const NodeId db = b != ExpressionPool::noChild ? derivatives[b] : builder.zero();
+		if (operandCount(node.op) > 0 && builder.isZero(da) && builder.isZero(db)) {
+			derivatives[id] = builder.zero();
+			continue;
+		}
+
+		NodeId& result = derivatives[id];
+		switch (node.op) {
+		case OpCode::Constant:
+			result = builder.zero();
+			break;
+		case OpCode::Variable:
+			result = node.token == variable ? builder.one() : builder.zero();
+			break;
+		case OpCode::Negate:
+			result = builder.negate(da);
+			break;
+		case OpCode::Add:
+			result = builder.add(da, db);
+			break;
+		case OpCode::Subtract:
+			result = builder.subtract(da, db);
+			break;
+		case OpCode::Multiply:
+			result = builder.add(builder.multiply(da, b), builder.multiply(a, db));
+			break;
+		case OpCode::Divide:
+			// d(a / b) = da / b - (a / b) * db / b, which reuses the node `a / b`
+			result = builder.subtract(builder.divide(da, b),
+				builder.divide(builder.multiply(id, db), b));
+			break;
+		case OpCode::Sin:
+			result = builder.multiply(builder.function(OpCode::Cos, a), da);
+			break;
+		case OpCode::Cos:
+			result = builder.negate(builder.multiply(builder.function(OpCode::Sin, a), da));
+			break;
+		case OpCode::Sqrt:
+			result = builder.divide(da, builder.multiply(builder.constant(2), id));
+			break;
+		case OpCode::Pow:
+			if (!builder.isZero(db)) {
+				throw std::runtime_error("derivative: the exponent of pow depends on the variable");
+			}
+			// d(pow(a, b)) = b * pow(a, b - 1) * da
+			result = builder.multiply(
+				builder.multiply(b, builder.pow(a, builder.subtract(b, builder.one()))), da);
+			break;
+		}
+	}
+	return derivatives[root];
+}
+
+std::unique_ptr<Expression> derivative(const Expression& expr, size_t variable) {
+	ExpressionPool pool;
+	const ExpressionPool::NodeId root = derivative(pool, pool.intern(expr), variable);
+
+	std::vector<std::string_view> names;
+	collectVariableNames(expr, names);
+	return pool.toExpression(root, {names.begin(), names.end()});
+}
@@ -0,0 +1,37 @@
+#ifndef DERIVATIVE_HPP_INCLUDED
+#define DERIVATIVE_HPP_INCLUDED
+
+#include <cstddef>
+
+#include <memory>
+
+#include "expression_tree/expression.hpp"
+#include "expression_tree/expression_pool.hpp"
+
+/// @brief Differentiate the expression rooted at `root` by the variable `variable`, adding
+/// the derivative to the pool. Returns its root.
+///
+/// The derivative is built in the pool, so it shares the nodes of the expression and its own
+/// repeated terms instead of copying them, and the derivative of every node is computed once
+/// however many times the node is used. It is simplified as it is built: the products by 0 and 1,
+/// the sums with 0 and the operations on constants are removed, so the derivatives of the terms
+/// that don't depend on `variable` vanish instead of piling up.
+/// @note As in the usual symbolic differentiation the simplification takes `0 * x` as 0, so
+/// the derivative may be finite where the expression is infinite or NaN
+/// @throws std::runtime_error if the exponent of `pow` depends on `variable`: its derivative
+/// needs the logarithm, which the expressions can't express
+ExpressionPool::NodeId derivative(ExpressionPool& pool, ExpressionPool::NodeId root,
+	size_t variable);
+
+/// @brief Differentiate `expr` by the variable with the index `variable`, see the overload above.
+/// The variables of the derivative keep their names
+/// @note The derivative is expanded from the pool to a tree, which copies a shared node for
+/// every path to it, so the tree can be quadratic in the size of `expr`: the 3001 nodes of
+/// `sin(x * sin(x * ...))` 1000 levels deep make a derivative of 5999 nodes in the pool and of
+/// 3005999 nodes as a tree. To evaluate or compile a derivative, differentiate in a pool and
+/// take the `ExpressionPool::schedule()` of the result, which stays linear
+/// @pre `expr.isComplete()`
+/// @throws std::runtime_error if the exponent of `pow` depends on `variable`
+std::unique_ptr<Expression> derivative(const Expression& expr, size_t variable);
+
+#endif
@@ -0,0 +1,158 @@
+#include "expression_tree/dynamic_cast_eval.hpp"
+
+#include <cmath>
+
+#include <vector>
+
+#include "expression_tree/functions.hpp"
+#include "expression_tree/operators.hpp"
+
+namespace {
+
+/// @brief The recursion goes this deep at most, as that of `Expression::eval()`
+constexpr unsigned maxRecursionDepth = 512;
+
+/// @brief Compute the value of the node alone from the values of its children
+double applyNode(const Expression& expr, double first, double second,
+	ArrayView<const double> variables)
+{
+	if (const Number* number = dynamic_cast<const Number*>(&expr)) {
+		return number->value();
+	}
+	if (const Variable* variable = dynamic_cast<const Variable*>(&expr)) {
+		return variables[variable->index()];
+	}
+	if (dynamic_cast<const Negation*>(&expr)) {
+		return -first;
+	}
+	if (dynamic_cast<const Addition*>(&expr)) {
+		return first + second;
+	}
+	if (dynamic_cast<const Subtraction*>(&expr)) {
+		return first - second;
+	}
+	if (dynamic_cast<const Multiplication*>(&expr)) {
+		return first * second;
+	}
+	if (dynamic_cast<const Division*>(&expr)) {
+		return first / second;
+	}
+	if (dynamic_cast<const Sin*>(&expr)) {
+		return std::sin(first);
+	}
+	if (dynamic_cast<const Cos*>(&expr)) {
+		return std::cos(first);
+	}
+	if (dynamic_cast<const Sqrt*>(&expr)) {
+		return std::sqrt(first);
+	}
+	if (dynamic_cast<const Pow*>(&expr)) {
+		return std::pow(first, second);
+	}
+	return std::nan("");
+}
+
+double evalIterative(const Expression& root, ArrayView<const double> variables) {
+	// The same traversal as that of `evalIterative()` of `VariantExpression`: a node goes back
+	// on the stack below its children and is computed when it comes up again, with the values
+	// of the finished subtrees waiting on `values`. The children are found by `dynamic_cast`
+	// as well
+	struct Entry {
+		const Expression* expr;
+		unsigned arity;
+	};
+	// `arity` of an entry not yet expanded
+	constexpr unsigned notExpanded = ~0u;
+	std::vector<double> values;
+	std::vector<Entry> stack{{&root, notExpanded}};
+	for (;;) {
+		const Entry entry = stack.back();
+		stack.pop_back();
+		if (entry.arity == notExpanded) {
+			if (const BinaryExpression* binary = dynamic_cast<const BinaryExpression*>(entry.expr)) {
+				stack.push_back({entry.expr, 2});
+				stack.push_back({binary->second(), notExpanded});
+				stack.push_back({binary->first(), notExpanded});
+				continue;
+			}
+			if (const UnaryExpression* unary = dynamic_cast<const UnaryExpression*>(entry.expr)) {
+				stack.push_back({entry.expr, 1});
+				stack.push_back({unary->first(), notExpanded});
+				continue;
+			}
+		}
+		double second = 0;
+		if (entry.arity == 2) {
+			second = values.back();
+			values.pop_back();
+		}
+		double first = 0;
+		if (entry.arity == 1 || entry.arity == 2) {
+			first = values.back();
+			values.pop_back();
+		}
+		const double value = applyNode(*entry.expr, first, second, variables);
+		// The root comes last
+		if (stack.empty()) {
+			return value;
+		}
+		values.push_back(value);
+	}
+}
+
+double evalRecursive(const Expression& expr, ArrayView<const double> variables, unsigned depth);
+
+/// @brief Go on to a child of the node `depth` levels below the root: by the recursion down to
+/// `maxRecursionDepth`, iteratively below
+double evalChild(const Expression& child, ArrayView<const double> variables, unsigned depth) {
+	return depth < maxRecursionDepth ? evalRecursive(child, variables, depth + 1)
+		: evalIterative(child, variables);
+}
+
+double evalRecursive(const Expression& expr, ArrayView<const double> variables, unsigned depth) {
+	if (const Number* number = dynamic_cast<const Number*>(&expr)) {
+		return number->value();
+	}
+	if (const Variable* variable = dynamic_cast<const Variable*>(&expr)) {
+		return variables[variable->index()];
+	}
+	if (const Negation* operation = dynamic_cast<const Negation*>(&expr)) {
+		return -evalChild(*operation->first(), variables, depth);
+	}
+	if (const Addition* operation = dynamic_cast<const Addition*>(&expr)) {
+		return evalChild(*operation->first(), variables, depth)
+			+ evalChild(*operation->second(), variables, depth);
+	}
+	if (const Subtraction* operation = dynamic_cast<const Subtraction*>(&expr)) {
+		return evalChild(*operation->first(), variables, depth)
+			- evalChild(*operation->second(), variables, depth);
+	}
+	if (const Multiplication* operation = dynamic_cast<const Multiplication*>(&expr)) {
+		return evalChild(*operation->first(), variables, depth)
+			* evalChild(*operation->second(), variables, depth);
+	}
+	if (const Division* operation = dynamic_cast<const Division*>(&expr)) {
+		return evalChild(*operation->first(), variables, depth)
+			/ evalChild(*operation->second(), variables, depth);
+	}
+	if (const Sin* func = dynamic_cast<const Sin*>(&expr)) {
+		return std::sin(evalChild(*func->first(), variables, depth));
+	}
+	if (const Cos* func = dynamic_cast<const Cos*>(&expr)) {
+		return std::cos(evalChild(*func->first(), variables, depth));
+	}
+	if (const Sqrt* func = dynamic_cast<const Sqrt*>(&expr)) {
+		return std::sqrt(evalChild(*func->first(), variables, depth));
+	}
+	if (const Pow* func = dynamic_cast<const Pow*>(&expr)) {
+		return std::pow(evalChild(*func->first(), variables, depth),
+			evalChild(*func->second(), variables, depth));
+	}
+	return std::nan("");
+}
+
+} // namespace
+
+double evalDynamicCast(const Expression& expr, ArrayView<const double> variables) {
+	return evalRecursive(expr, variables, 0);
+}
@@ -0,0 +1,14 @@
+#ifndef DYNAMIC_CAST_EVAL_HPP_INCLUDED
+#define DYNAMIC_CAST_EVAL_HPP_INCLUDED
+
+#include "array_view/array_view.hpp"
+#include "expression_tree/expression.hpp"
+
+/// @brief Equivalent to `expr.eval()` but implemented using a cascade of `dynamic_cast` instead
+/// of virtual functions, to compare the two ways of dispatching by the type of the node
+/// @note Recursive down to 512 levels. The subtrees below are evaluated with a stack on the heap,
+/// still dispatching by `dynamic_cast`, so the depth of the tree is not limited by the call stack
+/// @pre `expr.isComplete()`
+double evalDynamicCast(const Expression& expr, ArrayView<const double> variables = {});
+
+#endif
@@ -0,0 +1,144 @@
+#include "expression_tree/expression.hpp"
+
+#include <utility>
+
+namespace {
+
+/// @brief The number of the destructors of the nodes running on the current thread
+thread_local unsigned destructionDepth = 0;
+
+/// @brief The destructors recurse this deep at most. A level of the recursion is a chain of
+/// several destructors and `delete` calls, a few hundred bytes of the stack without
+/// optimizations, so the bound is lower than `Expression::maxRecursionDepth`
+constexpr unsigned maxDestructionDepth = 128;
+
+} // namespace
+
+bool Expression::isCompleteIterative() const {
+	// The order of the visits doesn't matter here, so a plain stack of the nodes will do
+	std::vector<const Expression*> pending{this};
+	while (!pending.empty()) {
+		const Expression* node = pending.back();
+		pending.pop_back();
+		for (size_t i = 0; i < node->arity(); ++i) {
+			const Expression* child = node->child(i);
+			if (!child) {
+				return false;
+			}
+			pending.push_back(child);
+		}
+	}
+	return true;
+}
+
+void Expression::printInfixRecursive(std::ostream& output) const {
+	// The nodes being printed and the index of the next child of each, as in `visitPostOrder()`
+	struct Frame {
+		const Expression* node;
+		size_t nextChild;
+	};
+	std::vector<Frame> stack{{this, 0}};
+	while (!stack.empty()) {
+		Frame& top = stack.back();
+		const Expression* node = top.node;
+		const size_t index = top.nextChild++;
+		node->printInfixPart(output, index);
+		if (index == node->arity()) {
+			stack.pop_back();
+		}
+		else if (const Expression* child = node->child(index)) {
+			stack.push_back({child, 0});
+		}
+		else {
+			output << '#';
+		}
+	}
+}
+
+std::unique_ptr<Expression> Expression::cloneIterative() const {
+	// The copies of the finished subtrees, the children of the next node to copy on the top
+	std::vector<std::unique_ptr<Expression>> copies;
+	visitPostOrder([&copies](const Expression* node) {
+		if (!node) {
+			copies.emplace_back();
+			return;
+		}
+		const size_t arity = node->arity();
+		const size_t firstChild = copies.size() - arity;
+		std::unique_ptr<Expression> copy = node->cloneNode({copies.data() + firstChild, arity});
+		copies.resize(firstChild);
+		copies.push_back(std::move(copy));
+	});
+	return std::move(copies.back());
+}
+
+void Expression::destroyChildren(std::unique_ptr<Expression>& first,
+	std::unique_ptr<Expression>& second)
+{
+	if (destructionDepth < maxDestructionDepth) {
+		++destructionDepth;
+		first.reset();
+		second.reset();
+		--destructionDepth;
+		return;
+	}
+	if (!first && !second) {
+		return;
+	}
+
+	std::vector<std::unique_ptr<Expression>> pending;
+	pending.push_back(std::move(first));
+	pending.push_back(std::move(second));
+	while (!pending.empty()) {
+		std::unique_ptr<Expression> node = std::move(pending.back());
+		pending.pop_back();
+		if (node) {
+			node->releaseChildren(pending);
+		}
+	}
+}
+
+double Expression::evalIterative(ArrayView<const double> variables) const {
+	// The nodes being evaluated with their arity and the index of the next child of each, as in
+	// `visitPostOrder()`, but the leaves are computed without a frame of their own, so that
+	// `arity()`, `child()` and `evalNode()` are called once per node. The values of the finished
+	// subtrees, the operands of the nodes on the stack, wait on `values`. Both stacks are kept
+	// by the thread between the calls
+	struct Frame {
+		const Expression* node;
+		size_t arity;
+		size_t nextChild;
+	};
+	thread_local std::vector<double> threadValues;
+	thread_local std::vector<Frame> threadStack;
+	std::vector<double>& values = threadValues;
+	std::vector<Frame>& stack = threadStack;
+
+	// The frames and the values of an evaluation further up the thread, if any, stay below
+	const size_t stackBase = stack.size();
+	const size_t valuesBase = values.size();
+	stack.push_back({this, arity(), 0});
+	while (stack.size() > stackBase) {
+		Frame& top = stack.back();
+		if (top.nextChild < top.arity) {
+			const Expression* child = top.node->child(top.nextChild++);
+			const size_t childArity = child->arity();
+			if (childArity == 0) {
+				values.push_back(child->evalNode({}, variables));
+			}
+			else {
+				stack.push_back({child, childArity, 0});
+			}
+			continue;
+		}
+		const size_t firstOperand = values.size() - top.arity;
+		const double value = top.node->evalNode({values.data() + firstOperand, top.arity},
+			variables);
+		values.resize(firstOperand);
+		values.push_back(value);
+		stack.pop_back();
+	}
+	const double value = values.back();
+	values.resize(valuesBase);
+	return value;
+}
@@ -1,9 +1,16 @@
 #ifndef EXPRESSION_HPP_INCLUDED
 #define EXPRESSION_HPP_INCLUDED
 
+#include <cassert>
 #include <cmath>
 
 #include <memory>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "expression_tree/bytecode.hpp"
 
 // UML diagram: https://www.plantuml.com/plantuml/png/pPRDRXCn483lVWfBI2W1vGMYgYejLE90gIYS4AeSxuIEyDgBVq9AoRlZ3HbYJIn86afpZ7T-ldpshFSaHELZQer06y5FbGRvQjvv206TbNT2okVoJar2z4h7XOIPCeFXM3OkJGpmf_e6JJD0sy1yB0D-X-kOOxMp8HPLd_4qvJ7U3eQKmXzZE7DjPo127pDnpl28N5b30rOl8z36pO2y-Dvz0JjmANOfvbwn6OzT3W3LFXrM4rxRASxVWKu-u0ospDJ6sOon2aiMloQuxg8_MWiu5WiXj54Xo8lKJi0lFOzaUvtj9lXjjozTCxw3vghRkj2wnItLxUPhQqd5KJpwCHgDLhw48D_oWrN-bftO9zda57s8Vwx_a2wNxViLNYD0F5y--plWi6g0_U52nIdUsyKgC81sjZb8QptOlZufuUfNDVgtEsy15osAb-VR3hoABe-qN6ncqjDYrywJrP5sgpQ4bJAKm-TWtNpteMIlt4iFEMz0kzfxeEhbGQGrmUUm5iEEwXwu6pIiek1RL8tY-aZhlNWekVpdj5QrmsAOdNzAmohMxV0ekgAka13uLSHlXxrVzoIaHC_jYUJCXSSaoUs9vD9z-ryafrX1oVq9vG8-g-AOqEJIUxKEMR_i7qGYcrF29VmNJOE4_qYa99cX4jfw4DAady_3f2tf2FXDCX4xWreT9ZC39EoNECDmcC249iJgmttqyGQRJFBfUFF3Z2qKiPjV4DId2A9RdYhLGggtNYsGNqVqgygrRYnEm3QfDJy1
 // TODO: Associativity
@@ -16,11 +23,23 @@ public:
 	/// @note A polymorphic class should have a virtual destructor
 	virtual ~Expression() = default;
 
+	/// @brief Allocate a node from the arena of the current `ExpressionArena::Scope`, if any,
+	/// otherwise from the heap
+	static void* operator new(size_t size);
+	/// @brief Free a node to the heap or to the region of its arena, as its header records
+	static void operator delete(void* pointer);
+
 	/// @brief Evaluate the expression and return the numerical result
+	/// @param variables The values of the variables, indexed by `Variable::index()`
 	/// @pre `this->isComplete()`. The expression must be complete before evaluating
+	/// @pre `variables` has a value for every variable of the expression
 	/// @warning No error checking is performed. Make sure that the expression is fully
 	/// constructed beforehand. Use floating point exceptions to detect numerical errors
-	virtual double eval() const = 0;
+	/// @note Recursive down to `maxRecursionDepth`, iterative below with the values on a stack on
+	/// the heap, so the depth of the tree is not limited by the call stack
+	double eval(ArrayView<const double> variables = {}) const {
+		return evalRecursive(variables, 0);
+	}
 
 	/// @brief Return a pointer to the child expression at specified location index or `nullptr`
 	/// if no such child exists
@@ -31,8 +50,10 @@ public:
 
 	/// @brief Check whether the expression is complete (i.e., all of its child nodes are non-null
 	/// and complete)
-	/// @note Recursive
-	virtual bool isComplete() const = 0;
+	/// @note Recursive down to `maxRecursionDepth`, iterative below
+	bool isComplete() const {
+		return isCompleteRecursive(0);
+	}
 
 	/// @brief Get the precedence of the expression. The expression node with the higher precedence
 	/// has higher priority in the infix notation unless parentheses explicitly change the order
@@ -43,13 +64,34 @@ public:
 	virtual void printToken(std::ostream& output) const = 0;
 
 	/// @brief Write the infix notation of the expression including its child nodes to the specified
-	/// output stream
-	virtual void printInfixRecursive(std::ostream& output) const = 0;
+	/// output stream, `#` in place of the missing children
+	/// @note Iterative, any depth of the tree is fine
+	void printInfixRecursive(std::ostream& output) const;
+
+	/// @brief Create a full copy of the expression tree, missing children included
+	/// @note Recursive down to `maxRecursionDepth`, iterative below
+	std::unique_ptr<Expression> clone() const {
+		return cloneRecursive(0);
+	}
 
-	/// @brief Create a full copy of the expression tree
-	virtual std::unique_ptr<Expression> clone() const = 0;
+	/// @brief Append the instruction of the node itself to `program`. `compile()` calls it for
+	/// every node in post-order, so the instructions of the children come first
+	virtual void compileNode(Program& program) const = 0;
+
+	/// @brief Call `visit(node)` for every node of the tree in post-order, the children from the
+	/// first to the last before their parent, and `visit(nullptr)` for every missing child. Uses a
+	/// stack on the heap, so any depth of the tree is fine
+	template<typename Visit>
+	void visitPostOrder(Visit visit) const;
 
 protected:
+	/// @brief The traversals recurse this deep at most and go on iteratively below: the
+	/// recursion is the fastest on the usual shallow trees. A level takes a few dozen bytes of
+	/// the stack with optimizations and about 150 without, so the traversals of a tree of any
+	/// depth fit into 128 KiB of the stack of a thread. The destructors, whose levels are
+	/// larger, recurse less deep
+	static constexpr unsigned maxRecursionDepth = 512;
+
 	// Ban constructing, copying and moving directly, but let the derived classes implement
 	// their own special functions if possible
 	Expression() = default;
@@ -58,42 +100,93 @@ protected:
 	Expression(Expression&&) = default;
 	Expression& operator=(Expression&&) = default;
 
-	/// @brief Helper function to ease cloning incomplete expressions
-	static std::unique_ptr<Expression> cloneOrNull(const Expression* expr) {
-		return expr ? expr->clone() : std::unique_ptr<Expression>();
+	/// @brief The recursive traversals of `eval()`, `isComplete()` and `clone()` from a node
+	/// `depth` levels below the one they were called on. They go on to the children by
+	/// `evalChild()`, `isChildComplete()` and `cloneChild()`
+	virtual double evalRecursive(ArrayView<const double> variables, unsigned depth) const = 0;
+	virtual bool isCompleteRecursive(unsigned depth) const = 0;
+	virtual std::unique_ptr<Expression> cloneRecursive(unsigned depth) const = 0;
+
+	/// @brief Compute the value of the node alone from the values of its children
+	/// @pre `operands.size() == arity()`
+	virtual double evalNode(ArrayView<const double> operands, ArrayView<const double> variables)
+		const = 0;
+
+	/// @brief Create a copy of the node alone with the given children, which it takes
+	/// @pre `children.size() == arity()`
+	virtual std::unique_ptr<Expression> cloneNode(ArrayView<std::unique_ptr<Expression>> children)
+		const = 0;
+
+	/// @brief Write the part of the infix notation of the node that comes before the child
+	/// `index`, or after the last child if `index == arity()`: the token, the separators and the
+	/// parentheses around the children
+	virtual void printInfixPart(std::ostream& output, size_t index) const = 0;
+
+	/// @brief Move the children out to the end of `children`, leaving the node incomplete
+	virtual void releaseChildren(std::vector<std::unique_ptr<Expression>>& children) = 0;
+
+	/// @brief Go on with a traversal to a child of the node `depth` levels below its root: by
+	/// the recursion down to `maxRecursionDepth`, iteratively below
+	static double evalChild(const Expression& child, ArrayView<const double> variables,
+		unsigned depth
+	) {
+		return depth < maxRecursionDepth ? child.evalRecursive(variables, depth + 1)
+			: child.evalIterative(variables);
 	}
-
-	/// @brief Helper function to ease printing (in)complete expressions with or without
-	/// parentheses
-	static void printInfixRecursiveOrPlaceholder(const Expression* expr, std::ostream& output,
-		bool withParentheses = false
+	static bool isChildComplete(const std::unique_ptr<Expression>& child, unsigned depth) {
+		return child && (depth < maxRecursionDepth ? child->isCompleteRecursive(depth + 1)
+			: child->isCompleteIterative());
+	}
+	static std::unique_ptr<Expression> cloneChild(const std::unique_ptr<Expression>& child,
+		unsigned depth
 	) {
-		if (withParentheses) {
-			output << '(';
+		if (!child) {
+			return nullptr;
 		}
+		return depth < maxRecursionDepth ? child->cloneRecursive(depth + 1)
+			: child->cloneIterative();
+	}
 
-		if (expr) {
-			expr->printInfixRecursive(output);
+	/// @brief Destroy the children of a node: by the recursion of the destructors down to a
+	/// depth of 128, below that one node at a time from a worklist, every node with its
+	/// children already released so that its own destructor does not recurse
+	static void destroyChildren(std::unique_ptr<Expression>& first,
+		std::unique_ptr<Expression>& second);
+
+private:
+	/// @brief The iterative traversals, with a stack on the heap
+	double evalIterative(ArrayView<const double> variables) const;
+	bool isCompleteIterative() const;
+	std::unique_ptr<Expression> cloneIterative() const;
+};
+
+template<typename Visit>
+void Expression::visitPostOrder(Visit visit) const {
+	struct Frame {
+		const Expression* node;
+		size_t nextChild;
+	};
+	std::vector<Frame> stack{{this, 0}};
+	while (!stack.empty()) {
+		Frame& top = stack.back();
+		if (top.nextChild == top.node->arity()) {
+			visit(top.node);
+			stack.pop_back();
 		}
-		else {
-			output << "#";
+		else if (const Expression* child = top.node->child(top.nextChild++)) {
+			stack.push_back({child, 0});
 		}
-
-		if (withParentheses) {
-			output << ')';
+		else {
+			visit(static_cast<const Expression*>(nullptr));
 		}
 	}
-};
+}
 
 class Number final: public Expression {
 public:
 	Number() = default;
 	explicit Number(double value): m_value(value) { }
 
-	double eval() const override {
-		return m_value;
-	}
-
 	const Expression* child(size_t) const override {
 		return nullptr;
 	}
@@ -102,28 +195,155 @@ public:
 		return 0;
 	}
 
-	bool isComplete() const override {
+	int precedence() const override {
+		return maxPrecedence;
+	}
+
+	void printToken(std::ostream& output) const override {
+		output << m_value;
+	}
+
+	void compileNode(Program& program) const override {
+		program.emitConstant(m_value);
+	}
+
+	double value() const {
+		return m_value;
+	}
+
+private:
+	double evalRecursive(ArrayView<const double>, unsigned) const override {
+		return m_value;
+	}
+
+	double evalNode(ArrayView<const double>, ArrayView<const double>) const override {
+		return m_value;
+	}
+
+	bool isCompleteRecursive(unsigned) const override {
 		return true;
 	}
 
+	std::unique_ptr<Expression> cloneRecursive(unsigned) const override {
+		return std::make_unique<Number>(*this);
+	}
+
+	std::unique_ptr<Expression> cloneNode(ArrayView<std::unique_ptr<Expression>>) const override {
+		return std::make_unique<Number>(*this);
+	}
+
+	void printInfixPart(std::ostream& output, size_t) const override {
+		output << m_value;
+	}
+
+	void releaseChildren(std::vector<std::unique_ptr<Expression>>&) override { }
+
+	double m_value = std::nan("0");
+};
+
+/// @brief An input of the expression: a slot in the values of the variables passed to `eval()`.
+/// The same tree (or the program compiled from it) can be evaluated for many inputs without
+/// being rebuilt
+class Variable final: public Expression {
+public:
+	/// @brief The tag of the constructor that refers to the name instead of copying it
+	struct BorrowName { };
+
+	/// @brief The variable named `name`, or `x<index>` if the name is empty, that takes the value
+	/// at `index` of the variables
+	explicit Variable(size_t index, std::string name = {}):
+		m_index(index),
+		m_ownName(name.empty() ? defaultName(index) : std::move(name)),
+		m_name(m_ownName)
+	{ }
+
+	/// @brief The variable named `name` that refers to `name` rather than keeping a copy of it,
+	/// so it allocates nothing besides the node itself
+	/// @pre `name` is not empty and outlives the node and its clones
+	Variable(size_t index, std::string_view name, BorrowName):
+		m_index(index),
+		m_name(name)
+	{
+		assert(!name.empty());
+	}
+
+	/// @brief Copies the name if `other` owns it, and refers to the same name if it borrows it
+	Variable(const Variable& other):
+		Expression(other),
+		m_index(other.m_index),
+		m_ownName(other.m_ownName),
+		m_name(m_ownName.empty() ? other.m_name : std::string_view(m_ownName))
+	{ }
+
+	Variable& operator=(const Variable&) = delete;
+
+	const Expression* child(size_t) const override {
+		return nullptr;
+	}
+
+	size_t arity() const override {
+		return 0;
+	}
+
 	int precedence() const override {
 		return maxPrecedence;
 	}
 
 	void printToken(std::ostream& output) const override {
-		output << m_value;
+		output << m_name;
 	}
 
-	void printInfixRecursive(std::ostream& output) const override {
-		output << m_value;
+	void compileNode(Program& program) const override {
+		program.emitVariable(m_index);
 	}
 
-	std::unique_ptr<Expression> clone() const override {
-		return std::make_unique<Number>(*this);
+	size_t index() const {
+		return m_index;
+	}
+
+	std::string_view name() const {
+		return m_name;
 	}
 
 private:
-	double m_value = std::nan("0");
+	double evalRecursive(ArrayView<const double> variables, unsigned) const override {
+		assert(m_index < variables.size());
+		return variables[m_index];
+	}
+
+	double evalNode(ArrayView<const double>, ArrayView<const double> variables) const override {
+		assert(m_index < variables.size());
+		return variables[m_index];
+	}
+
+	bool isCompleteRecursive(unsigned) const override {
+		return true;
+	}
+
+	std::unique_ptr<Expression> cloneRecursive(unsigned) const override {
+		return std::make_unique<Variable>(*this);
+	}
+
+	std::unique_ptr<Expression> cloneNode(ArrayView<std::unique_ptr<Expression>>) const override {
+		return std::make_unique<Variable>(*this);
+	}
+
+	void printInfixPart(std::ostream& output, size_t) const override {
+		output << m_name;
+	}
+
+	void releaseChildren(std::vector<std::unique_ptr<Expression>>&) override { }
+
+	static std::string defaultName(size_t index) {
+		std::string name = "x";
+		name += std::to_string(index);
+		return name;
+	}
+
+	size_t m_index;
+	/// @brief The name if the node owns it, empty if it borrows the name
+	std::string m_ownName;
+	std::string_view m_name;
 };
 
 class UnaryExpression: virtual public Expression {
@@ -134,6 +354,11 @@ public:
 		m_first(std::move(first))
 	{ }
 
+	~UnaryExpression() override {
+		std::unique_ptr<Expression> noSecond;
+		destroyChildren(m_first, noSecond);
+	}
+
 	const Expression* child(size_t index) const override final {
 		return index == 0 ? m_first.get() : nullptr;
 	}
@@ -142,17 +367,29 @@ public:
 		return 1;
 	}
 
-	bool isComplete() const override final {
-		return m_first && m_first->isComplete();
-	}
-
 	const Expression* first() const { return m_first.get(); }
 	Expression* first() { return m_first.get(); }
 
 	void setFirst(std::unique_ptr<Expression> first) { m_first = std::move(first); }
+	/// @brief Take the ownership of the child, leaving the expression incomplete
+	std::unique_ptr<Expression> releaseFirst() { return std::move(m_first); }
 
 protected:
-	// `std::unique_ptr` automatically handles the lifetime of the child expression
+	bool isCompleteRecursive(unsigned depth) const override final {
+		return isChildComplete(m_first, depth);
+	}
+
+	std::unique_ptr<Expression> cloneRecursive(unsigned depth) const override final {
+		std::unique_ptr<Expression> children[] = {cloneChild(m_first, depth)};
+		return cloneNode(children);
+	}
+
+	void releaseChildren(std::vector<std::unique_ptr<Expression>>& children) override final {
+		children.push_back(std::move(m_first));
+	}
+
+	// `std::unique_ptr` owns the child expression, the destructor frees the deep subtrees
+	// iteratively
 	std::unique_ptr<Expression> m_first;
 };
 
@@ -165,6 +402,10 @@ public:
 		m_second(std::move(second))
 	{ }
 
+	~BinaryExpression() override {
+		destroyChildren(m_first, m_second);
+	}
+
 	const Expression* child(size_t index) const override final {
 		return
 			index == 0 ? m_first.get() :
@@ -176,11 +417,6 @@ public:
 		return 2;
 	}
 
-	bool isComplete() const override final {
-		// Checking for both null pointers first is faster due to short-circuit evaluation
-		return m_first && m_second && m_first->isComplete() && m_second->isComplete();
-	}
-
 	const Expression* first() const { return m_first.get(); }
 	Expression* first() { return m_first.get(); }
 	const Expression* second() const { return m_second.get(); }
@@ -188,9 +424,30 @@ public:
 
 	void setFirst(std::unique_ptr<Expression> first) { m_first = std::move(first); }
 	void setSecond(std::unique_ptr<Expression> second) { m_second = std::move(second); }
+	/// @brief Take the ownership of a child, leaving the expression incomplete
+	std::unique_ptr<Expression> releaseFirst() { return std::move(m_first); }
+	std::unique_ptr<Expression> releaseSecond() { return std::move(m_second); }
 
 protected:
-	// `std::unique_ptr` automatically handles the lifetime of the child expressions
+	bool isCompleteRecursive(unsigned depth) const override final {
+		// Checking for both null pointers first is faster due to short-circuit evaluation
+		return m_first && m_second && isChildComplete(m_first, depth)
+			&& isChildComplete(m_second, depth);
+	}
+
+	std::unique_ptr<Expression> cloneRecursive(unsigned depth) const override final {
+		std::unique_ptr<Expression> children[] = {cloneChild(m_first, depth),
+			cloneChild(m_second, depth)};
+		return cloneNode(children);
+	}
+
+	void releaseChildren(std::vector<std::unique_ptr<Expression>>& children) override final {
+		children.push_back(std::move(m_first));
+		children.push_back(std::move(m_second));
+	}
+
+	// `std::unique_ptr` owns the child expressions, the destructor frees the deep subtrees
+	// iteratively
 	std::unique_ptr<Expression> m_first;
 	std::unique_ptr<Expression> m_second;
 };
@@ -206,16 +463,23 @@ public:
 
 	virtual bool isPrefix() const = 0;
 
-	void printInfixRecursive(std::ostream& output) const override final {
-		const bool isPrefixOp = isPrefix();
-		if (isPrefixOp) {
-			printToken(output);
+protected:
+	void printInfixPart(std::ostream& output, size_t index) const override final {
+		const bool withParentheses = m_first && m_first->precedence() < precedence();
+		if (index == 0) {
+			if (isPrefix()) {
+				printToken(output);
+			}
+			if (withParentheses) {
+				output << '(';
+			}
+			return;
 		}
 
-		printInfixRecursiveOrPlaceholder(m_first.get(), output,
-			m_first && m_first->precedence() < precedence());
-
-		if (!isPrefixOp) {
+		if (withParentheses) {
+			output << ')';
+		}
+		if (!isPrefix()) {
 			printToken(output);
 		}
 	}
@@ -224,16 +488,34 @@ public:
 class BinaryOperator: public BinaryExpression, public Operator {
 	using BinaryExpression::BinaryExpression;
 
-	void printInfixRecursive(std::ostream& output) const override final {
-		printInfixRecursiveOrPlaceholder(m_first.get(), output,
-			m_first && m_first->precedence() < precedence());
-
-		output << ' ';
-		printToken(output);
-		output << ' ';
-
-		printInfixRecursiveOrPlaceholder(m_second.get(), output,
-			m_second && m_second->precedence() < precedence());
+protected:
+	void printInfixPart(std::ostream& output, size_t index) const override final {
+		const bool firstWithParentheses = m_first && m_first->precedence() < precedence();
+		// The operators associate to the left, so a right operand of the same precedence needs
+		// the parentheses, e.g. `a - (b - c)` and `a / (b * c)`
+		const bool secondWithParentheses = m_second && m_second->precedence() <= precedence();
+		switch (index) {
+		case 0:
+			if (firstWithParentheses) {
+				output << '(';
+			}
+			break;
+		case 1:
+			if (firstWithParentheses) {
+				output << ')';
+			}
+			output << ' ';
+			printToken(output);
+			output << ' ';
+			if (secondWithParentheses) {
+				output << '(';
+			}
+			break;
+		default:
+			if (secondWithParentheses) {
+				output << ')';
+			}
+		}
 	}
 };
 
@@ -241,12 +523,15 @@ class UnaryFunction: public UnaryExpression, public Function {
 public:
 	using UnaryExpression::UnaryExpression;
 
-	void printInfixRecursive(std::ostream& output) const override final {
-		printToken(output);
-
-		output << '(';
-		printInfixRecursiveOrPlaceholder(m_first.get(), output);
-		output << ')';
+protected:
+	void printInfixPart(std::ostream& output, size_t index) const override final {
+		if (index == 0) {
+			printToken(output);
+			output << '(';
+		}
+		else {
+			output << ')';
+		}
 	}
 };
 
@@ -254,15 +539,19 @@ class BinaryFunction: public BinaryExpression, public Function {
 public:
 	using BinaryExpression::BinaryExpression;
 
-	void printInfixRecursive(std::ostream& output) const override final {
-		printToken(output);
-
-		output << '(';
-		printInfixRecursiveOrPlaceholder(m_first.get(), output);
-		output << ", ";
-
-		printInfixRecursiveOrPlaceholder(m_second.get(), output);
-		output << ')';
+protected:
+	void printInfixPart(std::ostream& output, size_t index) const override final {
+		switch (index) {
+		case 0:
+			printToken(output);
+			output << '(';
+			break;
+		case 1:
+			output << ", ";
+			break;
+		default:
+			output << ')';
+		}
 	}
 };
 
@@ -0,0 +1,137 @@
+#include "expression_tree/expression_arena.hpp"
+
+#include <cassert>
+
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <new>
+#include <vector>
+
+#include "expression_tree/expression.hpp"
+
+struct ExpressionArena::Region {
+	std::vector<std::unique_ptr<std::byte[]>> blocks;
+	size_t sizeBytes = 0;
+	/// @brief The nodes alive, and one more while the arena takes nodes from the blocks
+	std::atomic<size_t> references = 1;
+};
+
+namespace {
+
+thread_local ExpressionArena* currentArena = nullptr;
+
+/// @brief Every allocation of a node starts with a pointer to its region, `nullptr` for the heap.
+/// The nodes are then aligned as pointers, which is enough for all of them
+constexpr size_t headerSize = sizeof(ExpressionArena::Region*);
+
+static_assert(alignof(Expression) <= headerSize);
+
+/// @brief The header before a node
+ExpressionArena::Region*& regionOf(void* pointer) {
+	return *std::launder(reinterpret_cast<ExpressionArena::Region**>(
+		static_cast<std::byte*>(pointer) - headerSize));
+}
+
+/// @brief Drop a reference to `region`, and free it with the last one
+void release(ExpressionArena::Region* region) {
+	if (region->references.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+		delete region;
+	}
+}
+
+/// @brief Round up to keep the allocations of an arena aligned
+constexpr size_t alignedSize(size_t size) {
+	return (size + headerSize - 1) / headerSize * headerSize;
+}
+
+} // namespace
+
+ExpressionArena::Scope::Scope(ExpressionArena& arena):
+	m_previous(currentArena)
+{
+	currentArena = &arena;
+}
+
+ExpressionArena::Scope::~Scope() {
+	currentArena = m_previous;
+}
+
+ExpressionArena::~ExpressionArena() {
+	reset();
+}
+
+ExpressionArena* ExpressionArena::current() {
+	return currentArena;
+}
+
+void* ExpressionArena::allocate(size_t size) {
+	if (!m_region) {
+		m_region = new Region;
+	}
+	size = alignedSize(size + headerSize);
+	if (static_cast<size_t>(m_end - m_next) < size) {
+		const size_t newBlockSize = std::max(size, blockSize);
+		m_region->blocks.emplace_back(new std::byte[newBlockSize]);
+		m_next = m_region->blocks.back().get();
+		m_end = m_next + newBlockSize;
+		m_region->sizeBytes += newBlockSize;
+	}
+
+	std::byte* allocation = m_next;
+	m_next += size;
+	m_region->references.fetch_add(1, std::memory_order_relaxed);
+	new (allocation) Region*(m_region);
+	return allocation + headerSize;
+}
+
+void ExpressionArena::deallocate(void* pointer) {
+	Region* region = regionOf(pointer);
+	assert(region);
+	release(region);
+}
+
+void ExpressionArena::reset() {
+	if (m_region) {
+		release(m_region);
+		m_region = nullptr;
+		m_next = nullptr;
+		m_end = nullptr;
+	}
+}
+
+void ExpressionArena::discard() {
+	delete m_region;
+	m_region = nullptr;
+	m_next = nullptr;
+	m_end = nullptr;
+}
+
+size_t ExpressionArena::liveCount() const {
+	return m_region ? m_region->references.load(std::memory_order_relaxed) - 1 : 0;
+}
+
+size_t ExpressionArena::sizeBytes() const {
+	return m_region ? m_region->sizeBytes : 0;
+}
+
+void* Expression::operator new(size_t size) {
+	if (ExpressionArena* arena = ExpressionArena::current()) {
+		return arena->allocate(size);
+	}
+	std::byte* allocation = static_cast<std::byte*>(::operator new(size + headerSize));
+	new (allocation) ExpressionArena::Region*(nullptr);
+	return allocation + headerSize;
+}
+
+void Expression::operator delete(void* pointer) {
+	if (!pointer) {
+		return;
+	}
+	if (regionOf(pointer)) {
+		ExpressionArena::deallocate(pointer);
+	}
+	else {
+		::operator delete(static_cast<std::byte*>(pointer) - headerSize);
+	}
+}
@@ -0,0 +1,90 @@
+#ifndef EXPRESSION_ARENA_HPP_INCLUDED
+#define EXPRESSION_ARENA_HPP_INCLUDED
+
+#include <cstddef>
+
+/// @brief A region of memory the expression nodes can be allocated from: the nodes are placed
+/// one after another in the order of construction, in large blocks, and the blocks are freed all
+/// at once.
+///
+/// The nodes are created as always, with `std::make_unique` and `clone()`, and owned by
+/// `std::unique_ptr<Expression>`. While a `Scope` of an arena is alive, `Expression::operator new`
+/// takes the memory of the new nodes of the thread from the arena instead of the heap. The trees
+/// may mix nodes of arenas and of the heap: every node is preceded by a pointer-sized header that
+/// records the region it was taken from, or the heap, and `Expression::operator delete` frees it
+/// there on any thread.
+///
+/// The blocks belong to a `Region` counting the nodes alive, which the arena lets go of when it
+/// is reset or destroyed. The blocks are freed when the last of the arena and of the nodes lets
+/// go of it, so a node may be deleted after its arena. Only `discard()` frees them at once
+/// @warning The arena itself is not thread-safe: it must be used, reset and destroyed by one
+/// thread at a time. Its nodes may be deleted by any thread
+class ExpressionArena {
+public:
+	/// @brief The size of the blocks of memory allocated from the heap. Larger nodes get
+	/// a block of their own
+	static constexpr size_t blockSize = 64 * 1024;
+
+	/// @brief Makes the arena the one the nodes of the current thread are allocated from, until
+	/// the scope ends. The scopes can be nested, the previous arena is restored at the end
+	class Scope {
+	public:
+		explicit Scope(ExpressionArena& arena);
+		~Scope();
+
+		Scope(const Scope&) = delete;
+		Scope& operator=(const Scope&) = delete;
+
+	private:
+		ExpressionArena* m_previous;
+	};
+
+	/// @brief The blocks of an arena and the count of their nodes alive, shared by the arena and
+	/// the nodes and freed by the last of them to let go of it
+	struct Region;
+
+	ExpressionArena() = default;
+
+	/// @brief Let go of the blocks, as `reset()`
+	~ExpressionArena();
+
+	// The nodes refer to the region of their arena
+	ExpressionArena(const ExpressionArena&) = delete;
+	ExpressionArena& operator=(const ExpressionArena&) = delete;
+
+	/// @brief The arena of the innermost `Scope` of the current thread, or `nullptr`
+	static ExpressionArena* current();
+
+	/// @brief Allocate `size` bytes aligned as a pointer, after the header that records the
+	/// region of the arena
+	void* allocate(size_t size);
+	/// @brief Free an allocation of any arena, on any thread. The memory is reused only once the
+	/// region is freed
+	/// @pre `pointer` was returned by `allocate()`
+	static void deallocate(void* pointer);
+
+	/// @brief Let go of the blocks, and take the next nodes from new ones. The blocks are freed at
+	/// once if none of their nodes is alive, otherwise when the last of them is deleted
+	void reset();
+	/// @brief Free all of the blocks at once, as `reset()` with no nodes alive. The nodes still
+	/// alive are dropped without running their destructors, which is the fast way to get rid of
+	/// a large tree: `release()` it from its `std::unique_ptr` and discard the arena
+	/// @pre The nodes still alive are not used or deleted anymore, and own no memory but that of
+	/// the arena: they have no children on the heap, and the names of their variables are
+	/// borrowed or fit into the small buffer of `std::string`, as the default names do
+	void discard();
+
+	/// @brief The number of the nodes of the blocks in use that are not deleted yet
+	size_t liveCount() const;
+
+	/// @brief The memory of the blocks in use in bytes
+	size_t sizeBytes() const;
+
+private:
+	/// @brief The region of the blocks in use, `nullptr` before the first allocation
+	Region* m_region = nullptr;
+	std::byte* m_next = nullptr;
+	std::byte* m_end = nullptr;
+};
+
+#endif
@@ -0,0 +1,388 @@
+#include "expression_tree/expression_pool.hpp"
+
+#include <cassert>
+#include <cmath>
+
+#include <algorithm>
+#include <bit>
+#include <stdexcept>
+#include <string>
+
+#include "bitset/mix_hash.hpp"
+#include "expression_tree/batch_blocks.hpp"
+#include "expression_tree/functions.hpp"
+#include "expression_tree/operators.hpp"
+
+size_t ExpressionPool::NodeHash::operator()(const Node& node) const {
+	uint64_t hash = mixHash(node.token ^ static_cast<uint64_t>(node.op));
+	hash = mixHash(hash ^ node.first);
+	hash = mixHash(hash ^ (uint64_t{node.second} << 32));
+	return static_cast<size_t>(hash);
+}
+
+ExpressionPool::NodeId ExpressionPool::constant(double value) {
+	return internNode(Node{OpCode::Constant, noChild, noChild, std::bit_cast<uint64_t>(value)});
+}
+
+ExpressionPool::NodeId ExpressionPool::variable(size_t index) {
+	return internNode(Node{OpCode::Variable, noChild, noChild, index});
+}
+
+ExpressionPool::NodeId ExpressionPool::intern(OpCode op, NodeId first, NodeId second) {
+	assert(op != OpCode::Constant && op != OpCode::Variable);
+	assert(first < m_nodes.size() && (operandCount(op) == 1 ? second == noChild
+		: second < m_nodes.size()));
+	return internNode(Node{op, first, second, 0});
+}
+
+ExpressionPool::NodeId ExpressionPool::internNode(const Node& node) {
+	const auto [it, isInserted] = m_index.try_emplace(node, static_cast<NodeId>(m_nodes.size()));
+	if (isInserted) {
+		if (m_nodes.size() == noChild) {
+			m_index.erase(it);
+			throw std::runtime_error("ExpressionPool: too many nodes");
+		}
+		m_nodes.push_back(node);
+	}
+	return it->second;
+}
+
+ExpressionPool::NodeId ExpressionPool::intern(const Program& program) {
+	// Run the program with node indices in place of values
+	std::vector<NodeId> stack;
+	const double* constant = program.constants().begin();
+	const size_t* variable = program.variableIndices().begin();
+	for (const OpCode op : program.code()) {
+		switch (operandCount(op)) {
+		case 0:
+			stack.push_back(op == OpCode::Constant ? this->constant(*constant++)
+				: this->variable(*variable++));
+			break;
+		case 1:
+			stack.back() = intern(op, stack.back());
+			break;
+		default: {
+			const NodeId second = stack.back();
+			stack.pop_back();
+			stack.back() = intern(op, stack.back(), second);
+			break;
+		}
+		}
+	}
+	assert(stack.size() == 1);
+	return stack.empty() ? noChild : stack.back();
+}
+
+std::vector<bool> ExpressionPool::reachableNodes(NodeId root) const {
+	assert(root < m_nodes.size());
+
+	// The children have lower indices than their parents, so a single pass downwards marks all
+	// of the reachable nodes
+	std::vector<bool> isReachable(root + size_t{1});
+	isReachable[root] = true;
+	for (size_t id = root + size_t{1}; id-- > 0; ) {
+		if (isReachable[id]) {
+			const Node& node = m_nodes[id];
+			if (node.first != noChild) {
+				isReachable[node.first] = true;
+			}
+			if (node.second != noChild) {
+				isReachable[node.second] = true;
+			}
+		}
+	}
+	return isReachable;
+}
+
+ExpressionPool::Schedule ExpressionPool::schedule(NodeId root) const {
+	assert(root < m_nodes.size());
+
+	// Depth first with an explicit stack. A node goes back on the stack below its children and
+	// gets its step when it comes up again, after theirs
+	struct Entry {
+		NodeId id;
+		bool isExpanded;
+	};
+	Schedule result;
+	std::unordered_map<NodeId, std::uint32_t> steps;
+	std::vector<Entry> stack{{root, false}};
+	const auto stepOf = [&steps](NodeId child) {
+		return child == noChild ? noChild : steps.find(child)->second;
+	};
+	while (!stack.empty()) {
+		const Entry entry = stack.back();
+		stack.pop_back();
+		// Already reached through another parent
+		if (steps.contains(entry.id)) {
+			continue;
+		}
+		const Node& node = m_nodes[entry.id];
+		if (!entry.isExpanded) {
+			stack.push_back({entry.id, true});
+			for (const NodeId child : {node.second, node.first}) {
+				if (child != noChild && !steps.contains(child)) {
+					stack.push_back({child, false});
+				}
+			}
+			continue;
+		}
+		steps.emplace(entry.id, static_cast<std::uint32_t>(result.m_steps.size()));
+		result.m_steps.push_back({node.op, stepOf(node.first), stepOf(node.second), node.token,
+			0});
+	}
+	result.assignSlots();
+	return result;
+}
+
+void ExpressionPool::Schedule::assignSlots() {
+	// The last step that reads each step, `noChild` once its slot is free again
+	std::vector<std::uint32_t> lastReader(m_steps.size(), noChild);
+	for (size_t i = 0; i < m_steps.size(); ++i) {
+		for (const std::uint32_t child : {m_steps[i].first, m_steps[i].second}) {
+			if (child != noChild) {
+				lastReader[child] = static_cast<std::uint32_t>(i);
+			}
+		}
+	}
+
+	// The operands are freed before the result takes a slot, so that it may take the slot of one
+	// of them: every loop reads each value before it writes the result at the same position
+	std::vector<std::uint32_t> freeSlots;
+	m_slotCount = 0;
+	for (size_t i = 0; i < m_steps.size(); ++i) {
+		Step& step = m_steps[i];
+		for (std::uint32_t* child : {&step.first, &step.second}) {
+			if (*child == noChild) {
+				continue;
+			}
+			const std::uint32_t childStep = *child;
+			*child = m_steps[childStep].slot;
+			if (lastReader[childStep] == i) {
+				freeSlots.push_back(*child);
+				lastReader[childStep] = noChild;
+			}
+		}
+		if (freeSlots.empty()) {
+			step.slot = static_cast<std::uint32_t>(m_slotCount++);
+		}
+		else {
+			step.slot = freeSlots.back();
+			freeSlots.pop_back();
+		}
+	}
+}
+
+double ExpressionPool::Schedule::eval(ArrayView<const double> variables) const {
+	std::vector<double> slots(m_slotCount);
+	return eval(variables, {slots.data(), slots.size()});
+}
+
+double ExpressionPool::Schedule::eval(ArrayView<const double> variables,
+	ArrayView<double> slots) const
+{
+	assert(!m_steps.empty() && slots.size() >= m_slotCount);
+	for (const Step& step : m_steps) {
+		const auto first = [&slots, &step] { return slots[step.first]; };
+		const auto second = [&slots, &step] { return slots[step.second]; };
+		switch (step.op) {
+		case OpCode::Constant:
+			slots[step.slot] = std::bit_cast<double>(step.token);
+			break;
+		case OpCode::Variable:
+			assert(step.token < variables.size());
+			slots[step.slot] = variables[static_cast<size_t>(step.token)];
+			break;
+		case OpCode::Negate:
+			slots[step.slot] = -first();
+			break;
+		case OpCode::Add:
+			slots[step.slot] = first() + second();
+			break;
+		case OpCode::Subtract:
+			slots[step.slot] = first() - second();
+			break;
+		case OpCode::Multiply:
+			slots[step.slot] = first() * second();
+			break;
+		case OpCode::Divide:
+			slots[step.slot] = first() / second();
+			break;
+		case OpCode::Sin:
+			slots[step.slot] = std::sin(first());
+			break;
+		case OpCode::Cos:
+			slots[step.slot] = std::cos(first());
+			break;
+		case OpCode::Sqrt:
+			slots[step.slot] = std::sqrt(first());
+			break;
+		case OpCode::Pow:
+			slots[step.slot] = std::pow(first(), second());
+			break;
+		}
+	}
+	return slots[m_steps.back().slot];
+}
+
+void ExpressionPool::Schedule::evalBatch(ArrayView<const ArrayView<const double>> variables,
+	ArrayView<double> output) const
+{
+	std::unique_ptr<double[]> slots(new double[batchSlotsSize()]);
+	evalBatch(variables, output, {slots.get(), batchSlotsSize()});
+}
+
+BATCH_CLONES void ExpressionPool::Schedule::evalBatch(
+	ArrayView<const ArrayView<const double>> variables, ArrayView<double> output,
+	ArrayView<double> slots) const
+{
+	assert(!m_steps.empty() && slots.size() >= batchSlotsSize());
+	constexpr size_t blockSize = Program::batchBlockSize;
+
+	// The slots hold blocks of values instead of values, the block of the slot `i` starting at
+	// `i * blockSize`
+	const auto block = [&slots](size_t index) {
+		return slots.data() + index * blockSize;
+	};
+
+	for (size_t begin = 0; begin < output.size(); begin += blockSize) {
+		const size_t count = std::min(blockSize, output.size() - begin);
+		for (const Step& step : m_steps) {
+			double* result = block(step.slot);
+			const double* first = step.first != noChild ? block(step.first) : nullptr;
+			const double* second = step.second != noChild ? block(step.second) : nullptr;
+			switch (step.op) {
+			case OpCode::Constant:
+				std::fill_n(result, blockSize, std::bit_cast<double>(step.token));
+				break;
+			case OpCode::Variable: {
+				assert(step.token < variables.size());
+				const ArrayView<const double>& column = variables[static_cast<size_t>(step.token)];
+				assert(column.size() >= output.size());
+				std::copy_n(column.data() + begin, count, result);
+				// Pad the last block with copies of its last row, as `Program::evalBatch()` does
+				std::fill(result + count, result + blockSize, result[count - 1]);
+				break;
+			}
+			case OpCode::Negate:
+				applyUnaryBlock(result, first, [](double x) { return -x; });
+				break;
+			case OpCode::Add:
+				applyBinaryBlock(result, first, second,
+					[](double x, double y) { return x + y; });
+				break;
+			case OpCode::Subtract:
+				applyBinaryBlock(result, first, second,
+					[](double x, double y) { return x - y; });
+				break;
+			case OpCode::Multiply:
+				applyBinaryBlock(result, first, second,
+					[](double x, double y) { return x * y; });
+				break;
+			case OpCode::Divide:
+				applyBinaryBlock(result, first, second,
+					[](double x, double y) { return x / y; });
+				break;
+			case OpCode::Sin:
+				applyUnaryBlock(result, first, [](double x) { return std::sin(x); });
+				break;
+			case OpCode::Cos:
+				applyUnaryBlock(result, first, [](double x) { return std::cos(x); });
+				break;
+			case OpCode::Sqrt:
+				applyUnaryBlock(result, first, [](double x) { return std::sqrt(x); });
+				break;
+			case OpCode::Pow:
+				applyBinaryBlock(result, first, second,
+					[](double x, double y) { return std::pow(x, y); });
+				break;
+			}
+		}
+		std::copy_n(block(m_steps.back().slot), count, output.data() + begin);
+	}
+}
+
+std::unique_ptr<Expression> ExpressionPool::toExpression(NodeId root,
+	ArrayView<const std::string_view> variableNames) const
+{
+	assert(root < m_nodes.size());
+
+	// Depth first with an explicit stack as in `schedule()`, but a node shared by several
+	// parents is expanded again for each of them. The expanded subtrees wait on `finished`, the
+	// children of the next node to make on the top
+	struct Entry {
+		NodeId id;
+		bool isExpanded;
+	};
+	std::vector<std::unique_ptr<Expression>> finished;
+	std::vector<Entry> stack{{root, false}};
+	const auto takeFinished = [&finished] {
+		std::unique_ptr<Expression> subtree = std::move(finished.back());
+		finished.pop_back();
+		return subtree;
+	};
+	while (!stack.empty()) {
+		const Entry entry = stack.back();
+		stack.pop_back();
+		const Node& node = m_nodes[entry.id];
+		if (!entry.isExpanded && operandCount(node.op) > 0) {
+			stack.push_back({entry.id, true});
+			for (const NodeId child : {node.second, node.first}) {
+				if (child != noChild) {
+					stack.push_back({child, false});
+				}
+			}
+			continue;
+		}
+
+		std::unique_ptr<Expression> second = operandCount(node.op) == 2 ? takeFinished() : nullptr;
+		std::unique_ptr<Expression> first = operandCount(node.op) > 0 ? takeFinished() : nullptr;
+		switch (node.op) {
+		case OpCode::Constant:
+			finished.push_back(std::make_unique<Number>(std::bit_cast<double>(node.token)));
+			break;
+		case OpCode::Variable: {
+			const size_t index = static_cast<size_t>(node.token);
+			finished.push_back(std::make_unique<Variable>(index,
+				index < variableNames.size() ? std::string(variableNames[index]) : std::string()));
+			break;
+		}
+		case OpCode::Negate:
+			finished.push_back(std::make_unique<Negation>(std::move(first)));
+			break;
+		case OpCode::Add:
+			finished.push_back(std::make_unique<Addition>(std::move(first), std::move(second)));
+			break;
+		case OpCode::Subtract:
+			finished.push_back(std::make_unique<Subtraction>(std::move(first), std::move(second)));
+			break;
+		case OpCode::Multiply:
+			finished.push_back(std::make_unique<Multiplication>(std::move(first),
+				std::move(second)));
+			break;
+		case OpCode::Divide:
+			finished.push_back(std::make_unique<Division>(std::move(first), std::move(second)));
+			break;
+		case OpCode::Sin:
+			finished.push_back(std::make_unique<Sin>(std::move(first)));
+			break;
+		case OpCode::Cos:
+			finished.push_back(std::make_unique<Cos>(std::move(first)));
+			break;
+		case OpCode::Sqrt:
+			finished.push_back(std::make_unique<Sqrt>(std::move(first)));
+			break;
+		case OpCode::Pow:
+			finished.push_back(std::make_unique<Pow>(std::move(first), std::move(second)));
+			break;
+		}
+	}
+	assert(finished.size() == 1);
+	return finished.empty() ? nullptr : std::move(finished.back());
+}
+
+size_t ExpressionPool::sizeBytes() const {
+	// A node of a `std::unordered_map` holds the key, the value and a link, plus the bucket array
+	const size_t indexNodeBytes = sizeof(Node) + sizeof(NodeId) + 2 * sizeof(void*);
+	return m_nodes.capacity() * sizeof(Node) + m_index.size() * indexNodeBytes
+		+ m_index.bucket_count() * sizeof(void*);
+}
@@ -0,0 +1,171 @@
+#ifndef EXPRESSION_POOL_HPP_INCLUDED
+#define EXPRESSION_POOL_HPP_INCLUDED
+
+#include <cstddef>
+#include <cstdint>
+
+#include <memory>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "array_view/array_view.hpp"
+#include "expression_tree/bytecode.hpp"
+#include "expression_tree/expression.hpp"
+
+/// @brief A store of hash-consed expression nodes: every node is interned by its kind, its token
+/// (the value of a number, the index of a variable) and its children, so structurally identical
+/// subtrees become a single shared node and the expressions form a DAG instead of trees.
+///
+/// The nodes are identified by their indices and are never removed. A node is always interned
+/// after its children, so the indices are in topological order
+class ExpressionPool {
+public:
+	using NodeId = std::uint32_t;
+
+	/// @brief The child of a node that doesn't have that many children
+	static constexpr NodeId noChild = UINT32_MAX;
+
+	struct Node {
+		/// @brief The kind of the node, as the instruction that would compute it
+		OpCode op;
+		NodeId first = noChild;
+		NodeId second = noChild;
+		/// @brief The bits of the value of `OpCode::Constant`, the index of `OpCode::Variable`
+		std::uint64_t token = 0;
+
+		friend bool operator==(const Node& a, const Node& b) = default;
+	};
+
+	/// @brief The nodes reachable from one root, compiled into steps in an order where the
+	/// children come first. Every step keeps its value in a slot until its last parent has read
+	/// it, so a node shared by several parents is computed once and read from its slot by all of
+	/// them. The slots are then reused by the later steps, as many being needed as the values
+	/// live at the same time
+	class Schedule {
+	public:
+		/// @brief The number of the steps, one per reachable node
+		size_t size() const {
+			return m_steps.size();
+		}
+
+		/// @brief The number of the slots, at most `size()`
+		size_t slotCount() const {
+			return m_slotCount;
+		}
+
+		/// @brief Evaluate the expression, allocating the slots
+		/// @pre `variables` has a value for every variable of the expression
+		double eval(ArrayView<const double> variables = {}) const;
+		/// @brief Evaluate the expression using `slots` for the values of the nodes, without any
+		/// allocations
+		/// @pre `slots.size() >= slotCount()`
+		double eval(ArrayView<const double> variables, ArrayView<double> slots) const;
+
+		/// @brief Evaluate the expression for every row of a table of inputs, as
+		/// `Program::evalBatch()` does: every step is run over a block of
+		/// `Program::batchBlockSize` rows before the next one. The results are the same as those
+		/// of `eval()` row by row
+		/// @param variables The columns of the variables, `variables[j]` holding the values of
+		/// the variable `j` for all rows
+		/// @pre `variables` has a column for every variable of the expression, and every column
+		/// has at least `output.size()` values
+		void evalBatch(ArrayView<const ArrayView<const double>> variables,
+			ArrayView<double> output) const;
+		/// @brief Run `evalBatch()` using `slots` for the blocks of the values of the nodes,
+		/// without any allocations
+		/// @pre `slots.size() >= batchSlotsSize()`
+		void evalBatch(ArrayView<const ArrayView<const double>> variables,
+			ArrayView<double> output, ArrayView<double> slots) const;
+
+		/// @brief The size of the slots of `evalBatch()`: a block of values per slot
+		size_t batchSlotsSize() const {
+			return m_slotCount * Program::batchBlockSize;
+		}
+
+	private:
+		friend class ExpressionPool;
+
+		struct Step {
+			OpCode op;
+			/// @brief The slots of the children, `noChild` for those the node doesn't have
+			std::uint32_t first;
+			std::uint32_t second;
+			/// @brief As `Node::token`
+			std::uint64_t token;
+			/// @brief The slot of the value of the step
+			std::uint32_t slot;
+		};
+
+		/// @brief Turn the children of the steps from step indices into slots, and give every
+		/// step the slot of a value read for the last time by a step before, or by itself
+		void assignSlots();
+
+		std::vector<Step> m_steps;
+		size_t m_slotCount = 0;
+	};
+
+	NodeId constant(double value);
+	NodeId variable(size_t index);
+	/// @brief Intern an operation or a function of the given nodes
+	/// @pre `op` is neither `OpCode::Constant` nor `OpCode::Variable`, and the children are
+	/// nodes of this pool, as many as `operandCount(op)`
+	/// @throws std::runtime_error if the pool runs out of the node indices
+	NodeId intern(OpCode op, NodeId first, NodeId second = noChild);
+
+	/// @brief Intern the expression computed by a program made by `compile()`, and all of its
+	/// subexpressions. Returns the root
+	NodeId intern(const Program& program);
+	/// @pre `expr.isComplete()`
+	NodeId intern(const Expression& expr) {
+		return intern(compile(expr));
+	}
+
+	const Node& operator[](NodeId id) const {
+		return m_nodes[id];
+	}
+
+	/// @brief Make the schedule of the expression rooted at `root`. Only the nodes reachable from
+	/// `root` are visited, however large the rest of the pool is
+	Schedule schedule(NodeId root) const;
+
+	/// @brief Evaluate the expression rooted at `root`, computing every node reachable from it
+	/// exactly once, however many times it occurs in the expression. To evaluate the same root
+	/// many times, make its `schedule()` once instead
+	/// @pre `variables` has a value for every variable reachable from `root`
+	double eval(NodeId root, ArrayView<const double> variables = {}) const {
+		return schedule(root).eval(variables);
+	}
+
+	/// @brief Mark the nodes reachable from `root`: the result has `root + 1` elements, indexed by
+	/// the node
+	std::vector<bool> reachableNodes(NodeId root) const;
+
+	/// @brief Expand the DAG rooted at `root` back to a tree, copying the shared nodes
+	/// @param variableNames The names of the variables by their indices. The pool doesn't keep
+	/// the names, the variables past the end get their default names
+	/// @note Iterative, any depth of the tree is fine
+	std::unique_ptr<Expression> toExpression(NodeId root,
+		ArrayView<const std::string_view> variableNames = {}) const;
+
+	/// @brief The number of distinct nodes
+	size_t size() const {
+		return m_nodes.size();
+	}
+
+	/// @brief The memory taken by the nodes and an estimate of the memory of the index
+	size_t sizeBytes() const;
+
+private:
+	struct NodeHash {
+		size_t operator()(const Node& node) const;
+	};
+
+	/// @brief Find the node or add it as a new one
+	NodeId internNode(const Node& node);
+
+	std::vector<Node> m_nodes;
+	std::unordered_map<Node, NodeId, NodeHash> m_index;
+};
+
+#endif
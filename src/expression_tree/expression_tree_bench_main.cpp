@@ -0,0 +1,157 @@
+#include <algorithm>
+#include <memory>
+#include <optional>
+#include <ostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "benchmark/benchmark.hpp"
+#include "expression_tree/dynamic_cast_eval.hpp"
+#include "expression_tree/expression.hpp"
+#include "expression_tree/functions.hpp"
+#include "expression_tree/operators.hpp"
+#include "expression_tree/variant_expression.hpp"
+
+namespace {
+
+/// @brief The number of variables of the random trees
+constexpr size_t variableCount = 4;
+
+/// @brief Roughly the number of nodes evaluated by one iteration of every benchmark
+constexpr size_t nodesPerRun = size_t{1} << 21;
+
+std::unique_ptr<Expression> makeLeaf(std::mt19937& random) {
+	if (random() % 2 == 0) {
+		return std::make_unique<Variable>(random() % variableCount);
+	}
+	return std::make_unique<Number>(std::uniform_real_distribution<double>(0.5, 1.5)(random));
+}
+
+/// @brief A random arithmetic node over the given children, a negation one time in six. The
+/// functions are left out: their cost in the C library would hide the cost of the dispatch
+std::unique_ptr<Expression> makeOperation(std::unique_ptr<Expression> first,
+	std::unique_ptr<Expression> second, std::mt19937& random)
+{
+	switch (random() % 6) {
+	case 0:
+		return std::make_unique<Addition>(std::move(first), std::move(second));
+	case 1:
+		return std::make_unique<Subtraction>(std::move(first), std::move(second));
+	case 2:
+		return std::make_unique<Multiplication>(std::move(first), std::move(second));
+	case 3:
+		return std::make_unique<Division>(std::move(first), std::move(second));
+	case 4:
+		return std::make_unique<Addition>(std::move(first),
+			std::make_unique<Negation>(std::move(second)));
+	default:
+		return std::make_unique<Multiplication>(std::move(first), std::move(second));
+	}
+}
+
+/// @brief A complete binary tree of the given depth
+std::unique_ptr<Expression> makeBalancedTree(int depth, std::mt19937& random) {
+	if (depth == 0) {
+		return makeLeaf(random);
+	}
+	std::unique_ptr<Expression> first = makeBalancedTree(depth - 1, random);
+	return makeOperation(std::move(first), makeBalancedTree(depth - 1, random), random);
+}
+
+/// @brief A degenerate tree with `length` operations, every one with a leaf on one side
+std::unique_ptr<Expression> makeChain(int length, std::mt19937& random) {
+	std::unique_ptr<Expression> result = makeLeaf(random);
+	for (int i = 0; i < length; ++i) {
+		result = random() % 2 == 0 ? makeOperation(std::move(result), makeLeaf(random), random)
+			: makeOperation(makeLeaf(random), std::move(result), random);
+	}
+	return result;
+}
+
+/// @brief A tree of at most the given depth, where every node below the root is a leaf with
+/// the probability 1/3: a bushy tree of uneven branches
+std::unique_ptr<Expression> makeRandomTree(int depth, std::mt19937& random, bool isRoot = true) {
+	if (depth == 0 || (!isRoot && random() % 3 == 0)) {
+		return makeLeaf(random);
+	}
+	std::unique_ptr<Expression> first = makeRandomTree(depth - 1, random, false);
+	return makeOperation(std::move(first), makeRandomTree(depth - 1, random, false), random);
+}
+
+/// @brief Time the four evaluation strategies on `expr`: the virtual `eval()`, the cascade of
+/// `dynamic_cast`, `std::visit` on the variant tree and the bytecode interpreter
+void benchmarkTree(BenchmarkSuite& suite, const char* shape, int size,
+	const Expression& expr, std::ostream& log)
+{
+	const Program program = compile(expr);
+	const std::unique_ptr<VariantExpression> variant = VariantExpression::fromProgram(program);
+	const size_t nodeCount = program.code().size();
+	const size_t evaluationCount = std::max<size_t>(nodesPerRun / nodeCount, 1);
+
+	// A different point for every evaluation, so the results can't be reused
+	std::mt19937 random(1);
+	std::vector<double> points(evaluationCount * variableCount);
+	for (double& value : points) {
+		value = std::uniform_real_distribution<double>(0.5, 1.5)(random);
+	}
+	const auto pointAt = [&points](size_t i) {
+		return ArrayView<const double>(points.data() + i * variableCount, variableCount);
+	};
+
+	const auto labels = [shape, size, nodeCount](const char* strategy) {
+		return BenchmarkSuite::Labels{
+			{"strategy", strategy},
+			{"shape", shape},
+			{"size", std::to_string(size)},
+			{"nodes", std::to_string(nodeCount)},
+		};
+	};
+	const auto run = [&](const char* strategy, auto evaluate) {
+		BenchmarkSuite::writeSummary(log,
+			suite.run(labels(strategy), evaluationCount * nodeCount, [&] {
+				double sum = 0;
+				for (size_t i = 0; i < evaluationCount; ++i) {
+					sum += evaluate(pointAt(i));
+				}
+				doNotOptimize(sum);
+			}));
+	};
+
+	run("virtual", [&expr](ArrayView<const double> variables) {
+		return expr.eval(variables);
+	});
+	run("dynamic_cast", [&expr](ArrayView<const double> variables) {
+		return evalDynamicCast(expr, variables);
+	});
+	run("variant", [&variant](ArrayView<const double> variables) {
+		return variant->eval(variables);
+	});
+	run("bytecode", [&program](ArrayView<const double> variables) {
+		return program.eval(variables);
+	});
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+	const std::optional<BenchmarkCommandLine> commandLine = parseBenchmarkCommandLine(argc, argv);
+	if (!commandLine) {
+		return 1;
+	}
+
+	std::ostream& log = commandLine->log();
+	BenchmarkSuite suite(commandLine->options);
+	std::mt19937 random(42);
+	for (const int depth : {3, 6, 10, 14, 18}) {
+		benchmarkTree(suite, "balanced", depth, *makeBalancedTree(depth, random), log);
+	}
+	for (const int length : {8, 64, 1024, 16384}) {
+		benchmarkTree(suite, "chain", length, *makeChain(length, random), log);
+	}
+	for (const int depth : {8, 16, 24}) {
+		benchmarkTree(suite, "random", depth, *makeRandomTree(depth, random), log);
+	}
+
+	return commandLine->writeJson(suite) ? 0 : 1;
+}
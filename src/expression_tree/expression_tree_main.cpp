@@ -1,59 +1,34 @@
 #include <cerrno>
 #include <cfenv>
+#include <cmath>
 #include <cstring>
 
+#include <algorithm>
+#include <bit>
+#include <chrono>
 #include <iostream>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <thread>
+#include <string_view>
+#include <vector>
 
 #include "expression_tree/expression.hpp"
 #include "expression_tree/operators.hpp"
 #include "expression_tree/functions.hpp"
-
-/// @brief Equivalent to `expr.eval()` but implemented using `dynamic_cast` instead of virtual
-/// functions
-/// @pre expr.isComlete()
-static double eval(const Expression& expr) {
-	if (const Number* number = dynamic_cast<const Number*>(&expr)) {
-		return number->eval();
-	}
-
-	if (const Negation* operation = dynamic_cast<const Negation*>(&expr)) {
-		return -eval(*operation->first());
-	}
-
-	if (const Addition* operation = dynamic_cast<const Addition*>(&expr)) {
-		return eval(*operation->first()) + eval(*operation->second());
-	}
-
-	if (const Subtraction* operation = dynamic_cast<const Subtraction*>(&expr)) {
-		return eval(*operation->first()) - eval(*operation->second());
-	}
-
-	if (const Multiplication* operation = dynamic_cast<const Multiplication*>(&expr)) {
-		return eval(*operation->first()) * eval(*operation->second());
-	}
-
-	if (const Division* operation = dynamic_cast<const Division*>(&expr)) {
-		return eval(*operation->first()) / eval(*operation->second());
-	}
-
-	if (const Sin* func = dynamic_cast<const Sin*>(&expr)) {
-		return std::sin(eval(*func->first()));
-	}
-
-	if (const Cos* func = dynamic_cast<const Cos*>(&expr)) {
-		return std::cos(eval(*func->first()));
-	}
-
-	if (const Sqrt* func = dynamic_cast<const Sqrt*>(&expr)) {
-		return std::sqrt(eval(*func->first()));
-	}
-
-	if (const Pow* func = dynamic_cast<const Pow*>(&expr)) {
-		return std::pow(eval(*func->first()), eval(*func->second()));
-	}
-
-	return std::nan("0");
-}
+#include "expression_tree/derivative.hpp"
+#include "expression_tree/dynamic_cast_eval.hpp"
+#include "expression_tree/expression_arena.hpp"
+#include "expression_tree/expression_pool.hpp"
+#include "expression_tree/gradient.hpp"
+#include "expression_tree/interval.hpp"
+#include "expression_tree/native_program.hpp"
+#include "expression_tree/parallel_eval.hpp"
+#include "expression_tree/parser.hpp"
+#include "expression_tree/serialization.hpp"
+#include "expression_tree/simplify.hpp"
+#include "expression_tree/variant_expression.hpp"
 
 static void printNpn(const Expression& expr, std::ostream& output) {
 	expr.printToken(output);
@@ -95,16 +70,8 @@ static void printRpn(const Expression& expr, std::ostream& output) {
 	expr.printToken(output);
 }
 
-static void printEvalResultChecked(const Expression& expr) {
-	if (!expr.isComplete()) {
-		std::cout << "Error: Invalid expression.\n";
-		return;
-	}
-	errno = 0;
-	std::feclearexcept(FE_ALL_EXCEPT);
-	std::cout << "Result (virtual method): " << expr.eval() << "\n";
-	std::cout << "Result (free function): " << eval(expr) << "\n";
-	const int feFlags = std::fetestexcept(FE_DIVBYZERO | FE_INVALID | FE_OVERFLOW | FE_UNDERFLOW);
+/// @brief Print the floating point exceptions raised by an evaluation, if any
+static void printNumericalErrors(int feFlags) {
 	if (feFlags) {
 		std::cout << "Numerical error(s) detected:";
 		if (feFlags & FE_INVALID) {
@@ -123,6 +90,20 @@ static void printEvalResultChecked(const Expression& expr) {
 	}
 }
 
+static void printEvalResultChecked(const Expression& expr) {
+	if (!expr.isComplete()) {
+		std::cout << "Error: Invalid expression.\n";
+		return;
+	}
+	errno = 0;
+	std::feclearexcept(FE_ALL_EXCEPT);
+	std::cout << "Result (virtual method): " << expr.eval() << "\n";
+	std::cout << "Result (free function): " << evalDynamicCast(expr) << "\n";
+	std::cout << "Result (bytecode): " << compile(expr).eval() << "\n";
+	std::cout << "Result (native code): " << NativeProgram(compile(expr)).eval() << "\n";
+	printNumericalErrors(std::fetestexcept(FE_DIVBYZERO | FE_INVALID | FE_OVERFLOW | FE_UNDERFLOW));
+}
+
 static void testExpression(const Expression& expr) {
 	std::cout << "Infix notation: ";
 	expr.printInfixRecursive(std::cout);
@@ -136,9 +117,886 @@ static void testExpression(const Expression& expr) {
 	printRpn(expr, std::cout);
 	std::cout << '\n';
 
+	std::cout << "Bytecode:\n" << compile(expr);
+
 	printEvalResultChecked(expr);
 }
 
+/// @brief Print `expr` simplified with the exact and with the fast math rules, and the values
+/// of the three for `variables`
+static void testSimplify(const Expression& expr, ArrayView<const double> variables) {
+	std::cout << "Infix notation: ";
+	expr.printInfixRecursive(std::cout);
+	std::cout << "\nResult: " << expr.eval(variables) << '\n';
+
+	const std::unique_ptr<Expression> exact = simplify(expr.clone());
+	std::cout << "Simplified: ";
+	exact->printInfixRecursive(std::cout);
+	std::cout << "\nResult: " << exact->eval(variables) << '\n';
+
+	const std::unique_ptr<Expression> fast =
+		simplify(expr.clone(), {.rules = fastMathRewriteRules()});
+	std::cout << "Simplified with fast math: ";
+	fast->printInfixRecursive(std::cout);
+	std::cout << "\nResult: " << fast->eval(variables) << '\n';
+}
+
+/// @brief Build a random tree of the given depth. The leaves are close to 1, so that the values
+/// stay finite
+static std::unique_ptr<Expression> makeRandomTree(int depth, std::mt19937& random) {
+	if (depth == 0) {
+		return std::make_unique<Number>(std::uniform_real_distribution<double>(0.5, 1.5)(random));
+	}
+
+	switch (random() % 6) {
+	case 0:
+		return std::make_unique<Addition>(makeRandomTree(depth - 1, random),
+			makeRandomTree(depth - 1, random));
+	case 1:
+		return std::make_unique<Subtraction>(makeRandomTree(depth - 1, random),
+			makeRandomTree(depth - 1, random));
+	case 2:
+		return std::make_unique<Multiplication>(makeRandomTree(depth - 1, random),
+			makeRandomTree(depth - 1, random));
+	case 3:
+		return std::make_unique<Division>(makeRandomTree(depth - 1, random),
+			makeRandomTree(depth - 1, random));
+	case 4:
+		return std::make_unique<Sin>(makeRandomTree(depth - 1, random));
+	default:
+		return std::make_unique<Negation>(makeRandomTree(depth - 1, random));
+	}
+}
+
+/// @brief Build `1 + 0.5 * (1 + 0.5 * (... * 1))` with `length` levels of constants only: a
+/// degenerate tree as deep as it is large
+static std::unique_ptr<Expression> makeDeepChain(size_t length) {
+	std::unique_ptr<Expression> result = std::make_unique<Number>(1);
+	for (size_t i = 0; i < length; ++i) {
+		result = std::make_unique<Addition>(std::make_unique<Number>(1),
+			std::make_unique<Multiplication>(std::make_unique<Number>(0.5), std::move(result)));
+	}
+	return result;
+}
+
+/// @brief `x0 + 1 + 1 + ...` with `length` additions, every one the left operand of the next:
+/// the shape of the long sums the generated formulas are made of
+static std::unique_ptr<Expression> makeLeftDeepSum(size_t length) {
+	std::unique_ptr<Expression> result = std::make_unique<Variable>(0);
+	for (size_t i = 0; i < length; ++i) {
+		result = std::make_unique<Addition>(std::move(result), std::make_unique<Number>(1));
+	}
+	return result;
+}
+
+/// @brief `1 - (1 - (... - x0))` with `length` subtractions, every one the right operand of the
+/// next, so the program keeps them all on its stack
+static std::unique_ptr<Expression> makeRightDeepDifference(size_t length) {
+	std::unique_ptr<Expression> result = std::make_unique<Variable>(0);
+	for (size_t i = 0; i < length; ++i) {
+		result = std::make_unique<Subtraction>(std::make_unique<Number>(1), std::move(result));
+	}
+	return result;
+}
+
+/// @brief Evaluate `expr` with the variables taken from the columns for every row: by the tree,
+/// by the program row by row and by the program in blocks of rows
+static void benchmarkBatchEvaluation(const Expression& expr,
+	const std::vector<std::vector<double>>& columns)
+{
+	using Seconds = std::chrono::duration<double>;
+	const size_t rowCount = columns.front().size();
+	const Program program = compile(expr);
+	std::vector<double> row(columns.size());
+	const auto measure = [&](const char* name, auto evaluate) {
+		std::vector<double> output(rowCount);
+		const auto start = std::chrono::steady_clock::now();
+		evaluate(output);
+		const double seconds = Seconds(std::chrono::steady_clock::now() - start).count();
+		std::cout << "  " << name << ": " << seconds / static_cast<double>(rowCount) * 1e9
+			<< " ns/row\n";
+		return output;
+	};
+
+	const std::vector<double> treeOutput = measure("virtual eval()", [&](auto& output) {
+		for (size_t i = 0; i < rowCount; ++i) {
+			for (size_t j = 0; j < columns.size(); ++j) {
+				row[j] = columns[j][i];
+			}
+			output[i] = expr.eval({row.begin(), row.end()});
+		}
+	});
+	const std::vector<double> programOutput = measure("bytecode by rows", [&](auto& output) {
+		for (size_t i = 0; i < rowCount; ++i) {
+			for (size_t j = 0; j < columns.size(); ++j) {
+				row[j] = columns[j][i];
+			}
+			output[i] = program.eval({row.begin(), row.end()});
+		}
+	});
+	const NativeProgram native(program);
+	const std::vector<double> nativeOutput = measure("native code by rows", [&](auto& output) {
+		for (size_t i = 0; i < rowCount; ++i) {
+			for (size_t j = 0; j < columns.size(); ++j) {
+				row[j] = columns[j][i];
+			}
+			output[i] = native.eval({row.begin(), row.end()});
+		}
+	});
+	const std::vector<double> batchOutput = measure("bytecode by blocks", [&](auto& output) {
+		std::vector<ArrayView<const double>> views;
+		for (const std::vector<double>& column : columns) {
+			views.emplace_back(column.begin(), column.end());
+		}
+		program.evalBatch({views.begin(), views.end()}, {output.begin(), output.end()});
+	});
+	const std::vector<double> vectorizedOutput = measure("bytecode by blocks, vectorized math",
+		[&](auto& output) {
+			std::vector<ArrayView<const double>> views;
+			for (const std::vector<double>& column : columns) {
+				views.emplace_back(column.begin(), column.end());
+			}
+			program.evalBatch({views.begin(), views.end()}, {output.begin(), output.end()},
+				MathKernels::Vectorized);
+		});
+	std::cout << "  Same results: " << std::boolalpha
+		<< (treeOutput == programOutput && treeOutput == nativeOutput && treeOutput == batchOutput)
+		<< '\n';
+	double largestDifference = 0;
+	for (size_t i = 0; i < rowCount; ++i) {
+		if (batchOutput[i] != vectorizedOutput[i]) {
+			largestDifference = std::max(largestDifference,
+				std::abs(vectorizedOutput[i] - batchOutput[i]) / std::abs(batchOutput[i]));
+		}
+	}
+	std::cout << "  Largest relative difference of the vectorized math: " << largestDifference
+		<< '\n';
+}
+
+/// @brief Build a tree of the given depth out of few distinct subtrees: every level combines
+/// copies of `width` random expressions of the level below
+static std::unique_ptr<Expression> makeRepetitiveTree(int depth, size_t width,
+	std::mt19937& random)
+{
+	std::vector<std::unique_ptr<Expression>> level;
+	for (size_t i = 0; i < width; ++i) {
+		if (i % 2 == 0) {
+			level.push_back(std::make_unique<Variable>(i / 2 % 4));
+		}
+		else {
+			level.push_back(std::make_unique<Number>(static_cast<double>(i)));
+		}
+	}
+
+	for (int i = 0; i < depth; ++i) {
+		std::vector<std::unique_ptr<Expression>> next;
+		for (size_t j = 0; j < width; ++j) {
+			std::unique_ptr<Expression> first = level[random() % width]->clone();
+			std::unique_ptr<Expression> second = level[random() % width]->clone();
+			switch (random() % 4) {
+			case 0:
+				next.push_back(std::make_unique<Addition>(std::move(first), std::move(second)));
+				break;
+			case 1:
+				next.push_back(std::make_unique<Subtraction>(std::move(first),
+					std::move(second)));
+				break;
+			case 2:
+				next.push_back(std::make_unique<Multiplication>(std::move(first),
+					std::move(second)));
+				break;
+			default:
+				next.push_back(std::make_unique<Sin>(std::move(first)));
+				break;
+			}
+		}
+		level = std::move(next);
+	}
+	return std::move(level.front());
+}
+
+/// @brief The memory taken by the nodes of a tree, without the overhead of the allocator
+static size_t treeSizeBytes(const Expression& expr) {
+	size_t bytes =
+		dynamic_cast<const Variable*>(&expr) ? sizeof(Variable) :
+		expr.arity() == 0 ? sizeof(Number) :
+		expr.arity() == 1 ? sizeof(Negation) :
+		sizeof(Addition);
+	for (size_t i = 0; i < expr.arity(); ++i) {
+		bytes += treeSizeBytes(*expr.child(i));
+	}
+	return bytes;
+}
+
+/// @brief Compare the memory and the evaluation speed of a tree and of its hash-consed DAG
+static void benchmarkPool(const char* name, const Expression& expr, size_t repetitions) {
+	using Seconds = std::chrono::duration<double>;
+	const auto measure = [repetitions](auto evaluate) {
+		double sum = 0;
+		const auto start = std::chrono::steady_clock::now();
+		for (size_t i = 0; i < repetitions; ++i) {
+			sum += evaluate();
+		}
+		const double seconds = Seconds(std::chrono::steady_clock::now() - start).count();
+		return std::pair{seconds / static_cast<double>(repetitions), sum};
+	};
+
+	ExpressionPool pool;
+	const ExpressionPool::NodeId root = pool.intern(expr);
+	const double variables[] = {0.5, 1.5, 2.5, 3.5};
+
+	std::cout << name << ":\n";
+	std::cout << "  Tree: " << compile(expr).code().size() << " nodes, "
+		<< treeSizeBytes(expr) / 1024 << " KiB\n";
+	std::cout << "  DAG: " << pool.size() << " nodes, " << pool.sizeBytes() / 1024 << " KiB\n";
+
+	const auto [treeSeconds, treeSum] = measure([&expr, &variables] {
+		return expr.eval(variables);
+	});
+	// The schedule and the slots are made once and reused by every evaluation
+	const ExpressionPool::Schedule schedule = pool.schedule(root);
+	std::vector<double> slots(schedule.slotCount());
+	const auto [poolSeconds, poolSum] = measure([&schedule, &slots, &variables] {
+		return schedule.eval(variables, {slots.data(), slots.size()});
+	});
+	std::cout << "  virtual eval(): " << treeSeconds * 1e6 << " us\n";
+	std::cout << "  DAG schedule: " << schedule.size() << " steps, " << schedule.slotCount()
+		<< " slots\n";
+	std::cout << "  DAG eval(): " << poolSeconds * 1e6 << " us, "
+		<< treeSeconds / poolSeconds << "x faster\n";
+	std::cout << "  Same results: " << std::boolalpha << (treeSum == poolSum) << '\n';
+
+	// A small expression added last is scheduled by its own nodes, not by the whole pool
+	const ExpressionPool::NodeId small = pool.intern(OpCode::Add, pool.variable(0),
+		pool.constant(0.25));
+	std::cout << "  A small expression added to the pool: " << pool.schedule(small).size()
+		<< " of " << pool.size() << " nodes scheduled, value " << pool.eval(small, variables)
+		<< '\n';
+}
+
+/// @brief Compare building, evaluating and destroying a random tree with the nodes on the heap
+/// and in an arena, with the destructors or released from its owner and dropped by `discard()`
+static void benchmarkArena(int depth) {
+	using Seconds = std::chrono::duration<double>;
+	const auto run = [depth](const char* name, ExpressionArena* arena, bool isReleased) {
+		std::mt19937 random(4);
+		auto start = std::chrono::steady_clock::now();
+		std::unique_ptr<Expression> expr;
+		if (arena) {
+			ExpressionArena::Scope scope(*arena);
+			expr = makeRandomTree(depth, random);
+		}
+		else {
+			expr = makeRandomTree(depth, random);
+		}
+		const double buildSeconds = Seconds(std::chrono::steady_clock::now() - start).count();
+
+		start = std::chrono::steady_clock::now();
+		double sum = 0;
+		for (int i = 0; i < 10; ++i) {
+			sum += expr->eval();
+		}
+		const double evalSeconds = Seconds(std::chrono::steady_clock::now() - start).count() / 10;
+
+		const size_t nodeCount = compile(*expr).code().size();
+		start = std::chrono::steady_clock::now();
+		if (isReleased) {
+			// The random trees have no names of their own, the nodes own nothing but the arena
+			static_cast<void>(expr.release());
+		}
+		expr.reset();
+		if (arena) {
+			arena->discard();
+		}
+		const double destroySeconds = Seconds(std::chrono::steady_clock::now() - start).count();
+
+		std::cout << "  " << name << " (" << nodeCount << " nodes): build "
+			<< buildSeconds * 1e3 << " ms, eval " << evalSeconds * 1e3 << " ms, destroy "
+			<< destroySeconds * 1e3 << " ms, result " << sum / 10 << '\n';
+	};
+
+	run("Heap", nullptr, false);
+	ExpressionArena arena;
+	run("Arena", &arena, false);
+	run("Arena, released", &arena, true);
+}
+
+/// @brief Parse `text` and print the expression and its value, or the error
+static void testParse(std::string_view text, ArrayView<const std::string_view> variableNames,
+	ArrayView<const double> variables)
+{
+	std::cout << "\"" << text << "\" -> ";
+	try {
+		const std::unique_ptr<Expression> expr = parseExpression(text, variableNames);
+		expr->printInfixRecursive(std::cout);
+		std::cout << " = " << expr->eval(variables) << '\n';
+	}
+	catch (const ParseError& error) {
+		std::cout << "Error: " << error.what() << '\n';
+	}
+}
+
+/// @brief Parse many random formulas, one per line, with the nodes on the heap and in an arena
+static void benchmarkParse(size_t formulaCount) {
+	using Seconds = std::chrono::duration<double>;
+
+	std::mt19937 random(5);
+	std::ostringstream output;
+	for (size_t i = 0; i < formulaCount; ++i) {
+		makeRandomTree(static_cast<int>(3 + i % 5), random)->printInfixRecursive(output);
+		output << '\n';
+	}
+	const std::string text = output.str();
+
+	const auto run = [&text, formulaCount](const char* name, ExpressionArena* arena) {
+		std::vector<std::unique_ptr<Expression>> formulas;
+		formulas.reserve(formulaCount);
+		const auto start = std::chrono::steady_clock::now();
+		for (size_t begin = 0; begin < text.size(); ) {
+			const size_t end = text.find('\n', begin);
+			formulas.push_back(parseExpression(std::string_view(text).substr(begin, end - begin),
+				{}, arena));
+			begin = end + 1;
+		}
+		const double seconds = Seconds(std::chrono::steady_clock::now() - start).count();
+		std::cout << "  " << name << ": " << static_cast<double>(text.size()) / seconds / 1e6
+			<< " MB/s, " << static_cast<double>(formulaCount) / seconds / 1e6
+			<< " M formulas/s\n";
+	};
+
+	std::cout << "Parsing " << formulaCount << " formulas, " << text.size() / 1024 << " KiB:\n";
+	run("Heap", nullptr);
+	ExpressionArena arena;
+	run("Arena", &arena);
+	arena.reset();
+}
+
+/// @brief Pass `expr` through the binary encoding, back to a tree and to a program, and through
+/// the infix text for comparison
+static void testSerialization(const Expression& expr,
+	ArrayView<const std::string_view> variableNames, ArrayView<const double> variables)
+{
+	std::vector<std::byte> data;
+	serializeExpression(expr, data);
+	std::ostringstream text;
+	expr.printInfixRecursive(text);
+
+	const double value = expr.eval(variables);
+	const std::unique_ptr<Expression> tree = deserializeExpression({data.data(), data.size()});
+	const Program program = deserializeProgram({data.data(), data.size()});
+	const std::unique_ptr<Expression> parsed = parseExpression(text.str(), variableNames);
+	std::cout << text.str() << ": " << data.size() << " bytes, " << text.str().size()
+		<< " characters of text\n  Read back: ";
+	tree->printInfixRecursive(std::cout);
+	std::cout << std::boolalpha << ", the same value: " << (tree->eval(variables) == value)
+		<< ", by the program: " << (program.eval(variables) == value)
+		<< ", through the text: " << (parsed->eval(variables) == value) << '\n';
+
+	try {
+		deserializeExpression({data.data(), data.size() - 1});
+	}
+	catch (const SerializationError& error) {
+		std::cout << "  Without the last byte: " << error.what() << '\n';
+	}
+}
+
+/// @brief Write the random formulas of `benchmarkParse()` to a library, and read them back as
+/// trees, with the nodes on the heap and in an arena, and as programs
+static void benchmarkSerialization(size_t formulaCount) {
+	using Seconds = std::chrono::duration<double>;
+
+	std::mt19937 random(5);
+	std::vector<std::unique_ptr<Expression>> formulas;
+	std::vector<const Expression*> pointers;
+	std::ostringstream text;
+	for (size_t i = 0; i < formulaCount; ++i) {
+		formulas.push_back(makeRandomTree(static_cast<int>(3 + i % 5), random));
+		pointers.push_back(formulas.back().get());
+		formulas.back()->printInfixRecursive(text);
+		text << '\n';
+	}
+	std::vector<std::byte> data;
+	serializeLibrary({pointers.data(), pointers.size()}, data);
+
+	const auto openStart = std::chrono::steady_clock::now();
+	const ExpressionLibrary library({data.data(), data.size()});
+	const double openSeconds = Seconds(std::chrono::steady_clock::now() - openStart).count();
+	std::cout << "Reading " << library.size() << " formulas, " << data.size() / 1024
+		<< " KiB (" << text.str().size() / 1024 << " KiB as text), opened in "
+		<< openSeconds * 1e6 << " us:\n";
+
+	// Compare the bits, so that NaNs are the same too
+	const auto isExact = [&formulas](size_t i, double value) {
+		const double expected = formulas[i]->eval();
+		return std::bit_cast<std::uint64_t>(value) == std::bit_cast<std::uint64_t>(expected);
+	};
+	const auto run = [&library, &data](const char* name, auto read) {
+		const auto start = std::chrono::steady_clock::now();
+		for (size_t i = 0; i < library.size(); ++i) {
+			read(i, library[i]);
+		}
+		const double seconds = Seconds(std::chrono::steady_clock::now() - start).count();
+		std::cout << "  " << name << ": " << static_cast<double>(data.size()) / seconds / 1e6
+			<< " MB/s, " << static_cast<double>(library.size()) / seconds / 1e6
+			<< " M formulas/s\n";
+	};
+
+	std::vector<std::unique_ptr<Expression>> trees(library.size());
+	run("Trees on the heap", [&trees](size_t i, ArrayView<const std::byte> bytes) {
+		trees[i] = deserializeExpression(bytes);
+	});
+	ExpressionArena arena;
+	std::vector<std::unique_ptr<Expression>> arenaTrees(library.size());
+	run("Trees in an arena", [&arenaTrees, &arena](size_t i, ArrayView<const std::byte> bytes) {
+		arenaTrees[i] = deserializeExpression(bytes, &arena);
+	});
+	std::vector<Program> programs(library.size());
+	run("Programs", [&programs](size_t i, ArrayView<const std::byte> bytes) {
+		programs[i] = deserializeProgram(bytes);
+	});
+
+	bool isAllExact = true;
+	for (size_t i = 0; i < library.size(); ++i) {
+		isAllExact = isAllExact && isExact(i, trees[i]->eval()) && isExact(i, arenaTrees[i]->eval())
+			&& isExact(i, programs[i].eval());
+	}
+	std::cout << "  The same values as the original formulas: " << std::boolalpha << isAllExact
+		<< '\n';
+	arenaTrees.clear();
+	arena.reset();
+}
+
+/// @brief Compare the gradients of automatic differentiation with central finite differences,
+/// for one point and for every row of the columns
+static void testGradient(const Expression& expr, ArrayView<const std::string_view> names,
+	const std::vector<std::vector<double>>& columns)
+{
+	using Seconds = std::chrono::duration<double>;
+	const GradientTape tape(compile(expr));
+	const size_t variableCount = columns.size();
+
+	std::vector<double> point(variableCount);
+	for (size_t j = 0; j < variableCount; ++j) {
+		point[j] = columns[j].front();
+	}
+	std::vector<double> gradient(variableCount);
+	std::cout << "Value: " << tape.evalWithGradient({point.begin(), point.end()},
+		{gradient.begin(), gradient.end()}) << '\n';
+
+	// Central differences with a step scaled to the variable
+	const auto finiteDifference = [&tape, variableCount](std::vector<double>& row, size_t j) {
+		const double original = row[j];
+		const double step = 1e-6 * std::max(1.0, std::abs(original));
+		row[j] = original + step;
+		const double above = tape.program().eval({row.begin(), row.end()});
+		row[j] = original - step;
+		const double below = tape.program().eval({row.begin(), row.end()});
+		row[j] = original;
+		return (above - below) / (2 * step);
+	};
+	for (size_t j = 0; j < variableCount; ++j) {
+		std::cout << "  d/d" << names[j] << ": " << gradient[j] << " (finite difference "
+			<< finiteDifference(point, j) << ")\n";
+	}
+
+	std::vector<double> direction(variableCount, 1);
+	const auto [value, derivative] = tape.evalWithDerivative({point.begin(), point.end()},
+		{direction.begin(), direction.end()});
+	std::cout << "  Derivative along (1, ..., 1), forward mode: " << derivative << '\n';
+
+	const size_t rowCount = columns.front().size();
+	std::vector<ArrayView<const double>> inputs;
+	for (const std::vector<double>& column : columns) {
+		inputs.emplace_back(column.begin(), column.end());
+	}
+	std::vector<double> values(rowCount);
+	std::vector<std::vector<double>> gradients(variableCount, std::vector<double>(rowCount));
+	std::vector<ArrayView<double>> outputs;
+	for (std::vector<double>& column : gradients) {
+		outputs.emplace_back(column.begin(), column.end());
+	}
+
+	auto start = std::chrono::steady_clock::now();
+	tape.evalWithGradientBatch({inputs.begin(), inputs.end()}, {values.begin(), values.end()},
+		{outputs.begin(), outputs.end()});
+	const double tapeSeconds = Seconds(std::chrono::steady_clock::now() - start).count();
+
+	start = std::chrono::steady_clock::now();
+	double maxError = 0;
+	for (size_t i = 0; i < rowCount; ++i) {
+		for (size_t j = 0; j < variableCount; ++j) {
+			point[j] = columns[j][i];
+		}
+		for (size_t j = 0; j < variableCount; ++j) {
+			const double estimate = finiteDifference(point, j);
+			maxError = std::max(maxError,
+				std::abs(estimate - gradients[j][i]) / std::max(1.0, std::abs(gradients[j][i])));
+		}
+	}
+	const double differenceSeconds = Seconds(std::chrono::steady_clock::now() - start).count();
+
+	std::cout << "  " << rowCount << " rows: reverse mode "
+		<< tapeSeconds / static_cast<double>(rowCount) * 1e9 << " ns/row, finite differences "
+		<< differenceSeconds / static_cast<double>(rowCount) * 1e9
+		<< " ns/row, largest relative difference " << maxError << '\n';
+}
+
+/// @brief Print the symbolic derivatives of `expr` by every variable and compare them with
+/// the gradient of the automatic differentiation at the first row of the columns, then time
+/// the schedules of the derivatives over all rows and check them against the trees. The
+/// derivatives stay in the pool, shared nodes and all, and are only expanded to trees to be
+/// printed and checked
+static void testDerivative(const Expression& expr, ArrayView<const std::string_view> names,
+	const std::vector<std::vector<double>>& columns)
+{
+	using Seconds = std::chrono::duration<double>;
+	const size_t variableCount = columns.size();
+	std::vector<double> point(variableCount);
+	for (size_t j = 0; j < variableCount; ++j) {
+		point[j] = columns[j].front();
+	}
+	std::vector<double> gradient(variableCount);
+	evalWithGradient(expr, {point.begin(), point.end()}, {gradient.begin(), gradient.end()});
+
+	std::vector<ArrayView<const double>> inputs;
+	for (const std::vector<double>& column : columns) {
+		inputs.emplace_back(column.begin(), column.end());
+	}
+	std::vector<double> output(columns.front().size());
+	ExpressionPool pool;
+	const ExpressionPool::NodeId root = pool.intern(expr);
+	for (size_t j = 0; j < variableCount; ++j) {
+		ExpressionPool::NodeId result = ExpressionPool::noChild;
+		try {
+			result = derivative(pool, root, j);
+		}
+		catch (const std::runtime_error& error) {
+			std::cout << "  d/d" << names[j] << ": " << error.what() << '\n';
+			continue;
+		}
+		const ExpressionPool::Schedule schedule = pool.schedule(result);
+		const std::unique_ptr<Expression> tree = pool.toExpression(result, names);
+		std::cout << "  d/d" << names[j] << " = ";
+		tree->printInfixRecursive(std::cout);
+		std::cout << " = " << schedule.eval({point.begin(), point.end()}) << " (reverse mode "
+			<< gradient[j] << ")\n";
+
+		const auto start = std::chrono::steady_clock::now();
+		schedule.evalBatch({inputs.begin(), inputs.end()}, {output.begin(), output.end()});
+		const double seconds = Seconds(std::chrono::steady_clock::now() - start).count();
+		// The steps reuse the slots of the values no longer needed, which must not change them
+		bool isSame = true;
+		std::vector<double> row(variableCount);
+		for (size_t i = 0; i < output.size(); ++i) {
+			for (size_t k = 0; k < variableCount; ++k) {
+				row[k] = columns[k][i];
+			}
+			const double value = tree->eval({row.begin(), row.end()});
+			isSame = isSame
+				&& std::bit_cast<std::uint64_t>(value) == std::bit_cast<std::uint64_t>(output[i]);
+		}
+		std::cout << "    compiled once, evaluated in blocks: "
+			<< seconds / static_cast<double>(output.size()) * 1e9 << " ns/row, "
+			<< schedule.slotCount() << " slots for " << schedule.size()
+			<< " steps, the same as the tree row by row: " << std::boolalpha << isSame << '\n';
+	}
+}
+
+/// @brief Differentiate `sin(x * sin(x * ...))` with `depth` levels, where the product rule
+/// repeats the inner levels in the derivative
+static void benchmarkDerivative(size_t depth) {
+	std::unique_ptr<Expression> expr = std::make_unique<Variable>(0, "x");
+	for (size_t i = 0; i < depth; ++i) {
+		expr = std::make_unique<Sin>(
+			std::make_unique<Multiplication>(std::make_unique<Variable>(0, "x"), std::move(expr)));
+	}
+
+	using Seconds = std::chrono::duration<double>;
+	const auto start = std::chrono::steady_clock::now();
+	ExpressionPool pool;
+	const ExpressionPool::NodeId root = derivative(pool, pool.intern(*expr), 0);
+	const double seconds = Seconds(std::chrono::steady_clock::now() - start).count();
+
+	const std::vector<bool> isReachable = pool.reachableNodes(root);
+	const size_t dagSize = static_cast<size_t>(std::count(isReachable.begin(),
+		isReachable.end(), true));
+	// Count the nodes of the tree `toExpression()` would make, without making it: a node
+	// counts once for every path to it
+	std::vector<size_t> treeSizes(isReachable.size());
+	for (size_t id = 0; id < isReachable.size(); ++id) {
+		if (isReachable[id]) {
+			const ExpressionPool::Node& node = pool[static_cast<ExpressionPool::NodeId>(id)];
+			treeSizes[id] = 1 + (node.first != ExpressionPool::noChild ? treeSizes[node.first] : 0)
+				+ (node.second != ExpressionPool::noChild ? treeSizes[node.second] : 0);
+		}
+	}
+	const size_t treeSize = treeSizes[root];
+	const double inputs[] = {0.5};
+	std::cout << "  Depth " << depth << " (" << compile(*expr).code().size() << " nodes): "
+		<< dagSize << " nodes shared in the pool, " << treeSize << " nodes as a tree, built in "
+		<< seconds * 1e6 << " us, value " << pool.eval(root, inputs) << '\n';
+}
+
+/// @brief Bound `text` over the box `box` and compare the bounds with the range of the values at
+/// random points of the box
+static void testInterval(std::string_view text, ArrayView<const std::string_view> names,
+	ArrayView<const Interval> box, std::mt19937& random)
+{
+	const Program program = compile(*parseExpression(text, names));
+	const Interval bounds = evalInterval(program, box);
+
+	Interval sampled = Interval::empty();
+	std::vector<double> point(box.size());
+	for (int i = 0; i < 100'000; ++i) {
+		for (size_t j = 0; j < box.size(); ++j) {
+			point[j] = std::uniform_real_distribution<double>(box[j].lower, box[j].upper)(random);
+		}
+		const double value = program.eval({point.begin(), point.end()});
+		if (!std::isnan(value)) {
+			sampled = sampled.isEmpty() ? Interval::point(value)
+				: Interval{std::min(sampled.lower, value), std::max(sampled.upper, value)};
+		}
+	}
+	const bool isContained = sampled.isEmpty()
+		|| (bounds.contains(sampled.lower) && bounds.contains(sampled.upper));
+	std::cout << "  " << text << ": " << bounds << ", sampled " << sampled << ", contained: "
+		<< std::boolalpha << isContained << '\n';
+}
+
+/// @brief Find the minimum of `text` over the box `box` within 1e-4 by branch and bound:
+/// the boxes are split in half along their widest side, and dropped as soon as their lower bound
+/// is within 1e-4 of the value at the center of a box already seen, or above it
+static void testBranchAndBound(std::string_view text, ArrayView<const std::string_view> names,
+	ArrayView<const Interval> box)
+{
+	using Seconds = std::chrono::duration<double>;
+	const Program program = compile(*parseExpression(text, names));
+	const size_t size = box.size();
+	std::vector<Interval> stack(program.maxStackDepth());
+	std::vector<Interval> current(size);
+	std::vector<double> center(size);
+	std::vector<double> best(size);
+	double bestValue = HUGE_VAL;
+	size_t boxCount = 0;
+	const double tolerance = 1e-4;
+
+	const auto start = std::chrono::steady_clock::now();
+	// The boxes left to search, one after another
+	std::vector<Interval> boxes(box.begin(), box.end());
+	while (!boxes.empty()) {
+		std::copy(boxes.end() - static_cast<std::ptrdiff_t>(size), boxes.end(), current.begin());
+		boxes.resize(boxes.size() - size);
+		++boxCount;
+		const Interval bounds = evalInterval(program, {current.begin(), current.end()},
+			{stack.begin(), stack.end()});
+		if (bounds.lower > bestValue - tolerance) {
+			continue;
+		}
+
+		size_t widest = 0;
+		for (size_t j = 0; j < size; ++j) {
+			center[j] = (current[j].lower + current[j].upper) / 2;
+			const double width = current[j].upper - current[j].lower;
+			if (width > current[widest].upper - current[widest].lower) {
+				widest = j;
+			}
+		}
+		const double value = program.eval({center.begin(), center.end()});
+		if (value < bestValue) {
+			bestValue = value;
+			best = center;
+		}
+		if (current[widest].upper - current[widest].lower > tolerance) {
+			const double upper = current[widest].upper;
+			current[widest].upper = center[widest];
+			boxes.insert(boxes.end(), current.begin(), current.end());
+			current[widest] = {center[widest], upper};
+			boxes.insert(boxes.end(), current.begin(), current.end());
+		}
+	}
+	const double seconds = Seconds(std::chrono::steady_clock::now() - start).count();
+
+	std::cout << "  Minimum of " << text << ": " << bestValue << " at (";
+	for (size_t j = 0; j < size; ++j) {
+		std::cout << (j > 0 ? ", " : "") << names[j] << " = " << best[j];
+	}
+	std::cout << "), " << boxCount << " boxes in " << seconds * 1e3 << " ms ("
+		<< seconds / static_cast<double>(boxCount) * 1e9 << " ns/box)\n";
+}
+
+/// @brief Time the parallel evaluation of a forest of random trees and of a program over many rows
+/// on `threadCount` threads, and compare the results with those of a single thread
+static void benchmarkParallelEvaluation(unsigned threadCount) {
+	using Seconds = std::chrono::duration<double>;
+	std::mt19937 random(5);
+
+	std::vector<std::unique_ptr<Expression>> forest;
+	std::vector<const Expression*> trees;
+	for (int i = 0; i < 10'000; ++i) {
+		forest.push_back(makeRandomTree(10, random));
+		trees.push_back(forest.back().get());
+	}
+	std::vector<double> values(trees.size());
+	std::vector<int> exceptions(trees.size());
+	std::vector<double> expectedValues(trees.size());
+	std::vector<int> expectedExceptions(trees.size());
+	evalForestParallel({trees.begin(), trees.end()}, {},
+		{expectedValues.begin(), expectedValues.end()},
+		{expectedExceptions.begin(), expectedExceptions.end()}, 1);
+
+	auto start = std::chrono::steady_clock::now();
+	evalForestParallel({trees.begin(), trees.end()}, {}, {values.begin(), values.end()},
+		{exceptions.begin(), exceptions.end()}, threadCount);
+	double seconds = Seconds(std::chrono::steady_clock::now() - start).count();
+	std::cout << "  " << trees.size() << " random trees on " << threadCount << " threads: "
+		<< seconds * 1e3 << " ms, "
+		<< std::count_if(exceptions.begin(), exceptions.end(), [](int flags) { return flags != 0; })
+		<< " raised exceptions, same as on one thread: " << std::boolalpha
+		<< (values == expectedValues && exceptions == expectedExceptions) << '\n';
+
+	// `x / (y - 1)` divides by zero for about one row in 4096
+	const Program program = compile(*parseExpression("x / (y - 1)", {{"x", "y"}}));
+	std::vector<std::vector<double>> columns(2, std::vector<double>(1 << 22));
+	for (size_t i = 0; i < columns[0].size(); ++i) {
+		columns[0][i] = std::uniform_real_distribution<double>(-1, 1)(random);
+		columns[1][i] = static_cast<double>(random() % 4096) / 2048;
+	}
+	std::vector<ArrayView<const double>> inputs;
+	for (const std::vector<double>& column : columns) {
+		inputs.emplace_back(column.begin(), column.end());
+	}
+	values.resize(columns[0].size());
+	exceptions.resize(columns[0].size());
+	expectedValues.resize(columns[0].size());
+	start = std::chrono::steady_clock::now();
+	program.evalBatch({inputs.begin(), inputs.end()},
+		{expectedValues.begin(), expectedValues.end()});
+	const double batchSeconds = Seconds(std::chrono::steady_clock::now() - start).count();
+
+	start = std::chrono::steady_clock::now();
+	evalBatchParallel(program, {inputs.begin(), inputs.end()}, {values.begin(), values.end()},
+		{exceptions.begin(), exceptions.end()}, threadCount);
+	seconds = Seconds(std::chrono::steady_clock::now() - start).count();
+	std::cout << "  " << values.size() << " rows on " << threadCount << " threads: "
+		<< seconds / static_cast<double>(values.size()) * 1e9 << " ns/row, "
+		<< std::count(exceptions.begin(), exceptions.end(), FE_DIVBYZERO)
+		<< " rows divided by zero, same as evalBatch() on one thread ("
+		<< batchSeconds / static_cast<double>(values.size()) * 1e9 << " ns/row, unchecked): "
+		<< std::boolalpha << (values == expectedValues) << '\n';
+}
+
+/// @brief Compare the speed of the tree walking evaluation with the bytecode
+static void benchmarkEvaluation(const char* name, const Expression& expr, size_t repetitions) {
+	using Seconds = std::chrono::duration<double>;
+	const auto measure = [repetitions](auto evaluate) {
+		double sum = 0;
+		const auto start = std::chrono::steady_clock::now();
+		for (size_t i = 0; i < repetitions; ++i) {
+			sum += evaluate();
+		}
+		const double seconds = Seconds(std::chrono::steady_clock::now() - start).count();
+		return std::pair{seconds / static_cast<double>(repetitions), sum};
+	};
+
+	const Program program = compile(expr);
+	const auto [virtualSeconds, virtualSum] = measure([&expr] { return expr.eval(); });
+	const auto [castSeconds, castSum] = measure([&expr] { return evalDynamicCast(expr); });
+	const std::unique_ptr<VariantExpression> variant = VariantExpression::fromProgram(program);
+	const auto [variantSeconds, variantSum] = measure([&variant] { return variant->eval(); });
+	const auto [bytecodeSeconds, bytecodeSum] = measure([&program] { return program.eval(); });
+	const NativeProgram native(program);
+	const auto [nativeSeconds, nativeSum] = measure([&native] { return native.eval(); });
+
+	const double nodeCount = static_cast<double>(program.code().size());
+	std::cout << name << " (" << nodeCount << " nodes, stack depth " << program.maxStackDepth()
+		<< "):\n";
+	std::cout << "  virtual eval(): " << virtualSeconds / nodeCount * 1e9 << " ns/node\n";
+	std::cout << "  dynamic_cast eval(): " << castSeconds / nodeCount * 1e9 << " ns/node\n";
+	std::cout << "  std::variant eval(): " << variantSeconds / nodeCount * 1e9 << " ns/node\n";
+	std::cout << "  bytecode: " << bytecodeSeconds / nodeCount * 1e9 << " ns/node, "
+		<< virtualSeconds / bytecodeSeconds << "x faster than virtual eval()\n";
+	std::cout << "  native code (" << (native.isNative() ? "compiled" : "interpreted") << ", "
+		<< native.codeSize() / 1024 << " KiB): " << nativeSeconds / nodeCount * 1e9 << " ns/node, "
+		<< virtualSeconds / nativeSeconds << "x faster than virtual eval()\n";
+	std::cout << "  Same results: " << std::boolalpha
+		<< (virtualSum == bytecodeSum && castSum == bytecodeSum && variantSum == bytecodeSum
+			&& nativeSum == bytecodeSum)
+		<< '\n';
+}
+
+/// @brief Run every traversal on a tree far too deep for a recursion over the call stack, and time
+/// them
+static void testDeepTree(const char* name, std::unique_ptr<Expression> expr,
+	ArrayView<const double> variables)
+{
+	using Milliseconds = std::chrono::duration<double, std::milli>;
+	const auto measure = [](auto function) {
+		const auto start = std::chrono::steady_clock::now();
+		function();
+		return Milliseconds(std::chrono::steady_clock::now() - start).count();
+	};
+
+	bool isComplete = false;
+	const double completeMs = measure([&] { isComplete = expr->isComplete(); });
+	double value = 0;
+	const double evalMs = measure([&] { value = expr->eval(variables); });
+	Program program;
+	const double compileMs = measure([&] { program = compile(*expr); });
+	double programValue = 0;
+	const double programMs = measure([&] { programValue = program.eval(variables); });
+	const NativeProgram native(program);
+	const double nativeValue = native.eval(variables);
+	const double castValue = evalDynamicCast(*expr, variables);
+	double variantValue = 0;
+	const double variantMs = measure([&] {
+		variantValue = VariantExpression::fromProgram(program)->eval(variables);
+	});
+	std::unique_ptr<Expression> copy;
+	const double cloneMs = measure([&] { copy = expr->clone(); });
+	std::ostringstream output;
+	const double printMs = measure([&] { copy->printInfixRecursive(output); });
+	std::unique_ptr<Expression> simplified;
+	const double simplifyMs = measure([&] {
+		simplified = simplify(std::move(copy), {true, fastMathRewriteRules()});
+	});
+	std::unique_ptr<Expression> derived;
+	const double derivativeMs = measure([&] { derived = derivative(*expr, 0); });
+	ExpressionPool pool;
+	std::unique_ptr<Expression> expanded;
+	const double poolMs = measure([&] { expanded = pool.toExpression(pool.intern(*expr)); });
+	const bool isSameProgram = compile(*expanded).code().size() == program.code().size();
+	const double destroyMs = measure([&] {
+		expanded.reset();
+		expr.reset();
+	});
+
+	const std::string infix = std::move(output).str();
+	std::cout << name << " (" << program.code().size() << " nodes, stack depth "
+		<< program.maxStackDepth() << "):\n" << std::boolalpha;
+	std::cout << "  isComplete(): " << isComplete << " in " << completeMs << " ms\n";
+	std::cout << "  eval(): " << value << " in " << evalMs << " ms, the same as the program: "
+		<< (value == programValue) << " (compiled in " << compileMs << " ms, run in "
+		<< programMs << " ms)\n";
+	std::cout << "  Native code (" << (native.isNative() ? "compiled" : "interpreted")
+		<< "): the same value: " << (nativeValue == value) << '\n';
+	std::cout << "  dynamic_cast eval(): the same value: " << (castValue == value) << '\n';
+	std::cout << "  std::variant eval(): the same value: " << (variantValue == value)
+		<< " (built, run and destroyed in " << variantMs << " ms)\n";
+	std::cout << "  clone(): " << cloneMs << " ms\n";
+	std::cout << "  printInfixRecursive(): " << infix.size() << " characters in " << printMs
+		<< " ms: " << infix.substr(0, 32) << "...\n";
+	std::ostringstream simplifiedInfix;
+	simplified->printInfixRecursive(simplifiedInfix);
+	std::cout << "  simplify() with the fast math rules: " << simplifiedInfix.str().substr(0, 32)
+		<< "... in " << simplifyMs << " ms\n";
+	std::cout << "  derivative() by x0: ";
+	derived->printInfixRecursive(std::cout);
+	std::cout << " in " << derivativeMs << " ms\n";
+	std::cout << "  Through an ExpressionPool and back: the same size: " << isSameProgram << " in "
+		<< poolMs << " ms\n";
+	std::cout << "  Destruction of the tree and the copy: " << destroyMs << " ms\n";
+}
+
 int main() {
 	std::unique_ptr<Expression> exprCloned;
 
@@ -185,4 +1043,269 @@ int main() {
 			);
 		testExpression(*expr3);
 	}
+	{
+		std::cout << "\nTesting variables:\n";
+		// The future value of `amount` invested at the rate `rate` for `years` years
+		std::unique_ptr<Expression> expr4 =
+			std::make_unique<Multiplication>(
+				std::make_unique<Variable>(0, "amount"),
+				std::make_unique<Pow>(
+					std::make_unique<Addition>(
+						std::make_unique<Number>(1),
+						std::make_unique<Variable>(1, "rate")
+					),
+					std::make_unique<Variable>(2, "years")
+				)
+			);
+		std::cout << "Infix notation: ";
+		expr4->printInfixRecursive(std::cout);
+		std::cout << "\nBytecode:\n" << compile(*expr4);
+
+		const double inputs[] = {1000, 0.05, 10};
+		std::cout << "Result for amount = 1000, rate = 0.05, years = 10 (virtual method): "
+			<< expr4->eval(inputs) << '\n';
+		std::cout << "Result (free function): " << evalDynamicCast(*expr4, inputs) << '\n';
+		std::cout << "Result (bytecode): " << compile(*expr4).eval(inputs) << '\n';
+
+		std::cout << "\nBenchmarking evaluation over 2^20 rows:\n";
+		std::mt19937 random(2);
+		std::vector<std::vector<double>> columns(3, std::vector<double>(1 << 20));
+		for (size_t i = 0; i < columns[0].size(); ++i) {
+			columns[0][i] = std::uniform_real_distribution<double>(100, 10'000)(random);
+			columns[1][i] = std::uniform_real_distribution<double>(0, 0.1)(random);
+			columns[2][i] = std::uniform_real_distribution<double>(1, 30)(random);
+		}
+		benchmarkBatchEvaluation(*expr4, columns);
+
+		// Arithmetic and square roots only: the kind of instructions the blocks vectorize
+		std::unique_ptr<Expression> expr5 =
+			std::make_unique<Division>(
+				std::make_unique<Subtraction>(
+					std::make_unique<Multiplication>(
+						std::make_unique<Variable>(0),
+						std::make_unique<Variable>(1)
+					),
+					std::make_unique<Sqrt>(std::make_unique<Variable>(2))
+				),
+				std::make_unique<Addition>(
+					std::make_unique<Variable>(1),
+					std::make_unique<Number>(1)
+				)
+			);
+		std::cout << "Evaluating ";
+		expr5->printInfixRecursive(std::cout);
+		std::cout << ":\n";
+		benchmarkBatchEvaluation(*expr5, columns);
+
+		std::cout << "\nGradient of ";
+		expr4->printInfixRecursive(std::cout);
+		std::cout << " at amount = " << columns[0][0] << ", rate = " << columns[1][0]
+			<< ", years = " << columns[2][0] << ":\n";
+		const std::string_view names[] = {"amount", "rate", "years"};
+		testGradient(*expr4, names, columns);
+
+		// d/dx pow(x, 0) is 0 everywhere, also at 0 where `0 * pow(0, -1)` would be NaN
+		const GradientTape powTape(compile(Pow(std::make_unique<Variable>(0),
+			std::make_unique<Number>(0))));
+		const double zero[] = {0};
+		const double one[] = {1};
+		double powGradient[1] = {};
+		powTape.evalWithGradient(zero, powGradient);
+		std::cout << "d/dx0 pow(x0, 0) at x0 = 0: reverse mode " << powGradient[0]
+			<< ", forward mode " << powTape.evalWithDerivative(zero, one).second << '\n';
+
+		std::cout << "\nSymbolic derivatives:\n";
+		testDerivative(*expr4, names, columns);
+		const std::string_view defaultNames[] = {"x0", "x1", "x2"};
+		testDerivative(*expr5, defaultNames, columns);
+		for (const size_t depth : {size_t{10}, size_t{100}, size_t{1000}}) {
+			benchmarkDerivative(depth);
+		}
+	}
+	{
+		std::cout << "\nTesting simplification:\n";
+		std::unique_ptr<Expression> expr6 =
+			std::make_unique<Addition>(
+				std::make_unique<Multiplication>(
+					std::make_unique<Sqrt>(std::make_unique<Number>(81)),
+					std::make_unique<Pow>(
+						std::make_unique<Multiplication>(
+							std::make_unique<Variable>(0),
+							std::make_unique<Number>(1)
+						),
+						std::make_unique<Number>(1)
+					)
+				),
+				std::make_unique<Subtraction>(
+					std::make_unique<Negation>(std::make_unique<Negation>(
+						std::make_unique<Variable>(1))),
+					std::make_unique<Variable>(1)
+				)
+			);
+		const double inputs[] = {2, 3};
+		testSimplify(*expr6, inputs);
+
+		std::cout << '\n';
+		std::unique_ptr<Expression> expr7 =
+			std::make_unique<Addition>(
+				std::make_unique<Addition>(
+					std::make_unique<Number>(2),
+					std::make_unique<Division>(
+						std::make_unique<Variable>(0),
+						std::make_unique<Number>(0)
+					)
+				),
+				std::make_unique<Multiplication>(
+					std::make_unique<Number>(3),
+					std::make_unique<Division>(
+						std::make_unique<Number>(1),
+						std::make_unique<Number>(0)
+					)
+				)
+			);
+		testSimplify(*expr7, inputs);
+	}
+	{
+		std::cout << "\nBenchmarking evaluation:\n";
+		std::mt19937 random(1);
+		benchmarkEvaluation("Random tree of depth 16", *makeRandomTree(16, random), 200);
+		benchmarkEvaluation("Chain of depth 2000", *makeDeepChain(1000), 2000);
+	}
+	{
+		std::cout << "\nTraversing very deep trees:\n";
+		const double variables[] = {0.5};
+		testDeepTree("Left-deep sum", makeLeftDeepSum(1'000'000), variables);
+		testDeepTree("Right-deep difference", makeRightDeepDifference(1'000'000), variables);
+	}
+	{
+		std::cout << "\nArena allocation:\n";
+		ExpressionArena arena;
+		{
+			ExpressionArena::Scope scope(arena);
+			std::unique_ptr<Expression> expr = exprCloned->clone();
+			std::cout << "Cloned into an arena: ";
+			expr->printInfixRecursive(std::cout);
+			std::cout << " = " << expr->eval() << ", " << arena.liveCount() << " nodes, "
+				<< arena.sizeBytes() / 1024 << " KiB reserved\n";
+		}
+		std::cout << "Nodes left after the destruction: " << arena.liveCount() << '\n';
+
+		// The nodes record their regions: they may be deleted on another thread, after `reset()`
+		// or after their arena, and the blocks are freed with the last of them
+		std::unique_ptr<Expression> afterReset;
+		std::unique_ptr<Expression> afterArena;
+		std::unique_ptr<Expression> onThread;
+		{
+			ExpressionArena scratch;
+			{
+				ExpressionArena::Scope scope(scratch);
+				afterReset = exprCloned->clone();
+				onThread = exprCloned->clone();
+			}
+			scratch.reset();
+			{
+				ExpressionArena::Scope scope(scratch);
+				afterArena = exprCloned->clone();
+			}
+			std::cout << "Nodes of the arena after reset(): " << scratch.liveCount() << '\n';
+		}
+		std::thread([&onThread] { onThread.reset(); }).join();
+		std::cout << "Kept past reset() and the arena: " << afterReset->eval() << ", "
+			<< afterArena->eval() << '\n';
+		afterReset.reset();
+		afterArena.reset();
+
+		benchmarkArena(21);
+	}
+	{
+		std::cout << "\nParsing:\n";
+		const std::string_view names[] = {"amount", "rate", "years"};
+		const double inputs[] = {1000, 0.05, 10};
+		testParse("3 + (5 + 9) * 2", names, inputs);
+		testParse("cos(pow(sqrt(81), 0.5) * -3.14159)", names, inputs);
+		testParse("amount * pow(1 + rate, years)", names, inputs);
+		testParse("10 - 4 - 3 / 2 / 5", names, inputs);
+		testParse("2 * (3 + 4", names, inputs);
+		testParse("exp(1)", names, inputs);
+		testParse("1 + * 2", names, inputs);
+		testParse("1e999", names, inputs);
+
+		benchmarkParse(200'000);
+	}
+	{
+		std::cout << "\nBinary serialization:\n";
+		const std::string_view names[] = {"amount", "rate", "years"};
+		const double inputs[] = {1000, 0.05, 10};
+		testSerialization(*parseExpression("amount * pow(1 + rate, years)", names), names,
+			inputs);
+		testSerialization(
+			*std::make_unique<Addition>(
+				std::make_unique<Multiplication>(
+					std::make_unique<Number>(1.0 / 3),
+					std::make_unique<Variable>(0, "amount")
+				),
+				std::make_unique<Sqrt>(std::make_unique<Number>(2))
+			),
+			names, inputs);
+
+		benchmarkSerialization(200'000);
+	}
+	{
+		std::cout << "\nInterval evaluation:\n";
+		const std::string_view names[] = {"x", "y"};
+		const Interval box[] = {{-2, 3}, {0.5, 4}};
+		std::mt19937 random(4);
+		testInterval("x * y - x / y", names, box, random);
+		testInterval("sin(4 * x) + cos(y)", names, box, random);
+		testInterval("pow(x, 3) - pow(x, 2) * y", names, box, random);
+		testInterval("sqrt(x) + pow(y, x)", names, box, random);
+		testInterval("pow(x, 0.5) * pow(y - 1, -2)", names, box, random);
+		testInterval("1 / (x - 1)", names, box, random);
+		testInterval("sqrt(x - 4) + y", names, box, random);
+
+		testBranchAndBound("sin(3 * x) + pow(x - 1, 2) / 4 + cos(y) * y / 2", names, box);
+		testBranchAndBound("pow(x * x + y - 3, 2) + pow(x + y * y - 4, 2)", names, box);
+	}
+	{
+		std::cout << "\nParallel evaluation (" << std::thread::hardware_concurrency()
+			<< " hardware threads):\n";
+		const std::string_view texts[] = {"1 + 2", "5 / 0", "sqrt(0 - 1)", "pow(10, 400)",
+			"pow(10, -400)"};
+		std::vector<std::unique_ptr<Expression>> forest;
+		std::vector<const Expression*> trees;
+		for (const std::string_view text : texts) {
+			forest.push_back(parseExpression(text));
+			trees.push_back(forest.back().get());
+		}
+		std::vector<double> values(trees.size());
+		std::vector<int> exceptions(trees.size());
+		evalForestParallel({trees.begin(), trees.end()}, {}, {values.begin(), values.end()},
+			{exceptions.begin(), exceptions.end()});
+		for (size_t i = 0; i < trees.size(); ++i) {
+			std::cout << texts[i] << " = " << values[i] << '\n';
+			printNumericalErrors(exceptions[i]);
+		}
+
+		for (const unsigned threadCount : {1u, 2u, 4u}) {
+			benchmarkParallelEvaluation(threadCount);
+		}
+	}
+	{
+		std::cout << "\nHash-consing:\n";
+		ExpressionPool pool;
+		const ExpressionPool::NodeId first = pool.intern(*exprCloned);
+		const ExpressionPool::NodeId second = pool.intern(*exprCloned->clone());
+		std::cout << "Interning a tree of " << compile(*exprCloned).code().size()
+			<< " nodes twice: " << pool.size() << " nodes, the same root: " << std::boolalpha
+			<< (first == second) << '\n';
+		std::cout << "Expanded back: ";
+		pool.toExpression(first)->printInfixRecursive(std::cout);
+		std::cout << " = " << pool.eval(first) << '\n';
+
+		std::mt19937 random(3);
+		benchmarkPool("Depth 16, 8 distinct subtrees per level", *makeRepetitiveTree(16, 8, random),
+			20);
+		benchmarkPool("Depth 12, 64 distinct subtrees per level",
+			*makeRepetitiveTree(12, 64, random), 20);
+	}
 }
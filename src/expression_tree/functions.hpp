@@ -11,14 +11,27 @@ class Sin final: public UnaryFunction {
 public:
 	using UnaryFunction::UnaryFunction;
 
-	double eval() const override { return std::sin(m_first->eval()); }
-
 	void printToken(std::ostream& output) const override {
 		output << "sin";
 	}
 
-	std::unique_ptr<Expression> clone() const override {
-		return std::make_unique<Sin>(cloneOrNull(m_first.get()));
+	void compileNode(Program& program) const override {
+		program.emit(OpCode::Sin);
+	}
+
+private:
+	double evalRecursive(ArrayView<const double> variables, unsigned depth) const override {
+		return std::sin(evalChild(*m_first, variables, depth));
+	}
+
+	double evalNode(ArrayView<const double> operands, ArrayView<const double>) const override {
+		return std::sin(operands[0]);
+	}
+
+	std::unique_ptr<Expression> cloneNode(ArrayView<std::unique_ptr<Expression>> children)
+		const override
+	{
+		return std::make_unique<Sin>(std::move(children[0]));
 	}
 };
 
@@ -26,14 +39,27 @@ class Cos final: public UnaryFunction {
 public:
 	using UnaryFunction::UnaryFunction;
 
-	double eval() const override { return std::cos(m_first->eval()); }
-
 	void printToken(std::ostream& output) const override {
 		output << "cos";
 	}
 
-	std::unique_ptr<Expression> clone() const override {
-		return std::make_unique<Cos>(cloneOrNull(m_first.get()));
+	void compileNode(Program& program) const override {
+		program.emit(OpCode::Cos);
+	}
+
+private:
+	double evalRecursive(ArrayView<const double> variables, unsigned depth) const override {
+		return std::cos(evalChild(*m_first, variables, depth));
+	}
+
+	double evalNode(ArrayView<const double> operands, ArrayView<const double>) const override {
+		return std::cos(operands[0]);
+	}
+
+	std::unique_ptr<Expression> cloneNode(ArrayView<std::unique_ptr<Expression>> children)
+		const override
+	{
+		return std::make_unique<Cos>(std::move(children[0]));
 	}
 };
 
@@ -41,14 +67,27 @@ class Sqrt final: public UnaryFunction {
 public:
 	using UnaryFunction::UnaryFunction;
 
-	double eval() const override { return std::sqrt(m_first->eval()); }
-
 	void printToken(std::ostream& output) const override {
 		output << "sqrt";
 	}
 
-	std::unique_ptr<Expression> clone() const override {
-		return std::make_unique<Sqrt>(cloneOrNull(m_first.get()));
+	void compileNode(Program& program) const override {
+		program.emit(OpCode::Sqrt);
+	}
+
+private:
+	double evalRecursive(ArrayView<const double> variables, unsigned depth) const override {
+		return std::sqrt(evalChild(*m_first, variables, depth));
+	}
+
+	double evalNode(ArrayView<const double> operands, ArrayView<const double>) const override {
+		return std::sqrt(operands[0]);
+	}
+
+	std::unique_ptr<Expression> cloneNode(ArrayView<std::unique_ptr<Expression>> children)
+		const override
+	{
+		return std::make_unique<Sqrt>(std::move(children[0]));
 	}
 };
 
@@ -56,14 +95,28 @@ class Pow final: public BinaryFunction {
 public:
 	using BinaryFunction::BinaryFunction;
 
-	double eval() const override { return std::pow(m_first->eval(), m_second->eval()); }
-
 	void printToken(std::ostream& output) const override {
 		output << "pow";
 	}
 
-	std::unique_ptr<Expression> clone() const override {
-		return std::make_unique<Sqrt>(cloneOrNull(m_first.get()));
+	void compileNode(Program& program) const override {
+		program.emit(OpCode::Pow);
+	}
+
+private:
+	double evalRecursive(ArrayView<const double> variables, unsigned depth) const override {
+		return std::pow(evalChild(*m_first, variables, depth),
+			evalChild(*m_second, variables, depth));
+	}
+
+	double evalNode(ArrayView<const double> operands, ArrayView<const double>) const override {
+		return std::pow(operands[0], operands[1]);
+	}
+
+	std::unique_ptr<Expression> cloneNode(ArrayView<std::unique_ptr<Expression>> children)
+		const override
+	{
+		return std::make_unique<Pow>(std::move(children[0]), std::move(children[1]));
 	}
 };
 
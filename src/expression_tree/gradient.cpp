@@ -0,0 +1,262 @@
+#include "expression_tree/gradient.hpp"
+
+#include <cassert>
+#include <cmath>
+
+#include <algorithm>
+#include <limits>
+
+#include "expression_tree/expression.hpp"
+
+namespace {
+
+/// @brief The derivative of `pow(x, y)` by `y`, given `value = pow(x, y)`
+double powExponentDerivative(double x, double value) {
+	if (x > 0) {
+		return value * std::log(x);
+	}
+	return x == 0 ? 0 : std::numeric_limits<double>::quiet_NaN();
+}
+
+} // namespace
+
+GradientTape::GradientTape(Program program):
+	m_program(std::move(program)),
+	m_links(m_program.code().size())
+{
+	// Run the program with the positions of the instructions in place of the values
+	std::vector<size_t> stack;
+	size_t constant = 0;
+	size_t variable = 0;
+	for (size_t i = 0; i < m_program.code().size(); ++i) {
+		const OpCode op = m_program.code()[i];
+		if (op == OpCode::Constant) {
+			m_links[i] = constant++;
+		}
+		else if (op == OpCode::Variable) {
+			m_links[i] = m_program.variableIndices()[variable++];
+		}
+		else if (operandCount(op) == 2) {
+			stack.pop_back();
+			m_links[i] = stack.back();
+			stack.pop_back();
+		}
+		else {
+			stack.pop_back();
+		}
+		stack.push_back(i);
+	}
+}
+
+void GradientTape::forward(ArrayView<const double> variables, std::vector<double>& values) const {
+	assert(variables.size() >= m_program.variableCount());
+	const ArrayView<const OpCode> code = m_program.code();
+	values.resize(code.size());
+	for (size_t i = 0; i < code.size(); ++i) {
+		const double last = i > 0 ? values[i - 1] : 0;
+		const double first = operandCount(code[i]) == 2 ? values[m_links[i]] : 0;
+		switch (code[i]) {
+		case OpCode::Constant:
+			values[i] = m_program.constants()[m_links[i]];
+			break;
+		case OpCode::Variable:
+			values[i] = variables[m_links[i]];
+			break;
+		case OpCode::Negate:
+			values[i] = -last;
+			break;
+		case OpCode::Add:
+			values[i] = first + last;
+			break;
+		case OpCode::Subtract:
+			values[i] = first - last;
+			break;
+		case OpCode::Multiply:
+			values[i] = first * last;
+			break;
+		case OpCode::Divide:
+			values[i] = first / last;
+			break;
+		case OpCode::Sin:
+			values[i] = std::sin(last);
+			break;
+		case OpCode::Cos:
+			values[i] = std::cos(last);
+			break;
+		case OpCode::Sqrt:
+			values[i] = std::sqrt(last);
+			break;
+		case OpCode::Pow:
+			values[i] = std::pow(first, last);
+			break;
+		}
+	}
+}
+
+void GradientTape::backward(const std::vector<double>& values, std::vector<double>& adjoints,
+	ArrayView<double> gradient) const
+{
+	assert(gradient.size() >= m_program.variableCount());
+	const ArrayView<const OpCode> code = m_program.code();
+	adjoints.assign(code.size(), 0);
+	adjoints.back() = 1;
+	std::fill(gradient.begin(), gradient.end(), 0);
+
+	for (size_t i = code.size(); i-- > 0; ) {
+		const double adjoint = adjoints[i];
+		if (adjoint == 0) {
+			continue;
+		}
+		// The last operand is computed by the previous instruction, the first one is linked
+		const size_t last = i - 1;
+		const size_t first = m_links[i];
+		switch (code[i]) {
+		case OpCode::Constant:
+			break;
+		case OpCode::Variable:
+			gradient[m_links[i]] += adjoint;
+			break;
+		case OpCode::Negate:
+			adjoints[last] -= adjoint;
+			break;
+		case OpCode::Add:
+			adjoints[first] += adjoint;
+			adjoints[last] += adjoint;
+			break;
+		case OpCode::Subtract:
+			adjoints[first] += adjoint;
+			adjoints[last] -= adjoint;
+			break;
+		case OpCode::Multiply:
+			adjoints[first] += adjoint * values[last];
+			adjoints[last] += adjoint * values[first];
+			break;
+		case OpCode::Divide:
+			// d(x / y) = dx / y - (x / y) * dy / y
+			adjoints[first] += adjoint / values[last];
+			adjoints[last] -= adjoint * values[i] / values[last];
+			break;
+		case OpCode::Sin:
+			adjoints[last] += adjoint * std::cos(values[last]);
+			break;
+		case OpCode::Cos:
+			adjoints[last] -= adjoint * std::sin(values[last]);
+			break;
+		case OpCode::Sqrt:
+			adjoints[last] += adjoint / (2 * values[i]);
+			break;
+		case OpCode::Pow: {
+			const double x = values[first];
+			const double y = values[last];
+			// The term is 0 for `y == 0`, even where `pow(x, -1)` is infinite
+			if (y != 0) {
+				adjoints[first] += adjoint * y * std::pow(x, y - 1);
+			}
+			// A constant exponent is common, e.g. `pow(x, 2)`, and needs no derivative
+			if (code[last] != OpCode::Constant) {
+				adjoints[last] += adjoint * powExponentDerivative(x, values[i]);
+			}
+			break;
+		}
+		}
+	}
+}
+
+double GradientTape::evalWithGradient(ArrayView<const double> variables,
+	ArrayView<double> gradient) const
+{
+	std::vector<double> values;
+	std::vector<double> adjoints;
+	forward(variables, values);
+	backward(values, adjoints, gradient);
+	return values.back();
+}
+
+std::pair<double, double> GradientTape::evalWithDerivative(ArrayView<const double> variables,
+	ArrayView<const double> direction) const
+{
+	assert(direction.size() >= m_program.variableCount());
+	std::vector<double> values;
+	forward(variables, values);
+
+	// `tangents[i]` is the directional derivative of the instruction `i`
+	const ArrayView<const OpCode> code = m_program.code();
+	std::vector<double> tangents(code.size());
+	for (size_t i = 0; i < code.size(); ++i) {
+		const size_t last = i - 1;
+		const size_t first = m_links[i];
+		switch (code[i]) {
+		case OpCode::Constant:
+			tangents[i] = 0;
+			break;
+		case OpCode::Variable:
+			tangents[i] = direction[m_links[i]];
+			break;
+		case OpCode::Negate:
+			tangents[i] = -tangents[last];
+			break;
+		case OpCode::Add:
+			tangents[i] = tangents[first] + tangents[last];
+			break;
+		case OpCode::Subtract:
+			tangents[i] = tangents[first] - tangents[last];
+			break;
+		case OpCode::Multiply:
+			tangents[i] = tangents[first] * values[last] + values[first] * tangents[last];
+			break;
+		case OpCode::Divide:
+			tangents[i] = (tangents[first] - values[i] * tangents[last]) / values[last];
+			break;
+		case OpCode::Sin:
+			tangents[i] = std::cos(values[last]) * tangents[last];
+			break;
+		case OpCode::Cos:
+			tangents[i] = -std::sin(values[last]) * tangents[last];
+			break;
+		case OpCode::Sqrt:
+			tangents[i] = tangents[last] / (2 * values[i]);
+			break;
+		case OpCode::Pow: {
+			const double x = values[first];
+			const double y = values[last];
+			tangents[i] = tangents[first] == 0 || y == 0 ? 0
+				: tangents[first] * y * std::pow(x, y - 1);
+			if (tangents[last] != 0) {
+				tangents[i] += tangents[last] * powExponentDerivative(x, values[i]);
+			}
+			break;
+		}
+		}
+	}
+	const size_t result = code.size() - 1;
+	return {values[result], tangents[result]};
+}
+
+void GradientTape::evalWithGradientBatch(ArrayView<const ArrayView<const double>> variables,
+	ArrayView<double> values, ArrayView<const ArrayView<double>> gradients) const
+{
+	assert(variables.size() >= m_program.variableCount() && gradients.size() == variables.size());
+
+	std::vector<double> row(variables.size());
+	std::vector<double> gradient(variables.size());
+	std::vector<double> instructionValues;
+	std::vector<double> adjoints;
+	for (size_t i = 0; i < values.size(); ++i) {
+		for (size_t j = 0; j < variables.size(); ++j) {
+			row[j] = variables[j][i];
+		}
+		forward({row.begin(), row.end()}, instructionValues);
+		backward(instructionValues, adjoints, {gradient.begin(), gradient.end()});
+
+		values[i] = instructionValues.back();
+		for (size_t j = 0; j < gradients.size(); ++j) {
+			gradients[j][i] = gradient[j];
+		}
+	}
+}
+
+double evalWithGradient(const Expression& expr, ArrayView<const double> variables,
+	ArrayView<double> gradient)
+{
+	return GradientTape(compile(expr)).evalWithGradient(variables, gradient);
+}
@@ -0,0 +1,75 @@
+#ifndef GRADIENT_HPP_INCLUDED
+#define GRADIENT_HPP_INCLUDED
+
+#include <cstddef>
+
+#include <utility>
+#include <vector>
+
+#include "array_view/array_view.hpp"
+#include "expression_tree/bytecode.hpp"
+
+class Expression;
+
+/// @brief Computes the partial derivatives of a compiled expression by automatic
+/// differentiation.
+///
+/// The instructions of a `Program` already form a flat tape: the last operand of every
+/// instruction is computed by the instruction right before it, and the tape only records where
+/// the first operand of every binary instruction comes from. The reverse mode runs the program
+/// forward keeping the value of every instruction, then propagates the adjoints backwards through
+/// the derivative rules of the nodes, which gives all of the partial derivatives at the cost of
+/// about two evaluations. The forward mode computes one directional derivative in a single pass
+///
+/// The derivative of `pow(x, y)` by `y` is `pow(x, y) * log(x)` for `x > 0`, 0 for `x = 0` and
+/// NaN for `x < 0`, without raising floating point exceptions of its own
+class GradientTape {
+public:
+	explicit GradientTape(Program program);
+
+	const Program& program() const {
+		return m_program;
+	}
+
+	/// @brief Evaluate the expression and set `gradient[j]` to its partial derivative by
+	/// the variable `j` (reverse mode)
+	/// @pre `variables.size() >= program().variableCount()` and `gradient.size()` is the same
+	double evalWithGradient(ArrayView<const double> variables, ArrayView<double> gradient) const;
+
+	/// @brief Evaluate the expression and its derivative in the direction `direction` of
+	/// the variables, i.e. the dot product of the gradient and `direction` (forward mode)
+	/// @return The value and the derivative
+	/// @pre `variables.size() >= program().variableCount()` and `direction.size()` is the same
+	std::pair<double, double> evalWithDerivative(ArrayView<const double> variables,
+		ArrayView<const double> direction) const;
+
+	/// @brief Run `evalWithGradient()` for every row of a table of inputs: `values[i]` is set to
+	/// the value and `gradients[j][i]` to the partial derivative by the variable `j` at the row
+	/// `i`, with the variables taken from the columns as in `Program::evalBatch()`. Reuses
+	/// the memory of the tape for all rows
+	/// @pre `variables.size() >= program().variableCount()` and `gradients.size()` is the same,
+	/// every column of `variables` and `gradients` has at least `values.size()` values
+	void evalWithGradientBatch(ArrayView<const ArrayView<const double>> variables,
+		ArrayView<double> values, ArrayView<const ArrayView<double>> gradients) const;
+
+private:
+	/// @brief Set `values[i]` to the value of the instruction `i`
+	void forward(ArrayView<const double> variables, std::vector<double>& values) const;
+	/// @brief Set the gradient from the values of the instructions, using `adjoints` as
+	/// the scratch memory
+	void backward(const std::vector<double>& values, std::vector<double>& adjoints,
+		ArrayView<double> gradient) const;
+
+	Program m_program;
+	/// @brief For every instruction: the position of the first operand of a binary instruction,
+	/// the index of a variable or of a constant
+	std::vector<size_t> m_links;
+};
+
+/// @brief Evaluate `expr` and set `gradient[j]` to its partial derivative by the variable `j`
+/// @pre `expr.isComplete()`, `variables` has a value for every variable of `expr` and
+/// `gradient.size() == variables.size()`
+double evalWithGradient(const Expression& expr, ArrayView<const double> variables,
+	ArrayView<double> gradient);
+
+#endif
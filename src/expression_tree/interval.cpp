@@ -0,0 +1,293 @@
+#include "expression_tree/interval.hpp"
+
+#include <cassert>
+#include <cmath>
+#include <cstdint>
+
+#include <algorithm>
+#include <bit>
+#include <limits>
+#include <memory>
+#include <numbers>
+#include <ostream>
+
+#include "expression_tree/expression.hpp"
+
+namespace {
+
+/// @brief Programs up to this deep are run with a stack on the call stack
+constexpr size_t localStackSize = 64;
+
+/// @brief How far the results of the C library functions are moved outwards
+constexpr int libraryUlps = 2;
+
+constexpr double twoPi = 2 * std::numbers::pi;
+
+/// @brief The next double above `value`, as `std::nextafter(value, HUGE_VAL)` but without
+/// the call and the floating point exceptions
+double nextUp(double value) {
+	if (std::isnan(value) || value == HUGE_VAL) {
+		return value;
+	}
+	if (value == 0) {
+		return std::numeric_limits<double>::denorm_min();
+	}
+	const std::int64_t bits = std::bit_cast<std::int64_t>(value);
+	return std::bit_cast<double>(value > 0 ? bits + 1 : bits - 1);
+}
+
+double roundUp(double value, int ulps = 1) {
+	for (int i = 0; i < ulps; ++i) {
+		value = nextUp(value);
+	}
+	return value;
+}
+
+double roundDown(double value, int ulps = 1) {
+	return -roundUp(-value, ulps);
+}
+
+/// @brief The interval of the bounds rounded outwards. A NaN bound, e.g. of `inf - inf`, is taken
+/// as unbounded
+Interval outwards(double lower, double upper, int ulps = 1) {
+	return {
+		std::isnan(lower) ? -HUGE_VAL : roundDown(lower, ulps),
+		std::isnan(upper) ? HUGE_VAL : roundUp(upper, ulps),
+	};
+}
+
+/// @brief The smallest interval containing both, either of them may be empty
+Interval hull(Interval a, Interval b) {
+	if (a.isEmpty()) {
+		return b;
+	}
+	if (b.isEmpty()) {
+		return a;
+	}
+	return {std::min(a.lower, b.lower), std::max(a.upper, b.upper)};
+}
+
+Interval add(Interval a, Interval b) {
+	if (a.isEmpty() || b.isEmpty()) {
+		return Interval::empty();
+	}
+	return outwards(a.lower + b.lower, a.upper + b.upper);
+}
+
+Interval subtract(Interval a, Interval b) {
+	if (a.isEmpty() || b.isEmpty()) {
+		return Interval::empty();
+	}
+	return outwards(a.lower - b.upper, a.upper - b.lower);
+}
+
+/// @brief A product of bounds, where 0 times an infinite bound is 0: the infinite bound is only
+/// approached, never reached
+double multiplyBounds(double x, double y) {
+	return x == 0 || y == 0 ? 0 : x * y;
+}
+
+Interval multiply(Interval a, Interval b) {
+	if (a.isEmpty() || b.isEmpty()) {
+		return Interval::empty();
+	}
+	const double products[] = {
+		multiplyBounds(a.lower, b.lower), multiplyBounds(a.lower, b.upper),
+		multiplyBounds(a.upper, b.lower), multiplyBounds(a.upper, b.upper),
+	};
+	const auto [lower, upper] = std::minmax_element(std::begin(products), std::end(products));
+	return outwards(*lower, *upper);
+}
+
+/// @brief `1 / a` over the values of `a` other than 0
+Interval reciprocal(Interval a) {
+	if (a.isEmpty() || (a.lower == 0 && a.upper == 0)) {
+		return Interval::empty();
+	}
+	if (a.lower > 0 || a.upper < 0) {
+		return outwards(1 / a.upper, 1 / a.lower);
+	}
+	if (a.lower == 0) {
+		return {roundDown(1 / a.upper), HUGE_VAL};
+	}
+	if (a.upper == 0) {
+		return {-HUGE_VAL, roundUp(1 / a.lower)};
+	}
+	return Interval::entire();
+}
+
+Interval divide(Interval a, Interval b) {
+	return multiply(a, reciprocal(b));
+}
+
+/// @brief Check whether `[lower, upper]` may contain a point `phase + 2 k pi` for an integer `k`.
+/// The check errs on the side of yes, by more than the rounding of the multiples of the period
+bool spansPhase(double lower, double upper, double phase) {
+	const double tolerance = 1e-12 * std::max({1.0, std::abs(lower), std::abs(upper)});
+	const double k = std::ceil((lower - tolerance - phase) / twoPi);
+	return phase + k * twoPi <= upper + tolerance;
+}
+
+/// @brief Bound `sin` or `cos` over `a`: the values at the ends, and the extrema of the periods
+/// the interval spans. The maxima are at `maximumPhase + 2 k pi`, the minima half a period away
+Interval periodic(Interval a, double (*function)(double), double maximumPhase) {
+	if (a.isEmpty()) {
+		return Interval::empty();
+	}
+	if (!std::isfinite(a.lower) || !std::isfinite(a.upper) || a.upper - a.lower >= twoPi) {
+		return {-1, 1};
+	}
+	const double first = function(a.lower);
+	const double last = function(a.upper);
+	Interval result = outwards(std::min(first, last), std::max(first, last), libraryUlps);
+	if (spansPhase(a.lower, a.upper, maximumPhase)) {
+		result.upper = 1;
+	}
+	if (spansPhase(a.lower, a.upper, maximumPhase + std::numbers::pi)) {
+		result.lower = -1;
+	}
+	return {std::max(result.lower, -1.0), std::min(result.upper, 1.0)};
+}
+
+Interval sqrt(Interval a) {
+	if (a.isEmpty() || a.upper < 0) {
+		return Interval::empty();
+	}
+	const Interval result = outwards(std::sqrt(std::max(a.lower, 0.0)), std::sqrt(a.upper));
+	return {std::max(result.lower, 0.0), result.upper};
+}
+
+/// @brief Bound `pow(x, n)` for `x` in `[lower, upper]`, `0 <= lower`, and an integer `n`,
+/// which is monotonic. `lower` is `+0` rather than `-0`
+Interval powMonotonic(double lower, double upper, double n) {
+	const double first = std::pow(lower, n);
+	const double last = std::pow(upper, n);
+	return n > 0 ? Interval{first, last} : Interval{last, first};
+}
+
+/// @brief Bound `pow(x, n)` for an integer `n`: the non-negative and the negative parts of `x`
+/// separately, mirroring the latter for an odd `n`
+Interval powInteger(Interval base, double n) {
+	if (n == 0) {
+		return Interval::point(1);
+	}
+	Interval result = Interval::empty();
+	if (base.upper >= 0) {
+		result = powMonotonic(std::max(base.lower, 0.0) + 0.0, base.upper, n);
+	}
+	if (base.lower < 0) {
+		const Interval mirrored = powMonotonic(std::max(-base.upper, 0.0) + 0.0, -base.lower, n);
+		const bool isOdd = std::fmod(n, 2) != 0;
+		result = hull(result, isOdd ? Interval{-mirrored.upper, -mirrored.lower} : mirrored);
+	}
+	return outwards(result.lower, result.upper, libraryUlps);
+}
+
+Interval pow(Interval base, Interval exponent) {
+	if (base.isEmpty() || exponent.isEmpty()) {
+		return Interval::empty();
+	}
+	if (exponent.lower == exponent.upper && std::isfinite(exponent.lower)
+		&& std::floor(exponent.lower) == exponent.lower)
+	{
+		return powInteger(base, exponent.lower);
+	}
+
+	if (base.lower < 0) {
+		// A negative base is defined for the integer exponents, which may give any value
+		if (std::ceil(exponent.lower) <= exponent.upper) {
+			return Interval::entire();
+		}
+		if (base.upper < 0) {
+			return Interval::empty();
+		}
+		base.lower = 0;
+	}
+	// For a non-negative base, `pow` is monotonic in either operand, so the extrema are at
+	// the corners
+	const double corners[] = {
+		std::pow(base.lower + 0.0, exponent.lower), std::pow(base.lower + 0.0, exponent.upper),
+		std::pow(base.upper, exponent.lower), std::pow(base.upper, exponent.upper),
+	};
+	const auto [lower, upper] = std::minmax_element(std::begin(corners), std::end(corners));
+	const Interval result = outwards(*lower, *upper, libraryUlps);
+	return {std::max(result.lower, 0.0), result.upper};
+}
+
+} // namespace
+
+std::ostream& operator<<(std::ostream& output, const Interval& interval) {
+	if (interval.isEmpty()) {
+		return output << "[]";
+	}
+	return output << '[' << interval.lower << ", " << interval.upper << ']';
+}
+
+Interval evalInterval(const Program& program, ArrayView<const Interval> variables) {
+	if (program.maxStackDepth() <= localStackSize) {
+		Interval stack[localStackSize];
+		return evalInterval(program, variables, stack);
+	}
+	std::unique_ptr<Interval[]> stack(new Interval[program.maxStackDepth()]);
+	return evalInterval(program, variables, {stack.get(), program.maxStackDepth()});
+}
+
+Interval evalInterval(const Program& program, ArrayView<const Interval> variables,
+	ArrayView<Interval> stack)
+{
+	assert(stack.size() >= program.maxStackDepth());
+	assert(variables.size() >= program.variableCount());
+
+	// `top` points past the topmost value
+	Interval* top = stack.data();
+	const double* constant = program.constants().begin();
+	const size_t* variable = program.variableIndices().begin();
+	for (const OpCode op : program.code()) {
+		switch (op) {
+		case OpCode::Constant:
+			*top++ = Interval::point(*constant++);
+			break;
+		case OpCode::Variable:
+			*top++ = variables[*variable++];
+			break;
+		case OpCode::Negate:
+			top[-1] = {-top[-1].upper, -top[-1].lower};
+			break;
+		case OpCode::Add:
+			--top;
+			top[-1] = add(top[-1], *top);
+			break;
+		case OpCode::Subtract:
+			--top;
+			top[-1] = subtract(top[-1], *top);
+			break;
+		case OpCode::Multiply:
+			--top;
+			top[-1] = multiply(top[-1], *top);
+			break;
+		case OpCode::Divide:
+			--top;
+			top[-1] = divide(top[-1], *top);
+			break;
+		case OpCode::Sin:
+			top[-1] = periodic(top[-1], [](double x) { return std::sin(x); }, std::numbers::pi / 2);
+			break;
+		case OpCode::Cos:
+			top[-1] = periodic(top[-1], [](double x) { return std::cos(x); }, 0);
+			break;
+		case OpCode::Sqrt:
+			top[-1] = sqrt(top[-1]);
+			break;
+		case OpCode::Pow:
+			--top;
+			top[-1] = pow(top[-1], *top);
+			break;
+		}
+	}
+	assert(top == stack.data() + 1);
+	return stack[0];
+}
+
+Interval evalInterval(const Expression& expr, ArrayView<const Interval> variables) {
+	return evalInterval(compile(expr), variables);
+}
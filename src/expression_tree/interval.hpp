@@ -0,0 +1,70 @@
+#ifndef INTERVAL_HPP_INCLUDED
+#define INTERVAL_HPP_INCLUDED
+
+#include <cmath>
+
+#include <iosfwd>
+#include <limits>
+
+#include "array_view/array_view.hpp"
+#include "expression_tree/bytecode.hpp"
+
+class Expression;
+
+/// @brief A closed interval of real numbers `[lower, upper]`, with infinite bounds allowed.
+/// The empty interval has NaN bounds
+/// @note The bounds are left uninitialized by default, as those of a `double`
+struct Interval {
+	double lower;
+	double upper;
+
+	/// @brief The interval holding the single value `value`
+	static Interval point(double value) {
+		return {value, value};
+	}
+
+	static Interval empty() {
+		return {std::numeric_limits<double>::quiet_NaN(),
+			std::numeric_limits<double>::quiet_NaN()};
+	}
+
+	static Interval entire() {
+		return {-HUGE_VAL, HUGE_VAL};
+	}
+
+	bool isEmpty() const {
+		return !(lower <= upper);
+	}
+
+	bool contains(double value) const {
+		return lower <= value && value <= upper;
+	}
+
+	friend std::ostream& operator<<(std::ostream& output, const Interval& interval);
+};
+
+/// @brief Bound the values of the expression computed by `program` over the box of the variables
+/// `variables`: the result contains the value of the expression at every point of the box where
+/// the expression is defined, and is empty if it is defined nowhere in the box.
+///
+/// The bounds are rounded outwards, by one ulp for the arithmetic and `sqrt` and by two ulps for
+/// `sin`, `cos` and `pow`, which the C library computes within one ulp. `sin` and `cos` find
+/// the extrema the interval spans from their periods, `sqrt` ignores the negative part of its
+/// operand, a division by an interval holding 0 gives a half line or the whole line, and `pow`
+/// is monotonic in either operand for a non-negative base. A negative base is only defined for
+/// integer exponents: it is bounded exactly for a single integer exponent and by the whole line
+/// otherwise. The bounds may be loose, since every instruction is bounded by itself, e.g. `x - x`
+/// over `[0, 1]` gives `[-1, 1]`
+/// @pre `variables.size() >= program.variableCount()`
+Interval evalInterval(const Program& program, ArrayView<const Interval> variables);
+/// @brief `evalInterval()` with the stack supplied by the caller, which saves the allocation
+/// when it is called in a loop
+/// @pre `stack.size() >= program.maxStackDepth()`
+Interval evalInterval(const Program& program, ArrayView<const Interval> variables,
+	ArrayView<Interval> stack);
+
+/// @brief Bound the values of `expr` over the box of the variables `variables`, see above
+/// @pre `expr.isComplete()`
+Interval evalInterval(const Expression& expr, ArrayView<const Interval> variables);
+
+#endif
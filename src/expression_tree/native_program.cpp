@@ -0,0 +1,428 @@
+#include "expression_tree/native_program.hpp"
+
+#include <cassert>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+
+#include <memory>
+#include <utility>
+
+#if defined(__x86_64__) && defined(__linux__)
+#define NATIVE_PROGRAM_ENABLED 1
+#include <sys/mman.h>
+#endif
+
+#ifdef NATIVE_PROGRAM_ENABLED
+namespace {
+
+/// @brief The stack slots kept in the registers, `xmm2`-`xmm15`. `xmm0` and `xmm1` are scratch
+/// registers and hold the arguments and the result of the calls
+constexpr size_t registerSlots = 14;
+
+/// @brief The largest programs translated, so that every offset fits into 32 bits
+constexpr size_t maxCodeSize = size_t{1} << 24;
+
+// The general purpose registers used by the code, with their encodings
+constexpr int rax = 0;
+constexpr int rsp = 4;
+constexpr int rbx = 3;
+constexpr int r12 = 12;
+constexpr int r13 = 13;
+
+// The opcodes of the SSE2 instructions used, after the `0x0f` escape byte
+constexpr uint8_t movsdLoad = 0x10;
+constexpr uint8_t movsdStore = 0x11;
+constexpr uint8_t movapd = 0x28;
+constexpr uint8_t sqrtsd = 0x51;
+constexpr uint8_t xorpd = 0x57;
+constexpr uint8_t addsd = 0x58;
+constexpr uint8_t mulsd = 0x59;
+constexpr uint8_t subsd = 0x5c;
+constexpr uint8_t divsd = 0x5e;
+
+/// @brief The mandatory prefixes: `sd` instructions work on a scalar double, `pd` on packed ones
+constexpr uint8_t prefixSd = 0xf2;
+constexpr uint8_t prefixPd = 0x66;
+
+// Addressable wrappers of the library functions, whose addresses are unspecified
+double callSin(double x) {
+	return std::sin(x);
+}
+
+double callCos(double x) {
+	return std::cos(x);
+}
+
+double callPow(double x, double y) {
+	return std::pow(x, y);
+}
+
+/// @brief Encodes the few x86-64 instructions the programs need
+class Assembler {
+public:
+	const std::vector<uint8_t>& bytes() const {
+		return m_bytes;
+	}
+
+	/// @brief An SSE2 instruction on two registers, `xmm<reg> op= xmm<rm>`
+	void sse(uint8_t prefix, uint8_t opcode, int reg, int rm) {
+		m_bytes.push_back(prefix);
+		rex(false, reg, rm);
+		m_bytes.push_back(0x0f);
+		m_bytes.push_back(opcode);
+		modRm(3, reg, rm);
+	}
+
+	/// @brief An SSE2 instruction on a register and the memory at `[base + offset]`
+	void sseMemory(uint8_t prefix, uint8_t opcode, int reg, int base, int32_t offset) {
+		m_bytes.push_back(prefix);
+		rex(false, reg, base);
+		m_bytes.push_back(0x0f);
+		m_bytes.push_back(opcode);
+		memoryOperand(reg, base, offset);
+	}
+
+	void push(int reg) {
+		rex(false, 0, reg);
+		m_bytes.push_back(static_cast<uint8_t>(0x50 + (reg & 7)));
+	}
+
+	void pop(int reg) {
+		rex(false, 0, reg);
+		m_bytes.push_back(static_cast<uint8_t>(0x58 + (reg & 7)));
+	}
+
+	/// @brief `mov destination, source` of 64-bit registers
+	void move(int destination, int source) {
+		rex(true, source, destination);
+		m_bytes.push_back(0x89);
+		modRm(3, source, destination);
+	}
+
+	/// @brief `add rsp, value` or `sub rsp, value`
+	void adjustStack(int32_t value, bool isAdd) {
+		rex(true, 0, rsp);
+		m_bytes.push_back(0x81);
+		modRm(3, isAdd ? 0 : 5, rsp);
+		immediate32(value);
+	}
+
+	/// @brief `mov rax, function` and `call rax`
+	void call(const void* function) {
+		rex(true, 0, rax);
+		m_bytes.push_back(static_cast<uint8_t>(0xb8 + rax));
+		uint64_t address = reinterpret_cast<uintptr_t>(function);
+		for (int i = 0; i < 8; ++i, address >>= 8) {
+			m_bytes.push_back(static_cast<uint8_t>(address));
+		}
+		m_bytes.push_back(0xff);
+		modRm(3, 2, rax);
+	}
+
+	void ret() {
+		m_bytes.push_back(0xc3);
+	}
+
+private:
+	/// @brief The REX prefix with the high bits of the register numbers, if it is needed
+	void rex(bool isWide, int reg, int rm) {
+		const int bits = (isWide ? 8 : 0) | (reg & 8 ? 4 : 0) | (rm & 8 ? 1 : 0);
+		if (bits != 0) {
+			m_bytes.push_back(static_cast<uint8_t>(0x40 | bits));
+		}
+	}
+
+	void modRm(int mod, int reg, int rm) {
+		m_bytes.push_back(static_cast<uint8_t>((mod << 6) | ((reg & 7) << 3) | (rm & 7)));
+	}
+
+	/// @brief `[base + offset]` with a 32-bit offset. `rsp` and `r12` as the base need
+	/// the SIB byte
+	void memoryOperand(int reg, int base, int32_t offset) {
+		modRm(2, reg, base);
+		if ((base & 7) == rsp) {
+			m_bytes.push_back(0x24);
+		}
+		immediate32(offset);
+	}
+
+	void immediate32(int32_t value) {
+		uint32_t bits = static_cast<uint32_t>(value);
+		for (int i = 0; i < 4; ++i, bits >>= 8) {
+			m_bytes.push_back(static_cast<uint8_t>(bits));
+		}
+	}
+
+	std::vector<uint8_t> m_bytes;
+};
+
+/// @brief Translates a program instruction by instruction, keeping track of the depth of
+/// the stack. The slot `i` of the stack is the register `xmm<i + 2>` for the first
+/// `registerSlots` slots and the memory at `[r13 + 8 * (i - registerSlots)]` for the rest, in
+/// the spill buffer passed by the caller. The frame on the call stack has a fixed size whatever
+/// the depth of the program: just the room to save the register slots across the calls
+class Translator {
+public:
+	Translator(const Program& program, size_t signMaskIndex):
+		m_program(program),
+		m_signMaskIndex(signMaskIndex)
+	{ }
+
+	std::vector<uint8_t> translate() {
+		// `rbx`, `r12` and `r13` keep the arguments across the calls. They are callee-saved
+		m_code.push(rbx);
+		m_code.push(r12);
+		m_code.push(r13);
+		m_code.adjustStack(frameSize, false);
+		m_code.move(rbx, 7); // rdi, the variables
+		m_code.move(r12, 6); // rsi, the constants
+		m_code.move(r13, 2); // rdx, the spill buffer
+
+		size_t depth = 0;
+		size_t constant = 0;
+		size_t variable = 0;
+		for (const OpCode op : m_program.code()) {
+			switch (op) {
+			case OpCode::Constant:
+				loadMemory(depth++, r12, constant++);
+				break;
+			case OpCode::Variable:
+				loadMemory(depth++, rbx, m_program.variableIndices()[variable++]);
+				break;
+			case OpCode::Negate:
+				// `-x` flips the sign bit, as `xorpd` with the sign mask does
+				m_code.sseMemory(prefixSd, movsdLoad, 1, r12, offset(m_signMaskIndex));
+				unary(prefixPd, xorpd, depth - 1, 1);
+				break;
+			case OpCode::Add:
+				arithmetic(addsd, depth--);
+				break;
+			case OpCode::Subtract:
+				arithmetic(subsd, depth--);
+				break;
+			case OpCode::Multiply:
+				arithmetic(mulsd, depth--);
+				break;
+			case OpCode::Divide:
+				arithmetic(divsd, depth--);
+				break;
+			case OpCode::Sqrt:
+				unary(prefixSd, sqrtsd, depth - 1, -1);
+				break;
+			case OpCode::Sin:
+				call(reinterpret_cast<const void*>(&callSin), depth, 1);
+				break;
+			case OpCode::Cos:
+				call(reinterpret_cast<const void*>(&callCos), depth, 1);
+				break;
+			case OpCode::Pow:
+				call(reinterpret_cast<const void*>(&callPow), depth--, 2);
+				break;
+			}
+		}
+
+		load(0, 0);
+		m_code.adjustStack(frameSize, true);
+		m_code.pop(r13);
+		m_code.pop(r12);
+		m_code.pop(rbx);
+		m_code.ret();
+		return m_code.bytes();
+	}
+
+private:
+	/// @brief The frame keeps `rsp` aligned to 16 bytes at the calls: the return address and the
+	/// three pushed registers take 32 bytes
+	static constexpr int32_t frameSize = static_cast<int32_t>(registerSlots * 8);
+	static_assert(frameSize % 16 == 0);
+
+	static bool isRegister(size_t slot) {
+		return slot < registerSlots;
+	}
+
+	static int xmm(size_t slot) {
+		return static_cast<int>(slot + 2);
+	}
+
+	static int32_t offset(size_t index) {
+		return static_cast<int32_t>(index * 8);
+	}
+
+	static int32_t memorySlotOffset(size_t slot) {
+		return offset(slot - registerSlots);
+	}
+
+	static int32_t saveOffset(size_t slot) {
+		return offset(slot);
+	}
+
+	/// @brief Copy a slot into the register `xmm<reg>`
+	void load(size_t slot, int reg) {
+		if (isRegister(slot)) {
+			m_code.sse(prefixPd, movapd, reg, xmm(slot));
+		}
+		else {
+			m_code.sseMemory(prefixSd, movsdLoad, reg, r13, memorySlotOffset(slot));
+		}
+	}
+
+	/// @brief Copy the register `xmm<reg>` into a slot
+	void store(int reg, size_t slot) {
+		if (isRegister(slot)) {
+			m_code.sse(prefixPd, movapd, xmm(slot), reg);
+		}
+		else {
+			m_code.sseMemory(prefixSd, movsdStore, reg, r13, memorySlotOffset(slot));
+		}
+	}
+
+	/// @brief Push `[base + 8 * index]` to the slot
+	void loadMemory(size_t slot, int base, size_t index) {
+		if (isRegister(slot)) {
+			m_code.sseMemory(prefixSd, movsdLoad, xmm(slot), base, offset(index));
+		}
+		else {
+			m_code.sseMemory(prefixSd, movsdLoad, 0, base, offset(index));
+			store(0, slot);
+		}
+	}
+
+	/// @brief Apply `opcode` to a slot in place, with `xmm<source>` as the second operand, or
+	/// with the slot itself if `source` is negative
+	void unary(uint8_t prefix, uint8_t opcode, size_t slot, int source) {
+		if (isRegister(slot)) {
+			m_code.sse(prefix, opcode, xmm(slot), source < 0 ? xmm(slot) : source);
+		}
+		else {
+			load(slot, 0);
+			m_code.sse(prefix, opcode, 0, source < 0 ? 0 : source);
+			store(0, slot);
+		}
+	}
+
+	/// @brief Replace the two topmost slots of a stack of `depth` values with the result
+	void arithmetic(uint8_t opcode, size_t depth) {
+		const size_t first = depth - 2;
+		const size_t second = depth - 1;
+		if (isRegister(second)) {
+			m_code.sse(prefixSd, opcode, xmm(first), xmm(second));
+		}
+		else {
+			load(first, 0);
+			load(second, 1);
+			m_code.sse(prefixSd, opcode, 0, 1);
+			store(0, first);
+		}
+	}
+
+	/// @brief Call `function` with the `arity` topmost slots of a stack of `depth` values as
+	/// the arguments, and replace them with the result. All of the `xmm` registers are
+	/// caller-saved, the register slots below the arguments are saved in the frame
+	void call(const void* function, size_t depth, size_t arity) {
+		const size_t first = depth - arity;
+		for (size_t slot = 0; slot < first && isRegister(slot); ++slot) {
+			m_code.sseMemory(prefixSd, movsdStore, xmm(slot), rsp, saveOffset(slot));
+		}
+		for (size_t i = 0; i < arity; ++i) {
+			load(first + i, static_cast<int>(i));
+		}
+		m_code.call(function);
+		store(0, first);
+		for (size_t slot = 0; slot < first && isRegister(slot); ++slot) {
+			m_code.sseMemory(prefixSd, movsdLoad, xmm(slot), rsp, saveOffset(slot));
+		}
+	}
+
+	const Program& m_program;
+	size_t m_signMaskIndex;
+	Assembler m_code;
+};
+
+} // namespace
+#endif
+
+NativeProgram::NativeProgram(Program program):
+	m_program(std::move(program)),
+	m_constants(m_program.constants().begin(), m_program.constants().end())
+{
+#ifdef NATIVE_PROGRAM_ENABLED
+	const size_t signMaskIndex = m_constants.size();
+	m_constants.push_back(-0.0);
+	if (m_program.code().size() > maxCodeSize || m_constants.size() > maxCodeSize
+		|| m_program.variableCount() > maxCodeSize)
+	{
+		return;
+	}
+
+	const std::vector<uint8_t> code = Translator(m_program, signMaskIndex).translate();
+	void* memory = mmap(nullptr, code.size(), PROT_READ | PROT_WRITE,
+		MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	if (memory == MAP_FAILED) {
+		return;
+	}
+	std::memcpy(memory, code.data(), code.size());
+	// Never writable and executable at the same time
+	if (mprotect(memory, code.size(), PROT_READ | PROT_EXEC) != 0) {
+		munmap(memory, code.size());
+		return;
+	}
+
+	m_code = memory;
+	m_codeSize = code.size();
+	m_function = reinterpret_cast<Function>(memory);
+	m_spillSize = m_program.maxStackDepth() > registerSlots
+		? m_program.maxStackDepth() - registerSlots : 0;
+#endif
+}
+
+NativeProgram::~NativeProgram() {
+	release();
+}
+
+NativeProgram::NativeProgram(NativeProgram&& other) noexcept:
+	m_program(std::move(other.m_program)),
+	m_constants(std::move(other.m_constants)),
+	m_function(std::exchange(other.m_function, nullptr)),
+	m_code(std::exchange(other.m_code, nullptr)),
+	m_codeSize(std::exchange(other.m_codeSize, 0)),
+	m_spillSize(std::exchange(other.m_spillSize, 0))
+{ }
+
+NativeProgram& NativeProgram::operator=(NativeProgram&& other) noexcept {
+	if (this != &other) {
+		release();
+		m_program = std::move(other.m_program);
+		m_constants = std::move(other.m_constants);
+		m_function = std::exchange(other.m_function, nullptr);
+		m_code = std::exchange(other.m_code, nullptr);
+		m_codeSize = std::exchange(other.m_codeSize, 0);
+		m_spillSize = std::exchange(other.m_spillSize, 0);
+	}
+	return *this;
+}
+
+void NativeProgram::release() {
+#ifdef NATIVE_PROGRAM_ENABLED
+	if (m_code) {
+		munmap(m_code, m_codeSize);
+	}
+#endif
+	m_code = nullptr;
+	m_codeSize = 0;
+	m_spillSize = 0;
+	m_function = nullptr;
+}
+
+double NativeProgram::eval(ArrayView<const double> variables) const {
+	assert(variables.size() >= m_program.variableCount());
+	if (!m_function) {
+		return m_program.eval(variables);
+	}
+	if (m_spillSize <= localSpillSize) {
+		double spill[localSpillSize];
+		return m_function(variables.data(), m_constants.data(), spill);
+	}
+	std::unique_ptr<double[]> spill(new double[m_spillSize]);
+	return m_function(variables.data(), m_constants.data(), spill.get());
+}
@@ -0,0 +1,71 @@
+#ifndef NATIVE_PROGRAM_HPP_INCLUDED
+#define NATIVE_PROGRAM_HPP_INCLUDED
+
+#include <cstddef>
+
+#include <vector>
+
+#include "array_view/array_view.hpp"
+#include "expression_tree/bytecode.hpp"
+
+/// @brief A `Program` translated to x86-64 machine code, with no dispatch at all: every
+/// instruction becomes one or a few SSE2 scalar instructions, the values of the stack live in
+/// the registers `xmm2`-`xmm15` (the deeper ones in a spill buffer that `eval()` allocates on the
+/// heap for deep programs, as `Program::eval()` does for its stack), and `sin`, `cos` and `pow`
+/// are called from the C library.
+///
+/// The code is written into a buffer mapped with `mmap` that is made executable when the code is
+/// complete. On other platforms than x86-64 Linux, or if the buffer can't be mapped, the program
+/// is run by the bytecode interpreter instead
+class NativeProgram {
+public:
+	explicit NativeProgram(Program program);
+	~NativeProgram();
+
+	NativeProgram(const NativeProgram&) = delete;
+	NativeProgram& operator=(const NativeProgram&) = delete;
+
+	NativeProgram(NativeProgram&& other) noexcept;
+	NativeProgram& operator=(NativeProgram&& other) noexcept;
+
+	/// @brief Run the program. Computes the same value as `Program::eval()` with the same
+	/// floating point exceptions raised
+	/// @pre `variables.size() >= program().variableCount()`
+	double eval(ArrayView<const double> variables = {}) const;
+
+	/// @brief Check whether the program runs as machine code rather than by the interpreter
+	bool isNative() const {
+		return m_function != nullptr;
+	}
+
+	/// @brief The size of the machine code in bytes, 0 if the program is not native
+	size_t codeSize() const {
+		return m_codeSize;
+	}
+
+	const Program& program() const {
+		return m_program;
+	}
+
+private:
+	/// @brief The signature of the generated code
+	using Function = double (*)(const double* variables, const double* constants, double* spill);
+
+	/// @brief The largest spill buffer kept on the call stack by `eval()`
+	static constexpr size_t localSpillSize = 64;
+
+	/// @brief Unmap the code, if any
+	void release();
+
+	Program m_program;
+	/// @brief The constants of the program followed by the data the code needs, e.g. the sign
+	/// bit for the negation
+	std::vector<double> m_constants;
+	Function m_function = nullptr;
+	void* m_code = nullptr;
+	size_t m_codeSize = 0;
+	/// @brief The number of the stack slots that don't fit into the registers
+	size_t m_spillSize = 0;
+};
+
+#endif
@@ -10,18 +10,29 @@ public:
 
 	bool isPrefix() const override { return true; }
 
-	double eval() const override {
-		return -m_first->eval();
-	}
-
 	int precedence() const override { return 12; }
 
 	void printToken(std::ostream& output) const override {
 		output << '-';
 	}
 
-	std::unique_ptr<Expression> clone() const override {
-		return std::make_unique<Negation>(cloneOrNull(m_first.get()));
+	void compileNode(Program& program) const override {
+		program.emit(OpCode::Negate);
+	}
+
+private:
+	double evalRecursive(ArrayView<const double> variables, unsigned depth) const override {
+		return -evalChild(*m_first, variables, depth);
+	}
+
+	double evalNode(ArrayView<const double> operands, ArrayView<const double>) const override {
+		return -operands[0];
+	}
+
+	std::unique_ptr<Expression> cloneNode(ArrayView<std::unique_ptr<Expression>> children)
+		const override
+	{
+		return std::make_unique<Negation>(std::move(children[0]));
 	}
 };
 
@@ -29,18 +40,29 @@ class Addition final: public BinaryOperator {
 public:
 	using BinaryOperator::BinaryOperator;
 
-	double eval() const override {
-		return m_first->eval() + m_second->eval();
-	}
-
 	int precedence() const override { return 8; }
 
 	void printToken(std::ostream& output) const override {
 		output << '+';
 	}
 
-	std::unique_ptr<Expression> clone() const override {
-		return std::make_unique<Addition>(cloneOrNull(m_first.get()), cloneOrNull(m_second.get()));
+	void compileNode(Program& program) const override {
+		program.emit(OpCode::Add);
+	}
+
+private:
+	double evalRecursive(ArrayView<const double> variables, unsigned depth) const override {
+		return evalChild(*m_first, variables, depth) + evalChild(*m_second, variables, depth);
+	}
+
+	double evalNode(ArrayView<const double> operands, ArrayView<const double>) const override {
+		return operands[0] + operands[1];
+	}
+
+	std::unique_ptr<Expression> cloneNode(ArrayView<std::unique_ptr<Expression>> children)
+		const override
+	{
+		return std::make_unique<Addition>(std::move(children[0]), std::move(children[1]));
 	}
 };
 
@@ -48,19 +70,29 @@ class Subtraction final: public BinaryOperator {
 public:
 	using BinaryOperator::BinaryOperator;
 
-	double eval() const override {
-		return m_first->eval() - m_second->eval();
-	}
-
 	int precedence() const override { return 8; }
 
 	void printToken(std::ostream& output) const override {
 		output << '-';
 	}
 
-	std::unique_ptr<Expression> clone() const override {
-		return std::make_unique<Subtraction>(cloneOrNull(m_first.get()),
-			cloneOrNull(m_second.get()));
+	void compileNode(Program& program) const override {
+		program.emit(OpCode::Subtract);
+	}
+
+private:
+	double evalRecursive(ArrayView<const double> variables, unsigned depth) const override {
+		return evalChild(*m_first, variables, depth) - evalChild(*m_second, variables, depth);
+	}
+
+	double evalNode(ArrayView<const double> operands, ArrayView<const double>) const override {
+		return operands[0] - operands[1];
+	}
+
+	std::unique_ptr<Expression> cloneNode(ArrayView<std::unique_ptr<Expression>> children)
+		const override
+	{
+		return std::make_unique<Subtraction>(std::move(children[0]), std::move(children[1]));
 	}
 };
 
@@ -68,19 +100,29 @@ class Multiplication final: public BinaryOperator {
 public:
 	using BinaryOperator::BinaryOperator;
 
-	double eval() const override {
-		return m_first->eval() * m_second->eval();
-	}
-
 	int precedence() const override { return 10; }
 
 	void printToken(std::ostream& output) const override {
 		output << '*';
 	}
 
-	std::unique_ptr<Expression> clone() const override {
-		return std::make_unique<Multiplication>(cloneOrNull(m_first.get()),
-			cloneOrNull(m_second.get()));
+	void compileNode(Program& program) const override {
+		program.emit(OpCode::Multiply);
+	}
+
+private:
+	double evalRecursive(ArrayView<const double> variables, unsigned depth) const override {
+		return evalChild(*m_first, variables, depth) * evalChild(*m_second, variables, depth);
+	}
+
+	double evalNode(ArrayView<const double> operands, ArrayView<const double>) const override {
+		return operands[0] * operands[1];
+	}
+
+	std::unique_ptr<Expression> cloneNode(ArrayView<std::unique_ptr<Expression>> children)
+		const override
+	{
+		return std::make_unique<Multiplication>(std::move(children[0]), std::move(children[1]));
 	}
 };
 
@@ -88,19 +130,29 @@ class Division final: public BinaryOperator {
 public:
 	using BinaryOperator::BinaryOperator;
 
-	double eval() const override {
-		return m_first->eval() / m_second->eval();
-	}
-
 	int precedence() const override { return 10; }
 
 	void printToken(std::ostream& output) const override {
 		output << '/';
 	}
 
-	std::unique_ptr<Expression> clone() const override {
-		return std::make_unique<Division>(cloneOrNull(m_first.get()),
-			cloneOrNull(m_second.get()));
+	void compileNode(Program& program) const override {
+		program.emit(OpCode::Divide);
+	}
+
+private:
+	double evalRecursive(ArrayView<const double> variables, unsigned depth) const override {
+		return evalChild(*m_first, variables, depth) / evalChild(*m_second, variables, depth);
+	}
+
+	double evalNode(ArrayView<const double> operands, ArrayView<const double>) const override {
+		return operands[0] / operands[1];
+	}
+
+	std::unique_ptr<Expression> cloneNode(ArrayView<std::unique_ptr<Expression>> children)
+		const override
+	{
+		return std::make_unique<Division>(std::move(children[0]), std::move(children[1]));
 	}
 };
 
@@ -0,0 +1,123 @@
+#include "expression_tree/parallel_eval.hpp"
+
+#include <cassert>
+
+#include <algorithm>
+#include <atomic>
+#include <vector>
+
+#include "parallel/parallel.hpp"
+
+namespace {
+
+/// @brief The number of expressions a thread takes at once
+constexpr size_t forestChunkSize = 64;
+
+/// @brief The number of rows a thread takes at once
+constexpr size_t rowChunkSize = 16 * Program::batchBlockSize;
+
+/// @brief Run `process(begin, end)` for the chunks of `chunkSize` of `count` items on
+/// `threadCount` threads, the threads taking the chunks in order from a shared counter. Every
+/// thread gets its own copy of `process`, which can hold its scratch buffers.
+///
+/// The floating point exception flags are cleared before the first chunk, and `process` must
+/// clear them again whenever it finds one of `checkedExceptions` raised: clearing the flags
+/// takes far longer than testing them. The flags of every thread, the calling one included, are
+/// restored at the end
+template<typename Process>
+void runChunks(size_t count, size_t chunkSize, unsigned threadCount, const Process& process) {
+	const size_t chunkCount = (count + chunkSize - 1) / chunkSize;
+	std::atomic<size_t> nextChunk = 0;
+	runOnThreads(resolveThreadCount(threadCount, chunkCount), [&](unsigned) {
+		std::fexcept_t savedFlags;
+		std::fegetexceptflag(&savedFlags, FE_ALL_EXCEPT);
+		std::feclearexcept(FE_ALL_EXCEPT);
+
+		Process threadProcess = process;
+		for (size_t chunk = nextChunk++; chunk < chunkCount; chunk = nextChunk++) {
+			const size_t begin = chunk * chunkSize;
+			threadProcess(begin, std::min(begin + chunkSize, count));
+		}
+
+		std::fesetexceptflag(&savedFlags, FE_ALL_EXCEPT);
+	});
+}
+
+/// @brief Get the exceptions out of `checkedExceptions` raised since the flags were last
+/// cleared, and clear the flags if there are any
+int takeExceptions() {
+	const int exceptions = std::fetestexcept(checkedExceptions);
+	if (exceptions != 0) {
+		std::feclearexcept(FE_ALL_EXCEPT);
+	}
+	return exceptions;
+}
+
+} // namespace
+
+void evalForestParallel(ArrayView<const Expression* const> expressions,
+	ArrayView<const double> variables, ArrayView<double> values, ArrayView<int> exceptions,
+	unsigned threadCount)
+{
+	assert(values.size() == expressions.size() && exceptions.size() == expressions.size());
+
+	runChunks(expressions.size(), forestChunkSize, threadCount, [&](size_t begin, size_t end) {
+		for (size_t i = begin; i < end; ++i) {
+			values[i] = expressions[i]->eval(variables);
+			exceptions[i] = takeExceptions();
+		}
+	});
+}
+
+void evalBatchParallel(const Program& program, ArrayView<const ArrayView<const double>> variables,
+	ArrayView<double> values, ArrayView<int> exceptions, unsigned threadCount)
+{
+	assert(variables.size() >= program.variableCount() && exceptions.size() == values.size());
+
+	/// @brief The buffers of a thread, allocated once per thread
+	struct BlockProcess {
+		const Program* program;
+		ArrayView<const ArrayView<const double>> variables;
+		ArrayView<double> values;
+		ArrayView<int> exceptions;
+		std::vector<ArrayView<const double>> columns;
+		std::vector<double> row;
+		std::vector<double> stack;
+		std::vector<double> blockStack;
+
+		void operator()(size_t begin, size_t end) {
+			columns.resize(variables.size());
+			row.resize(variables.size());
+			stack.resize(program->maxStackDepth());
+			blockStack.resize(program->batchStackSize());
+
+			for (size_t blockBegin = begin; blockBegin < end;
+				blockBegin += Program::batchBlockSize)
+			{
+				const size_t blockSize = std::min(Program::batchBlockSize, end - blockBegin);
+				for (size_t j = 0; j < variables.size(); ++j) {
+					columns[j] = variables[j].subview(blockBegin, blockSize);
+				}
+				program->evalBatch({columns.data(), columns.size()},
+					values.subview(blockBegin, blockSize), {blockStack.data(), blockStack.size()});
+				if (takeExceptions() == 0) {
+					std::fill_n(exceptions.begin() + blockBegin, blockSize, 0);
+					continue;
+				}
+
+				// Find out which rows raised the exceptions
+				for (size_t i = blockBegin; i < blockBegin + blockSize; ++i) {
+					for (size_t j = 0; j < variables.size(); ++j) {
+						row[j] = variables[j][i];
+					}
+					values[i] = program->eval({row.data(), row.size()},
+						{stack.data(), stack.size()});
+					exceptions[i] = takeExceptions();
+				}
+			}
+		}
+	};
+
+	runChunks(values.size(), rowChunkSize, threadCount,
+		BlockProcess{&program, variables, values, exceptions, {}, {}, {}, {}});
+}
@@ -0,0 +1,43 @@
+#ifndef PARALLEL_EVAL_HPP_INCLUDED
+#define PARALLEL_EVAL_HPP_INCLUDED
+
+#include <cfenv>
+#include <cstddef>
+
+#include "array_view/array_view.hpp"
+#include "expression_tree/bytecode.hpp"
+#include "expression_tree/expression.hpp"
+
+/// @brief The floating point exceptions the parallel evaluation reports for every work item
+constexpr int checkedExceptions = FE_DIVBYZERO | FE_INVALID | FE_OVERFLOW | FE_UNDERFLOW;
+
+/// @brief Evaluate every expression of `expressions` with the same variables on `threadCount`
+/// threads (0 for all cores): `values[i]` is set to the value of `expressions[i]` and
+/// `exceptions[i]` to the floating point exceptions out of `checkedExceptions` it raised.
+///
+/// The threads take chunks of consecutive expressions from a shared counter, so a thread that is
+/// done with cheap expressions takes more of them, and every thread writes the results of its
+/// own chunks only. The results don't depend on the number of threads or on their timing. The
+/// floating point exception flags of the calling thread are left as they were
+/// @pre All of `expressions` are complete, `variables` has a value for every variable in them,
+/// `values` and `exceptions` are as large as `expressions`
+void evalForestParallel(ArrayView<const Expression* const> expressions,
+	ArrayView<const double> variables, ArrayView<double> values, ArrayView<int> exceptions,
+	unsigned threadCount = 0);
+
+/// @brief Evaluate `program` for every row of a table of inputs on `threadCount` threads
+/// (0 for all cores), with the variables taken from the columns as in `Program::evalBatch()`:
+/// `values[i]` is set to the value at the row `i` and `exceptions[i]` to the floating point
+/// exceptions out of `checkedExceptions` it raised.
+///
+/// The threads take chunks of rows from a shared counter and run them in blocks by
+/// `Program::evalBatch()`. Only the blocks that raise an exception are run again row by row to
+/// tell which rows raised it, so the checks cost next to nothing when nothing goes wrong. Each
+/// thread keeps its own buffers for the whole run and writes the results of its own chunks
+/// only. The values are the same as those of `Program::eval()` row by row
+/// @pre `variables.size() >= program.variableCount()`, every column has at least `values.size()`
+/// values and `exceptions.size() == values.size()`
+void evalBatchParallel(const Program& program, ArrayView<const ArrayView<const double>> variables,
+	ArrayView<double> values, ArrayView<int> exceptions, unsigned threadCount = 0);
+
+#endif
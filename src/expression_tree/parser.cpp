@@ -0,0 +1,231 @@
+#include "expression_tree/parser.hpp"
+
+#include <charconv>
+#include <optional>
+#include <string>
+#include <system_error>
+
+#include "expression_tree/functions.hpp"
+#include "expression_tree/operators.hpp"
+
+namespace {
+
+/// @brief The deepest nesting of parentheses, negations and function calls. Bounds the recursion
+/// of the parser on hostile input
+constexpr size_t maxNestingDepth = 256;
+
+using MakeUnary = std::unique_ptr<Expression> (*)(std::unique_ptr<Expression> first);
+using MakeBinary = std::unique_ptr<Expression> (*)(std::unique_ptr<Expression> first,
+	std::unique_ptr<Expression> second);
+
+template<typename Node>
+std::unique_ptr<Expression> makeUnary(std::unique_ptr<Expression> first) {
+	return std::make_unique<Node>(std::move(first));
+}
+
+template<typename Node>
+std::unique_ptr<Expression> makeBinary(std::unique_ptr<Expression> first,
+	std::unique_ptr<Expression> second)
+{
+	return std::make_unique<Node>(std::move(first), std::move(second));
+}
+
+struct BinaryOperatorInfo {
+	char token;
+	int precedence;
+	MakeBinary make;
+};
+
+/// @brief The binary operators, with the precedences of their nodes
+const BinaryOperatorInfo binaryOperators[] = {
+	{'+', Addition().precedence(), makeBinary<Addition>},
+	{'-', Subtraction().precedence(), makeBinary<Subtraction>},
+	{'*', Multiplication().precedence(), makeBinary<Multiplication>},
+	{'/', Division().precedence(), makeBinary<Division>},
+};
+
+const int negationPrecedence = Negation().precedence();
+
+struct FunctionInfo {
+	std::string_view name;
+	/// @brief Exactly one of the two is set, by the arity of the function
+	MakeUnary makeUnary;
+	MakeBinary makeBinary;
+};
+
+const FunctionInfo functions[] = {
+	{"sin", makeUnary<Sin>, nullptr},
+	{"cos", makeUnary<Cos>, nullptr},
+	{"sqrt", makeUnary<Sqrt>, nullptr},
+	{"pow", nullptr, makeBinary<Pow>},
+};
+
+bool isSpace(char c) {
+	return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+}
+
+bool isDigit(char c) {
+	return c >= '0' && c <= '9';
+}
+
+bool isNameStart(char c) {
+	return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || c == '_';
+}
+
+class Parser {
+public:
+	Parser(std::string_view text, ArrayView<const std::string_view> variableNames):
+		m_text(text),
+		m_variableNames(variableNames)
+	{ }
+
+	std::unique_ptr<Expression> parse() {
+		std::unique_ptr<Expression> expr = parseExpression(0);
+		if (peek() != '\0') {
+			throw ParseError("Unexpected character", m_pos);
+		}
+		return expr;
+	}
+
+private:
+	/// @brief Skip the spaces and return the next character, or `'\0'` at the end of the text
+	char peek() {
+		while (m_pos < m_text.size() && isSpace(m_text[m_pos])) {
+			++m_pos;
+		}
+		return m_pos < m_text.size() ? m_text[m_pos] : '\0';
+	}
+
+	void expect(char c, const char* what) {
+		if (peek() != c) {
+			throw ParseError(what, m_pos);
+		}
+		++m_pos;
+	}
+
+	static const BinaryOperatorInfo* findBinaryOperator(char c) {
+		for (const BinaryOperatorInfo& op : binaryOperators) {
+			if (op.token == c) {
+				return &op;
+			}
+		}
+		return nullptr;
+	}
+
+	/// @brief Parse an expression up to the first binary operator that binds no tighter than
+	/// `minPrecedence`. The operators of equal precedence are left to the caller, which makes
+	/// them associate to the left
+	std::unique_ptr<Expression> parseExpression(int minPrecedence) {
+		if (++m_depth > maxNestingDepth) {
+			throw ParseError("Expression nested too deeply", m_pos);
+		}
+
+		std::unique_ptr<Expression> left = parsePrefix();
+		while (const BinaryOperatorInfo* op = findBinaryOperator(peek())) {
+			if (op->precedence <= minPrecedence) {
+				break;
+			}
+			++m_pos;
+			left = op->make(std::move(left), parseExpression(op->precedence));
+		}
+
+		--m_depth;
+		return left;
+	}
+
+	std::unique_ptr<Expression> parsePrefix() {
+		const char c = peek();
+		if (c == '-') {
+			++m_pos;
+			return std::make_unique<Negation>(parseExpression(negationPrecedence));
+		}
+		if (c == '(') {
+			++m_pos;
+			std::unique_ptr<Expression> expr = parseExpression(0);
+			expect(')', "Expected ')'");
+			return expr;
+		}
+		if (isDigit(c) || c == '.') {
+			return parseNumber();
+		}
+		if (isNameStart(c)) {
+			return parseName();
+		}
+		throw ParseError(c == '\0' ? "Unexpected end of the expression" : "Expected an expression",
+			m_pos);
+	}
+
+	std::unique_ptr<Expression> parseNumber() {
+		double value{};
+		const char* begin = m_text.data() + m_pos;
+		const auto [end, error] = std::from_chars(begin, m_text.data() + m_text.size(), value);
+		if (error != std::errc()) {
+			throw ParseError(error == std::errc::result_out_of_range ? "Number out of range"
+				: "Invalid number", m_pos);
+		}
+		m_pos += static_cast<size_t>(end - begin);
+		return std::make_unique<Number>(value);
+	}
+
+	std::unique_ptr<Expression> parseName() {
+		const size_t begin = m_pos;
+		while (m_pos < m_text.size() && (isNameStart(m_text[m_pos]) || isDigit(m_text[m_pos]))) {
+			++m_pos;
+		}
+		const std::string_view name = m_text.substr(begin, m_pos - begin);
+
+		if (peek() == '(') {
+			for (const FunctionInfo& function : functions) {
+				if (function.name == name) {
+					return parseCall(function);
+				}
+			}
+			throw ParseError("Unknown function", begin);
+		}
+
+		for (size_t i = 0; i < m_variableNames.size(); ++i) {
+			if (m_variableNames[i] == name) {
+				return std::make_unique<Variable>(i, m_variableNames[i], Variable::BorrowName());
+			}
+		}
+		throw ParseError("Unknown variable", begin);
+	}
+
+	/// @brief Parse the arguments in parentheses of a call of `function`
+	std::unique_ptr<Expression> parseCall(const FunctionInfo& function) {
+		expect('(', "Expected '('");
+		std::unique_ptr<Expression> first = parseExpression(0);
+		std::unique_ptr<Expression> result;
+		if (function.makeUnary) {
+			result = function.makeUnary(std::move(first));
+		}
+		else {
+			expect(',', "Expected ','");
+			result = function.makeBinary(std::move(first), parseExpression(0));
+		}
+		expect(')', "Expected ')'");
+		return result;
+	}
+
+	std::string_view m_text;
+	ArrayView<const std::string_view> m_variableNames;
+	size_t m_pos = 0;
+	size_t m_depth = 0;
+};
+
+} // namespace
+
+ParseError::ParseError(const char* what, size_t position):
+	std::runtime_error(std::string(what) + " at position " + std::to_string(position)),
+	m_position(position)
+{ }
+
+std::unique_ptr<Expression> parseExpression(std::string_view text,
+	ArrayView<const std::string_view> variableNames, ExpressionArena* arena)
+{
+	std::optional<ExpressionArena::Scope> scope;
+	if (arena) {
+		scope.emplace(*arena);
+	}
+	return Parser(text, variableNames).parse();
+}
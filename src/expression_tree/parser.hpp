@@ -0,0 +1,45 @@
+#ifndef PARSER_HPP_INCLUDED
+#define PARSER_HPP_INCLUDED
+
+#include <cstddef>
+
+#include <memory>
+#include <stdexcept>
+#include <string_view>
+
+#include "array_view/array_view.hpp"
+#include "expression_tree/expression.hpp"
+#include "expression_tree/expression_arena.hpp"
+
+/// @brief The error of `parseExpression()`: what is wrong and where
+class ParseError: public std::runtime_error {
+public:
+	ParseError(const char* what, size_t position);
+
+	/// @brief The offset of the first character that couldn't be parsed
+	size_t position() const {
+		return m_position;
+	}
+
+private:
+	size_t m_position;
+};
+
+/// @brief Parse an expression in the infix notation written by `printInfixRecursive()`, e.g.
+/// `2 * sin(x) + pow(y, 0.5)`. The binary operators bind by the `precedence()` of their nodes
+/// and associate to the left.
+///
+/// The parser is a Pratt parser that reads the tokens straight from `text`, without a token
+/// list or copies of the text, and reads the numbers with `std::from_chars`. The only
+/// allocations are the nodes, which come from `arena` if one is given: the variables refer to
+/// the names in `variableNames` rather than copying them
+/// @param variableNames The names of the variables, the variable `variableNames[i]` gets
+/// the index `i`. The characters of the names must outlive the tree and its clones, the array
+/// itself need not
+/// @param arena The arena to allocate the nodes from, or `nullptr` for the heap
+/// @throws ParseError if `text` is not a single complete expression, has an unknown name, or its
+/// parentheses are nested too deeply
+std::unique_ptr<Expression> parseExpression(std::string_view text,
+	ArrayView<const std::string_view> variableNames = {}, ExpressionArena* arena = nullptr);
+
+#endif
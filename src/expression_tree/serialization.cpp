@@ -0,0 +1,343 @@
+#include "expression_tree/serialization.hpp"
+
+#include <cassert>
+#include <cstdint>
+#include <cstring>
+
+#include <bit>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <utility>
+
+#include "expression_tree/functions.hpp"
+#include "expression_tree/operators.hpp"
+
+namespace {
+
+/// @brief The first bytes of a library, the last one being the version of the format
+constexpr char libraryMagic[8] = {'E', 'X', 'P', 'R', 'L', 'I', 'B', '1'};
+
+/// @brief The magic and the number of the expressions, followed by the offsets
+constexpr size_t libraryHeaderSize = sizeof(libraryMagic) + sizeof(std::uint64_t);
+
+void writeUint64(std::vector<std::byte>& output, std::uint64_t value) {
+	for (int i = 0; i < 8; ++i) {
+		output.push_back(static_cast<std::byte>(value >> (8 * i)));
+	}
+}
+
+void storeUint64(std::byte* destination, std::uint64_t value) {
+	for (int i = 0; i < 8; ++i) {
+		destination[i] = static_cast<std::byte>(value >> (8 * i));
+	}
+}
+
+std::uint64_t loadUint64(const std::byte* source) {
+	std::uint64_t value = 0;
+	for (int i = 0; i < 8; ++i) {
+		value |= std::to_integer<std::uint64_t>(source[i]) << (8 * i);
+	}
+	return value;
+}
+
+/// @brief Write `value` in LEB128: 7 bits per byte from the lowest ones, the high bit set on
+/// every byte but the last
+void writeVarint(std::vector<std::byte>& output, std::uint64_t value) {
+	while (value >= 0x80) {
+		output.push_back(static_cast<std::byte>(value | 0x80));
+		value >>= 7;
+	}
+	output.push_back(static_cast<std::byte>(value));
+}
+
+/// @brief Reads the parts of an encoding one after another, checking that they are all there
+class Decoder {
+public:
+	explicit Decoder(ArrayView<const std::byte> data): m_data(data) { }
+
+	bool atEnd() const {
+		return m_pos == m_data.size();
+	}
+
+	size_t position() const {
+		return m_pos;
+	}
+
+	OpCode readOp() {
+		const std::uint8_t value = std::to_integer<std::uint8_t>(m_data[m_pos]);
+		if (value > static_cast<std::uint8_t>(OpCode::Pow)) {
+			throw SerializationError("Unknown instruction", m_pos);
+		}
+		++m_pos;
+		return static_cast<OpCode>(value);
+	}
+
+	double readDouble() {
+		require(sizeof(double));
+		const double value = std::bit_cast<double>(loadUint64(m_data.data() + m_pos));
+		m_pos += sizeof(double);
+		return value;
+	}
+
+	std::uint64_t readVarint() {
+		const size_t begin = m_pos;
+		std::uint64_t value = 0;
+		for (unsigned shift = 0; ; shift += 7) {
+			require(1);
+			const std::uint64_t byte = std::to_integer<std::uint64_t>(m_data[m_pos++]);
+			// The 10th byte holds the highest bit only
+			if (shift == 63 && byte > 1) {
+				throw SerializationError("Number out of range", begin);
+			}
+			value |= (byte & 0x7f) << shift;
+			if ((byte & 0x80) == 0) {
+				return value;
+			}
+		}
+	}
+
+	std::string_view readString(std::uint64_t length) {
+		require(length);
+		const std::string_view result(reinterpret_cast<const char*>(m_data.data() + m_pos),
+			static_cast<size_t>(length));
+		m_pos += result.size();
+		return result;
+	}
+
+private:
+	void require(std::uint64_t length) const {
+		if (length > m_data.size() - m_pos) {
+			throw SerializationError("Unexpected end of the data", m_data.size());
+		}
+	}
+
+	ArrayView<const std::byte> m_data;
+	size_t m_pos = 0;
+};
+
+/// @brief Read the instructions encoded in `data`, checking that they compute a single value,
+/// and pass them on to `builder.constant(value)`, `builder.variable(index, name)` and
+/// `builder.operation(op)`
+template<typename Builder>
+void decode(ArrayView<const std::byte> data, Builder& builder) {
+	if (data.empty()) {
+		throw SerializationError("Empty expression", 0);
+	}
+
+	Decoder decoder(data);
+	size_t stackDepth = 0;
+	while (!decoder.atEnd()) {
+		const size_t position = decoder.position();
+		const OpCode op = decoder.readOp();
+		if (op == OpCode::Constant) {
+			builder.constant(decoder.readDouble());
+		}
+		else if (op == OpCode::Variable) {
+			const std::uint64_t index = decoder.readVarint();
+			// `Program::variableCount()` is one past the index
+			if (index >= SIZE_MAX) {
+				throw SerializationError("Variable index out of range", position + 1);
+			}
+			const std::string_view name = decoder.readString(decoder.readVarint());
+			builder.variable(static_cast<size_t>(index), name);
+		}
+		else {
+			if (stackDepth < operandCount(op)) {
+				throw SerializationError("Missing operand", position);
+			}
+			builder.operation(op);
+		}
+		stackDepth = stackDepth - operandCount(op) + 1;
+	}
+
+	if (stackDepth != 1) {
+		throw SerializationError("Expected a single expression", data.size());
+	}
+}
+
+/// @brief Builds the tree from the bottom, with the subtrees finished so far on a stack
+class TreeBuilder {
+public:
+	void constant(double value) {
+		m_stack.push_back(std::make_unique<Number>(value));
+	}
+
+	void variable(size_t index, std::string_view name) {
+		m_stack.push_back(std::make_unique<Variable>(index, std::string(name)));
+	}
+
+	void operation(OpCode op) {
+		std::unique_ptr<Expression> second;
+		if (operandCount(op) == 2) {
+			second = std::move(m_stack.back());
+			m_stack.pop_back();
+		}
+		std::unique_ptr<Expression>& top = m_stack.back();
+		top = makeNode(op, std::move(top), std::move(second));
+	}
+
+	std::unique_ptr<Expression> result() {
+		assert(m_stack.size() == 1);
+		return std::move(m_stack.back());
+	}
+
+private:
+	static std::unique_ptr<Expression> makeNode(OpCode op, std::unique_ptr<Expression> first,
+		std::unique_ptr<Expression> second)
+	{
+		switch (op) {
+		case OpCode::Negate:
+			return std::make_unique<Negation>(std::move(first));
+		case OpCode::Add:
+			return std::make_unique<Addition>(std::move(first), std::move(second));
+		case OpCode::Subtract:
+			return std::make_unique<Subtraction>(std::move(first), std::move(second));
+		case OpCode::Multiply:
+			return std::make_unique<Multiplication>(std::move(first), std::move(second));
+		case OpCode::Divide:
+			return std::make_unique<Division>(std::move(first), std::move(second));
+		case OpCode::Sin:
+			return std::make_unique<Sin>(std::move(first));
+		case OpCode::Cos:
+			return std::make_unique<Cos>(std::move(first));
+		case OpCode::Sqrt:
+			return std::make_unique<Sqrt>(std::move(first));
+		case OpCode::Pow:
+			return std::make_unique<Pow>(std::move(first), std::move(second));
+		case OpCode::Constant:
+		case OpCode::Variable:
+			break;
+		}
+		assert(false);
+		return nullptr;
+	}
+
+	std::vector<std::unique_ptr<Expression>> m_stack;
+};
+
+/// @brief Appends the instructions to a program as they come
+class ProgramBuilder {
+public:
+	void constant(double value) {
+		m_program.emitConstant(value);
+	}
+
+	void variable(size_t index, std::string_view) {
+		m_program.emitVariable(index);
+	}
+
+	void operation(OpCode op) {
+		m_program.emit(op);
+	}
+
+	Program result() {
+		return std::move(m_program);
+	}
+
+private:
+	Program m_program;
+};
+
+} // namespace
+
+SerializationError::SerializationError(const char* what, size_t offset):
+	std::runtime_error(std::string(what) + " at offset " + std::to_string(offset)),
+	m_offset(offset)
+{ }
+
+void serializeExpression(const Expression& expr, std::vector<std::byte>& output) {
+	assert(expr.isComplete());
+
+	// Compile the nodes one by one, as `compile()` does, and read back the instruction of each
+	Program program;
+	expr.visitPostOrder([&program, &output](const Expression* node) {
+		// A complete expression has no missing children to skip
+		if (!node) {
+			return;
+		}
+		node->compileNode(program);
+		const OpCode op = program.code().back();
+		output.push_back(static_cast<std::byte>(op));
+		if (op == OpCode::Constant) {
+			writeUint64(output, std::bit_cast<std::uint64_t>(program.constants().back()));
+		}
+		else if (op == OpCode::Variable) {
+			const Variable* variable = dynamic_cast<const Variable*>(node);
+			assert(variable);
+			writeVarint(output, variable->index());
+			const bool isDefaultName = variable->name() == Variable(variable->index()).name();
+			const std::string_view name = isDefaultName ? std::string_view() : variable->name();
+			writeVarint(output, name.size());
+			const std::byte* nameBytes = reinterpret_cast<const std::byte*>(name.data());
+			output.insert(output.end(), nameBytes, nameBytes + name.size());
+		}
+	});
+}
+
+std::unique_ptr<Expression> deserializeExpression(ArrayView<const std::byte> data,
+	ExpressionArena* arena)
+{
+	std::optional<ExpressionArena::Scope> scope;
+	if (arena) {
+		scope.emplace(*arena);
+	}
+	TreeBuilder builder;
+	decode(data, builder);
+	return builder.result();
+}
+
+Program deserializeProgram(ArrayView<const std::byte> data) {
+	ProgramBuilder builder;
+	decode(data, builder);
+	return builder.result();
+}
+
+void serializeLibrary(ArrayView<const Expression* const> expressions,
+	std::vector<std::byte>& output)
+{
+	const size_t start = output.size();
+	const std::byte* magic = reinterpret_cast<const std::byte*>(libraryMagic);
+	output.insert(output.end(), magic, magic + sizeof(libraryMagic));
+	writeUint64(output, expressions.size());
+
+	// Reserve the offsets, and fill them in as the encodings are written
+	const size_t offsets = output.size();
+	output.resize(offsets + (expressions.size() + 1) * sizeof(std::uint64_t));
+	for (size_t i = 0; i < expressions.size(); ++i) {
+		storeUint64(output.data() + offsets + i * sizeof(std::uint64_t), output.size() - start);
+		serializeExpression(*expressions[i], output);
+	}
+	storeUint64(output.data() + offsets + expressions.size() * sizeof(std::uint64_t),
+		output.size() - start);
+}
+
+ExpressionLibrary::ExpressionLibrary(ArrayView<const std::byte> data):
+	m_data(data),
+	m_size(0)
+{
+	if (data.size() < libraryHeaderSize
+		|| std::memcmp(data.data(), libraryMagic, sizeof(libraryMagic)) != 0)
+	{
+		throw SerializationError("Not an expression library", 0);
+	}
+
+	// There must be room for one offset more than the expressions
+	const std::uint64_t size = loadUint64(data.data() + sizeof(libraryMagic));
+	if (size >= (data.size() - libraryHeaderSize) / sizeof(std::uint64_t)) {
+		throw SerializationError("Offsets out of the library", sizeof(libraryMagic));
+	}
+	m_size = static_cast<size_t>(size);
+}
+
+ArrayView<const std::byte> ExpressionLibrary::operator[](size_t index) const {
+	assert(index < m_size);
+	const size_t offset = libraryHeaderSize + index * sizeof(std::uint64_t);
+	const std::uint64_t begin = loadUint64(m_data.data() + offset);
+	const std::uint64_t end = loadUint64(m_data.data() + offset + sizeof(std::uint64_t));
+	const size_t offsetsEnd = libraryHeaderSize + (m_size + 1) * sizeof(std::uint64_t);
+	if (begin < offsetsEnd || begin > end || end > m_data.size()) {
+		throw SerializationError("Expression out of the library", offset);
+	}
+	return m_data.subview(static_cast<size_t>(begin), static_cast<size_t>(end - begin));
+}
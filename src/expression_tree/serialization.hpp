@@ -0,0 +1,89 @@
+#ifndef SERIALIZATION_HPP_INCLUDED
+#define SERIALIZATION_HPP_INCLUDED
+
+#include <cstddef>
+
+#include <memory>
+#include <stdexcept>
+#include <vector>
+
+#include "array_view/array_view.hpp"
+#include "expression_tree/bytecode.hpp"
+#include "expression_tree/expression.hpp"
+#include "expression_tree/expression_arena.hpp"
+
+// The binary encoding of an expression is its post-order instruction stream, the same order as
+// the instructions of `Program`:
+// - every node is the byte of its `OpCode`, after the encodings of its children;
+// - `OpCode::Constant` is followed by the 8 bytes of the IEEE 754 value, little-endian, so the
+//   numbers are restored to the last bit;
+// - `OpCode::Variable` is followed by the index and by the length of the name as LEB128 varints,
+//   then the bytes of the name. An empty name stands for the default one.
+// The number of the children follows from the `OpCode`, and the encoding takes up the whole
+// range of bytes it is read from. There is no alignment, so the encodings can be read in place
+// from anywhere, e.g. from a memory mapped file
+
+/// @brief The error of the readers of the binary encoding: what is wrong and where
+class SerializationError: public std::runtime_error {
+public:
+	SerializationError(const char* what, size_t offset);
+
+	/// @brief The offset of the first byte that couldn't be read
+	size_t offset() const {
+		return m_offset;
+	}
+
+private:
+	size_t m_offset;
+};
+
+/// @brief Append the binary encoding of `expr` to `output`
+/// @pre `expr.isComplete()`
+void serializeExpression(const Expression& expr, std::vector<std::byte>& output);
+
+/// @brief Build the tree encoded in `data` by `serializeExpression()`. The tree is built bottom
+/// up with a stack of the finished subtrees, so any depth is fine
+/// @param arena The arena to allocate the nodes from, or `nullptr` for the heap
+/// @throws SerializationError if `data` is not the encoding of a single expression
+std::unique_ptr<Expression> deserializeExpression(ArrayView<const std::byte> data,
+	ExpressionArena* arena = nullptr);
+
+/// @brief Read the expression encoded in `data` by `serializeExpression()` straight into the
+/// program `compile()` would make of it, without building the tree. The names of the variables
+/// are skipped
+/// @throws SerializationError if `data` is not the encoding of a single expression
+Program deserializeProgram(ArrayView<const std::byte> data);
+
+/// @brief Append a library of expressions to `output`: an 8-byte magic, the number of the
+/// expressions and the offsets of their encodings as 64-bit little-endian integers, then the
+/// encodings. The offsets are from the start of the library, and the one past the last
+/// expression is the end of the library
+/// @pre All of `expressions` are complete
+void serializeLibrary(ArrayView<const Expression* const> expressions,
+	std::vector<std::byte>& output);
+
+/// @brief A view of a library written by `serializeLibrary()`, e.g. in a memory mapped file.
+/// Opening a library checks its header only, and taking an expression reads its two offsets,
+/// so a large library costs nothing until its expressions are read
+class ExpressionLibrary {
+public:
+	/// @throws SerializationError if `data` doesn't start with the header of a library
+	explicit ExpressionLibrary(ArrayView<const std::byte> data);
+
+	/// @brief The number of the expressions
+	size_t size() const {
+		return m_size;
+	}
+
+	/// @brief The encoding of the expression at `index`, to be read by `deserializeExpression()`
+	/// or `deserializeProgram()`
+	/// @pre `index < size()`
+	/// @throws SerializationError if the offsets of the expression are out of the library
+	ArrayView<const std::byte> operator[](size_t index) const;
+
+private:
+	ArrayView<const std::byte> m_data;
+	size_t m_size;
+};
+
+#endif
@@ -0,0 +1,280 @@
+#include "expression_tree/simplify.hpp"
+
+#include <cassert>
+#include <cfenv>
+#include <cmath>
+#include <cstdint>
+
+#include <bit>
+#include <functional>
+#include <typeinfo>
+#include <utility>
+#include <vector>
+
+#include "expression_tree/functions.hpp"
+#include "expression_tree/operators.hpp"
+
+namespace {
+
+const Number* asNumber(const Expression* expr) {
+	return dynamic_cast<const Number*>(expr);
+}
+
+/// @brief Check whether `expr` is the number `value`. Tells `+0` from `-0`
+bool isNumber(const Expression* expr, double value) {
+	const Number* number = asNumber(expr);
+	return number && number->value() == value
+		&& std::signbit(number->value()) == std::signbit(value);
+}
+
+/// @brief Check whether two trees are the same node by node
+bool isSameExpression(const Expression& a, const Expression& b) {
+	// The pairs of the nodes left to compare, on a stack on the heap as the trees may be deep
+	std::vector<std::pair<const Expression*, const Expression*>> pending{{&a, &b}};
+	while (!pending.empty()) {
+		const auto [first, second] = pending.back();
+		pending.pop_back();
+		if (typeid(*first) != typeid(*second)) {
+			return false;
+		}
+		if (const Number* number = asNumber(first)) {
+			if (std::bit_cast<uint64_t>(number->value())
+				!= std::bit_cast<uint64_t>(asNumber(second)->value()))
+			{
+				return false;
+			}
+			continue;
+		}
+		if (const Variable* variable = dynamic_cast<const Variable*>(first)) {
+			if (variable->index() != static_cast<const Variable*>(second)->index()) {
+				return false;
+			}
+			continue;
+		}
+
+		for (size_t i = 0; i < first->arity(); ++i) {
+			pending.emplace_back(first->child(i), second->child(i));
+		}
+	}
+	return true;
+}
+
+/// @brief Replace a node whose children are all numbers with its value. Returns `nullptr` if
+/// the node has other children or if its evaluation raises a floating point exception
+std::unique_ptr<Expression> foldConstant(const Expression& expr) {
+	if (expr.arity() == 0) {
+		return nullptr;
+	}
+	for (size_t i = 0; i < expr.arity(); ++i) {
+		if (!asNumber(expr.child(i))) {
+			return nullptr;
+		}
+	}
+
+	// Don't let the evaluation change the exceptions raised by the caller
+	std::fexcept_t savedFlags;
+	std::fegetexceptflag(&savedFlags, FE_ALL_EXCEPT);
+	std::feclearexcept(FE_ALL_EXCEPT);
+	const double value = expr.eval();
+	const bool isRaised =
+		std::fetestexcept(FE_DIVBYZERO | FE_INVALID | FE_OVERFLOW | FE_UNDERFLOW) != 0;
+	std::fesetexceptflag(&savedFlags, FE_ALL_EXCEPT);
+
+	return isRaised ? nullptr : std::make_unique<Number>(value);
+}
+
+/// @brief `x op value` and `value op x` become `x`, for a commutative `Node`
+template<typename Node>
+RewriteRule removeNeutral(double value) {
+	return makeRewriteRule<Node>([value](Node& node) -> std::unique_ptr<Expression> {
+		if (isNumber(node.second(), value)) {
+			return node.releaseFirst();
+		}
+		if (isNumber(node.first(), value)) {
+			return node.releaseSecond();
+		}
+		return nullptr;
+	});
+}
+
+/// @brief `x op value` becomes `x`
+template<typename Node>
+RewriteRule removeRightNeutral(double value) {
+	return makeRewriteRule<Node>([value](Node& node) -> std::unique_ptr<Expression> {
+		return isNumber(node.second(), value) ? node.releaseFirst() : nullptr;
+	});
+}
+
+/// @brief `(x op a) op b` and the commuted forms become `x op c`, where `c = combine(a, b)`, for
+/// an associative and commutative `Node`
+template<typename Node, typename Combine>
+RewriteRule reassociateConstants(Combine combine) {
+	return makeRewriteRule<Node>([combine](Node& node) -> std::unique_ptr<Expression> {
+		const bool isFirstNumber = asNumber(node.first()) != nullptr;
+		const Number* outer = asNumber(isFirstNumber ? node.first() : node.second());
+		Node* inner = dynamic_cast<Node*>(isFirstNumber ? node.second() : node.first());
+		if (!outer || !inner) {
+			return nullptr;
+		}
+		const bool isInnerFirstNumber = asNumber(inner->first()) != nullptr;
+		const Number* innerNumber = asNumber(isInnerFirstNumber ? inner->first() : inner->second());
+		if (!innerNumber) {
+			return nullptr;
+		}
+
+		const double value = combine(innerNumber->value(), outer->value());
+		return std::make_unique<Node>(
+			isInnerFirstNumber ? inner->releaseSecond() : inner->releaseFirst(),
+			std::make_unique<Number>(value));
+	});
+}
+
+std::unique_ptr<Expression> simplifyNode(std::unique_ptr<Expression> expr,
+	const SimplifyOptions& options)
+{
+	while (true) {
+		if (options.foldConstants) {
+			if (std::unique_ptr<Expression> folded = foldConstant(*expr)) {
+				return folded;
+			}
+		}
+
+		std::unique_ptr<Expression> replacement;
+		for (const RewriteRule& rule : options.rules) {
+			replacement = rule(*expr);
+			if (replacement) {
+				break;
+			}
+		}
+		if (!replacement) {
+			return expr;
+		}
+		// The replacement may match the rules again, e.g. `---x`
+		expr = std::move(replacement);
+	}
+}
+
+/// @brief Simplify the children before their parent, with the stacks on the heap, so any depth
+/// of the tree is fine. The nodes are taken out of their parents on the way down, which
+/// `Expression::visitPostOrder()` can't do, and put back simplified on the way up
+std::unique_ptr<Expression> simplifyTree(std::unique_ptr<Expression> expr,
+	const SimplifyOptions& options)
+{
+	// A node on the way down with its children taken out so far. The casts to the kinds of the
+	// node are made once, as they are slow
+	struct Frame {
+		explicit Frame(std::unique_ptr<Expression> expr):
+			node(std::move(expr)),
+			unary(dynamic_cast<UnaryExpression*>(node.get())),
+			binary(unary ? nullptr : dynamic_cast<BinaryExpression*>(node.get())),
+			arity(node->arity())
+		{ }
+
+		std::unique_ptr<Expression> node;
+		UnaryExpression* unary;
+		BinaryExpression* binary;
+		size_t arity;
+		size_t nextChild = 0;
+	};
+	// The simplified subtrees, the children of the node on the top of `stack` on the top
+	std::vector<std::unique_ptr<Expression>> finished;
+	std::vector<Frame> stack;
+	stack.emplace_back(std::move(expr));
+	while (!stack.empty()) {
+		Frame& top = stack.back();
+		if (top.nextChild < top.arity) {
+			std::unique_ptr<Expression> child = top.unary ? top.unary->releaseFirst()
+				: top.nextChild == 0 ? top.binary->releaseFirst() : top.binary->releaseSecond();
+			++top.nextChild;
+			stack.emplace_back(std::move(child));
+			continue;
+		}
+
+		const size_t firstChild = finished.size() - top.arity;
+		if (top.unary) {
+			top.unary->setFirst(std::move(finished[firstChild]));
+		}
+		else if (top.binary) {
+			top.binary->setFirst(std::move(finished[firstChild]));
+			top.binary->setSecond(std::move(finished[firstChild + 1]));
+		}
+		finished.resize(firstChild);
+		finished.push_back(simplifyNode(std::move(top.node), options));
+		stack.pop_back();
+	}
+	assert(finished.size() == 1);
+	return finished.empty() ? nullptr : std::move(finished.back());
+}
+
+} // namespace
+
+std::vector<RewriteRule> exactRewriteRules() {
+	return {
+		makeRewriteRule<Negation>([](Negation& node) -> std::unique_ptr<Expression> {
+			Negation* inner = dynamic_cast<Negation*>(node.first());
+			return inner ? inner->releaseFirst() : nullptr;
+		}),
+		// `x + 0` is not `x` for `x = -0`, but `x + -0` is `x` for every `x`
+		removeNeutral<Addition>(-0.0),
+		removeRightNeutral<Subtraction>(0.0),
+		removeNeutral<Multiplication>(1.0),
+		removeRightNeutral<Division>(1.0),
+		removeRightNeutral<Pow>(1.0),
+		// The subtraction is defined as the addition of the negated operand
+		makeRewriteRule<Addition>([](Addition& node) -> std::unique_ptr<Expression> {
+			if (Negation* second = dynamic_cast<Negation*>(node.second())) {
+				return std::make_unique<Subtraction>(node.releaseFirst(), second->releaseFirst());
+			}
+			if (Negation* first = dynamic_cast<Negation*>(node.first())) {
+				return std::make_unique<Subtraction>(node.releaseSecond(), first->releaseFirst());
+			}
+			return nullptr;
+		}),
+		makeRewriteRule<Subtraction>([](Subtraction& node) -> std::unique_ptr<Expression> {
+			Negation* second = dynamic_cast<Negation*>(node.second());
+			return second
+				? std::make_unique<Addition>(node.releaseFirst(), second->releaseFirst())
+				: nullptr;
+		}),
+	};
+}
+
+std::vector<RewriteRule> fastMathRewriteRules() {
+	std::vector<RewriteRule> rules = exactRewriteRules();
+	const auto zero = [] { return std::make_unique<Number>(0); };
+	const auto one = [] { return std::make_unique<Number>(1); };
+
+	rules.push_back(removeNeutral<Addition>(0.0));
+	rules.push_back(makeRewriteRule<Subtraction>(
+		[zero](Subtraction& node) -> std::unique_ptr<Expression> {
+			if (isSameExpression(*node.first(), *node.second())) {
+				return zero();
+			}
+			if (isNumber(node.first(), 0.0)) {
+				return std::make_unique<Negation>(node.releaseSecond());
+			}
+			return nullptr;
+		}));
+	rules.push_back(makeRewriteRule<Multiplication>(
+		[zero](Multiplication& node) -> std::unique_ptr<Expression> {
+			const bool isZero = isNumber(node.first(), 0.0) || isNumber(node.second(), 0.0);
+			return isZero ? zero() : nullptr;
+		}));
+	rules.push_back(makeRewriteRule<Division>(
+		[one](Division& node) -> std::unique_ptr<Expression> {
+			return isSameExpression(*node.first(), *node.second()) ? one() : nullptr;
+		}));
+	rules.push_back(makeRewriteRule<Pow>([one](Pow& node) -> std::unique_ptr<Expression> {
+		return isNumber(node.second(), 0.0) ? one() : nullptr;
+	}));
+	rules.push_back(reassociateConstants<Addition>(std::plus<double>()));
+	rules.push_back(reassociateConstants<Multiplication>(std::multiplies<double>()));
+	return rules;
+}
+
+std::unique_ptr<Expression> simplify(std::unique_ptr<Expression> expr,
+	const SimplifyOptions& options)
+{
+	assert(expr && expr->isComplete());
+	return simplifyTree(std::move(expr), options);
+}
@@ -0,0 +1,53 @@
+#ifndef SIMPLIFY_HPP_INCLUDED
+#define SIMPLIFY_HPP_INCLUDED
+
+#include <functional>
+#include <memory>
+#include <vector>
+
+#include "expression_tree/expression.hpp"
+
+/// @brief A rewrite rule of `simplify()`: returns the replacement of `expr` or `nullptr` if the
+/// rule doesn't apply. The children of `expr` are already simplified. The replacement may be
+/// built from the children taken with `releaseFirst()` and `releaseSecond()`, but `expr` must be
+/// left untouched if the rule returns `nullptr`
+/// @note The replacement must be smaller than `expr`, otherwise `simplify()` may never finish
+using RewriteRule = std::function<std::unique_ptr<Expression>(Expression& expr)>;
+
+/// @brief Make a rule that applies `rewrite(node)` to the nodes of the type `Node` only
+template<typename Node, typename Rewrite>
+RewriteRule makeRewriteRule(Rewrite rewrite) {
+	return [rewrite](Expression& expr) -> std::unique_ptr<Expression> {
+		Node* node = dynamic_cast<Node*>(&expr);
+		return node ? rewrite(*node) : nullptr;
+	};
+}
+
+/// @brief The rules that keep the value of the expression bit exact and raise the same floating
+/// point exceptions: `--x`, `x + -0`, `x - 0`, `x * 1`, `x / 1` and `pow(x, 1)` become `x`,
+/// `x + -y` becomes `x - y` and `x - -y` becomes `x + y`
+std::vector<RewriteRule> exactRewriteRules();
+
+/// @brief The exact rules and those that are right for finite values only and ignore the sign of
+/// zero, as a compiler does with fast math: `x + 0` becomes `x`, `x - x` and `x * 0` become `0`,
+/// `0 - x` becomes `-x`, `x / x` and `pow(x, 0)` become `1`, and the constants are reassociated,
+/// e.g. `(x + 2) + 3` becomes `x + 5`
+std::vector<RewriteRule> fastMathRewriteRules();
+
+struct SimplifyOptions {
+	/// @brief Replace the subtrees without variables with their values. The subtrees that raise
+	/// `FE_DIVBYZERO`, `FE_INVALID`, `FE_OVERFLOW` or `FE_UNDERFLOW` are kept, so that
+	/// the evaluation of the expression still raises them
+	bool foldConstants = true;
+	/// @brief The rules tried in order on every node, bottom-up
+	std::vector<RewriteRule> rules = exactRewriteRules();
+};
+
+/// @brief Fold the constant subtrees and apply the rewrite rules until none of them applies.
+/// With the default options the value of the simplified expression is bit exact
+/// @note Iterative, any depth of the tree is fine
+/// @pre `expr && expr->isComplete()`
+std::unique_ptr<Expression> simplify(std::unique_ptr<Expression> expr,
+	const SimplifyOptions& options = {});
+
+#endif
@@ -0,0 +1,259 @@
+#include "expression_tree/variant_expression.hpp"
+
+#include <cassert>
+#include <cmath>
+
+#include <vector>
+
+namespace {
+
+using Tree = std::unique_ptr<VariantExpression>;
+
+/// @brief The recursion of `eval()` goes this deep at most, as that of `Expression::eval()`
+constexpr unsigned maxRecursionDepth = 512;
+
+/// @brief The children of a node, `nullptr` past its arity
+struct Children {
+	const VariantExpression* first = nullptr;
+	const VariantExpression* second = nullptr;
+};
+
+Children children(const VariantExpression::NumberNode&) {
+	return {};
+}
+
+Children children(const VariantExpression::VariableNode&) {
+	return {};
+}
+
+template<OpCode Op>
+Children children(const VariantExpression::UnaryNode<Op>& node) {
+	return {node.first.get()};
+}
+
+template<OpCode Op>
+Children children(const VariantExpression::BinaryNode<Op>& node) {
+	return {node.first.get(), node.second.get()};
+}
+
+/// @brief Compute the value of the node alone from the values of its children
+double applyNode(const VariantExpression::NumberNode& node, double, double,
+	ArrayView<const double>)
+{
+	return node.value;
+}
+
+double applyNode(const VariantExpression::VariableNode& node, double, double,
+	ArrayView<const double> variables)
+{
+	assert(node.index < variables.size());
+	return variables[node.index];
+}
+
+template<OpCode Op>
+double applyNode(const VariantExpression::UnaryNode<Op>&, double first, double,
+	ArrayView<const double>)
+{
+	if constexpr (Op == OpCode::Negate) {
+		return -first;
+	}
+	else if constexpr (Op == OpCode::Sin) {
+		return std::sin(first);
+	}
+	else if constexpr (Op == OpCode::Cos) {
+		return std::cos(first);
+	}
+	else {
+		static_assert(Op == OpCode::Sqrt);
+		return std::sqrt(first);
+	}
+}
+
+template<OpCode Op>
+double applyNode(const VariantExpression::BinaryNode<Op>&, double first, double second,
+	ArrayView<const double>)
+{
+	if constexpr (Op == OpCode::Add) {
+		return first + second;
+	}
+	else if constexpr (Op == OpCode::Subtract) {
+		return first - second;
+	}
+	else if constexpr (Op == OpCode::Multiply) {
+		return first * second;
+	}
+	else if constexpr (Op == OpCode::Divide) {
+		return first / second;
+	}
+	else {
+		static_assert(Op == OpCode::Pow);
+		return std::pow(first, second);
+	}
+}
+
+double evalIterative(const VariantExpression& root, ArrayView<const double> variables) {
+	// A node goes back on the stack below its children and is computed when it comes up again,
+	// as in `ExpressionPool::schedule()`. The values of the finished subtrees, the operands of
+	// the next node on the top, wait on `values`
+	struct Entry {
+		const VariantExpression* expr;
+		bool isExpanded;
+	};
+	std::vector<double> values;
+	std::vector<Entry> stack{{&root, false}};
+	while (!stack.empty()) {
+		const Entry entry = stack.back();
+		stack.pop_back();
+		std::visit([&](const auto& node) {
+			const Children operands = children(node);
+			if (!entry.isExpanded && operands.first) {
+				stack.push_back({entry.expr, true});
+				if (operands.second) {
+					stack.push_back({operands.second, false});
+				}
+				stack.push_back({operands.first, false});
+				return;
+			}
+			double second = 0;
+			if (operands.second) {
+				second = values.back();
+				values.pop_back();
+			}
+			double first = 0;
+			if (operands.first) {
+				first = values.back();
+				values.pop_back();
+			}
+			values.push_back(applyNode(node, first, second, variables));
+		}, entry.expr->node());
+	}
+	return values.back();
+}
+
+double evalRecursive(const VariantExpression& expr, ArrayView<const double> variables,
+	unsigned depth);
+
+/// @brief Go on to a child of the node `depth` levels below the root: by the recursion down to
+/// `maxRecursionDepth`, iteratively below
+double evalChild(const VariantExpression* child, ArrayView<const double> variables,
+	unsigned depth)
+{
+	if (!child) {
+		return 0;
+	}
+	return depth < maxRecursionDepth ? evalRecursive(*child, variables, depth + 1)
+		: evalIterative(*child, variables);
+}
+
+double evalRecursive(const VariantExpression& expr, ArrayView<const double> variables,
+	unsigned depth)
+{
+	return std::visit([variables, depth](const auto& node) {
+		const Children operands = children(node);
+		const double first = evalChild(operands.first, variables, depth);
+		const double second = evalChild(operands.second, variables, depth);
+		return applyNode(node, first, second, variables);
+	}, expr.node());
+}
+
+/// @brief Move the children of a node out to the end of `pending`
+void releaseChildren(VariantExpression::Node& node, std::vector<Tree>& pending) {
+	std::visit([&pending](auto& alternative) {
+		if constexpr (requires { alternative.first; }) {
+			if (alternative.first) {
+				pending.push_back(std::move(alternative.first));
+			}
+		}
+		if constexpr (requires { alternative.second; }) {
+			if (alternative.second) {
+				pending.push_back(std::move(alternative.second));
+			}
+		}
+	}, node);
+}
+
+template<OpCode Op>
+Tree makeUnary(Tree first) {
+	return std::make_unique<VariantExpression>(VariantExpression::UnaryNode<Op>{std::move(first)});
+}
+
+template<OpCode Op>
+Tree makeBinary(Tree first, Tree second) {
+	return std::make_unique<VariantExpression>(
+		VariantExpression::BinaryNode<Op>{std::move(first), std::move(second)});
+}
+
+} // namespace
+
+std::unique_ptr<VariantExpression> VariantExpression::fromProgram(const Program& program) {
+	// Run the program with the subtrees in place of the values
+	std::vector<Tree> stack;
+	const double* constant = program.constants().begin();
+	const size_t* variable = program.variableIndices().begin();
+	for (const OpCode op : program.code()) {
+		if (op == OpCode::Constant) {
+			stack.push_back(std::make_unique<VariantExpression>(NumberNode{*constant++}));
+			continue;
+		}
+		if (op == OpCode::Variable) {
+			stack.push_back(std::make_unique<VariantExpression>(VariableNode{*variable++}));
+			continue;
+		}
+
+		Tree second;
+		if (operandCount(op) == 2) {
+			second = std::move(stack.back());
+			stack.pop_back();
+		}
+		Tree& top = stack.back();
+		switch (op) {
+		case OpCode::Negate:
+			top = makeUnary<OpCode::Negate>(std::move(top));
+			break;
+		case OpCode::Add:
+			top = makeBinary<OpCode::Add>(std::move(top), std::move(second));
+			break;
+		case OpCode::Subtract:
+			top = makeBinary<OpCode::Subtract>(std::move(top), std::move(second));
+			break;
+		case OpCode::Multiply:
+			top = makeBinary<OpCode::Multiply>(std::move(top), std::move(second));
+			break;
+		case OpCode::Divide:
+			top = makeBinary<OpCode::Divide>(std::move(top), std::move(second));
+			break;
+		case OpCode::Sin:
+			top = makeUnary<OpCode::Sin>(std::move(top));
+			break;
+		case OpCode::Cos:
+			top = makeUnary<OpCode::Cos>(std::move(top));
+			break;
+		case OpCode::Sqrt:
+			top = makeUnary<OpCode::Sqrt>(std::move(top));
+			break;
+		case OpCode::Pow:
+			top = makeBinary<OpCode::Pow>(std::move(top), std::move(second));
+			break;
+		case OpCode::Constant:
+		case OpCode::Variable:
+			break;
+		}
+	}
+	assert(stack.size() == 1);
+	return stack.empty() ? nullptr : std::move(stack.back());
+}
+
+VariantExpression::~VariantExpression() {
+	// The nodes are destroyed with their children moved out, so their destructors return at once
+	std::vector<Tree> pending;
+	releaseChildren(m_node, pending);
+	while (!pending.empty()) {
+		Tree node = std::move(pending.back());
+		pending.pop_back();
+		releaseChildren(node->m_node, pending);
+	}
+}
+
+double VariantExpression::eval(ArrayView<const double> variables) const {
+	return evalRecursive(*this, variables, 0);
+}
@@ -0,0 +1,85 @@
+#ifndef VARIANT_EXPRESSION_HPP_INCLUDED
+#define VARIANT_EXPRESSION_HPP_INCLUDED
+
+#include <cstddef>
+
+#include <memory>
+#include <variant>
+
+#include "array_view/array_view.hpp"
+#include "expression_tree/bytecode.hpp"
+#include "expression_tree/expression.hpp"
+
+/// @brief A closed alternative to the `Expression` hierarchy: every node is a `std::variant` of
+/// the node kinds, and the evaluation dispatches by `std::visit`, i.e. by the index of the
+/// alternative, instead of by a virtual call. There is no inheritance at all, no vtable pointer
+/// in the nodes, and the compiler sees every kind of node at the dispatch, so it can inline
+/// the operations. The price is that the set of the node kinds is fixed: a new kind means a new
+/// alternative and a new case in every visitor.
+///
+/// The kinds are those of the instructions of `Program`, one alternative per `OpCode`
+class VariantExpression {
+public:
+	struct NumberNode {
+		double value;
+	};
+
+	struct VariableNode {
+		size_t index;
+	};
+
+	template<OpCode Op>
+	struct UnaryNode {
+		std::unique_ptr<VariantExpression> first;
+	};
+
+	template<OpCode Op>
+	struct BinaryNode {
+		std::unique_ptr<VariantExpression> first;
+		std::unique_ptr<VariantExpression> second;
+	};
+
+	using Node = std::variant<
+		NumberNode,
+		VariableNode,
+		UnaryNode<OpCode::Negate>,
+		BinaryNode<OpCode::Add>,
+		BinaryNode<OpCode::Subtract>,
+		BinaryNode<OpCode::Multiply>,
+		BinaryNode<OpCode::Divide>,
+		UnaryNode<OpCode::Sin>,
+		UnaryNode<OpCode::Cos>,
+		UnaryNode<OpCode::Sqrt>,
+		BinaryNode<OpCode::Pow>
+	>;
+
+	explicit VariantExpression(Node node): m_node(std::move(node)) { }
+
+	/// @brief Destroy the children one node at a time from a worklist, so that the destructors
+	/// don't recurse and the depth of the tree is not limited by the call stack
+	~VariantExpression();
+
+	VariantExpression(const VariantExpression&) = delete;
+	VariantExpression& operator=(const VariantExpression&) = delete;
+
+	/// @brief Build the tree of the expression computed by a program made by `compile()`
+	static std::unique_ptr<VariantExpression> fromProgram(const Program& program);
+	/// @pre `expr.isComplete()`
+	static std::unique_ptr<VariantExpression> fromExpression(const Expression& expr) {
+		return fromProgram(compile(expr));
+	}
+
+	/// @brief Evaluate the expression, as `Expression::eval()`
+	/// @pre `variables` has a value for every variable of the expression
+	/// @note Recursive down to 512 levels, iterative below with the values on a stack on the heap
+	double eval(ArrayView<const double> variables = {}) const;
+
+	const Node& node() const {
+		return m_node;
+	}
+
+private:
+	Node m_node;
+};
+
+#endif
@@ -0,0 +1,293 @@
+#include "expression_tree/vector_math.hpp"
+
+#include <cmath>
+#include <cstdint>
+
+#include <algorithm>
+#include <bit>
+#include <limits>
+
+namespace {
+
+#if (defined(__GNUC__) || defined(__clang__)) && defined(__x86_64__) && defined(__linux__)
+/// @brief Compile a function for AVX-512 and AVX2 as well, and pick the version for the processor
+/// when the program is loaded
+#define VECTOR_MATH_CLONES __attribute__((target_clones("avx512f", "avx2", "default")))
+#else
+#define VECTOR_MATH_CLONES
+#endif
+
+#if defined(__GNUC__) || defined(__clang__)
+/// @brief Inline a helper into each of the versions of `VECTOR_MATH_CLONES`, which a call to the
+/// baseline version would defeat
+#define VECTOR_MATH_INLINE __attribute__((always_inline)) inline
+#else
+#define VECTOR_MATH_INLINE inline
+#endif
+
+/// @brief The number of values copied to the stack and computed at once. The loops over whole
+/// chunks have a constant trip count, which the compilers vectorize even at `-O2`
+constexpr size_t chunkSize = 64;
+
+/// @brief Adding and subtracting it rounds the doubles below 2^51 to integers, and leaves the
+/// integer in the low bits of the sum
+constexpr double roundingShift = 0x1.8p52;
+
+constexpr double ln2Hi = 6.93147180369123816490e-01;
+constexpr double ln2Lo = 1.90821492927058770002e-10;
+constexpr double invLn2 = 1.44269504088896338700e+00;
+
+/// @brief pi/2 in three parts, the first two with 33 bits, so that their products by the small
+/// integers are exact
+constexpr double pio2Part1 = 1.57079632673412561417e+00;
+constexpr double pio2Part2 = 6.07710050630396597660e-11;
+constexpr double pio2Part3 = 2.02226624879595063154e-21;
+constexpr double twoOverPi = 6.36619772367581382433e-01;
+
+/// @brief An unevaluated sum of two doubles, `lo` being below the last bit of `hi`
+struct DoubleDouble {
+	double hi;
+	double lo;
+};
+
+/// @brief `a + b` exactly
+inline DoubleDouble twoSum(double a, double b) {
+	const double sum = a + b;
+	const double bPart = sum - a;
+	return {sum, (a - (sum - bPart)) + (b - bPart)};
+}
+
+/// @brief `a + b` exactly
+/// @pre `|a| >= |b|` or `a == 0`
+inline DoubleDouble fastTwoSum(double a, double b) {
+	const double sum = a + b;
+	return {sum, b - (sum - a)};
+}
+
+/// @brief Split `a` into two halves of 26 bits, exactly
+/// @pre `|a| < 2^996`
+inline DoubleDouble split(double a) {
+	const double scaled = 134217729.0 * a;
+	const double hi = scaled - (scaled - a);
+	return {hi, a - hi};
+}
+
+/// @brief `a * b` exactly, by Dekker's algorithm: the products of the halves are exact
+inline DoubleDouble twoProduct(double a, double b) {
+	const double product = a * b;
+	const DoubleDouble aParts = split(a);
+	const DoubleDouble bParts = split(b);
+	const double error = ((aParts.hi * bParts.hi - product) + aParts.hi * bParts.lo
+		+ aParts.lo * bParts.hi) + aParts.lo * bParts.lo;
+	return {product, error};
+}
+
+/// @brief Whether `low <= |x| <= high`. Compares the bits, so a NaN is out of any range and
+/// raises no `FE_INVALID`
+/// @pre `0 <= low <= high`
+inline bool isInRange(double x, double low, double high) {
+	const int64_t bits = std::bit_cast<int64_t>(x) & INT64_MAX;
+	return (bits >= std::bit_cast<int64_t>(low)) & (bits <= std::bit_cast<int64_t>(high));
+}
+
+/// @brief `condition ? x : y` by masking the bits, which the compiler never turns into a branch
+inline double select(bool condition, double x, double y) {
+	const int64_t mask = -static_cast<int64_t>(condition);
+	return std::bit_cast<double>((std::bit_cast<int64_t>(x) & mask)
+		| (std::bit_cast<int64_t>(y) & ~mask));
+}
+
+// The lanes compute every value they are given, those the fast path doesn't cover replaced
+// with 1 so that they raise no exceptions, and the callers replace the results of the values not
+// covered afterwards. A lane ending with a choice between its result and a mark of the values
+// not covered would let the compiler branch around the computation, which it can't vectorize
+
+inline bool isSinCosCovered(double x) {
+	return isInRange(x, 1e-70, 1e5);
+}
+
+inline bool isExpCovered(double x) {
+	return isInRange(x, 1e-70, 708.0);
+}
+
+inline bool isLogCovered(double x) {
+	return isInRange(x, std::numeric_limits<double>::min(), std::numeric_limits<double>::max())
+		& (std::bit_cast<int64_t>(x) >= 0);
+}
+
+inline bool isSqrtCovered(double x) {
+	return isInRange(x, 0.0, std::numeric_limits<double>::infinity())
+		& (std::bit_cast<int64_t>(x) >= 0);
+}
+
+/// @brief Whether the fast path covers `pow(x, y)`, given its `result`: the exponents of the
+/// results out of `[exp(-708), exp(708)]` are clamped by `powLane()`
+inline bool isPowCovered(double x, double y, double result) {
+	return isLogCovered(x) & (isInRange(y, 0.0, 0.0) | isInRange(y, 1e-200, 1e200))
+		& isInRange(result, 4e-308, 3e307);
+}
+
+/// @brief `sin(x)`, or `cos(x)` if `isCos`, by Cody and Waite's reduction to `[-pi/4, pi/4]` and
+/// the polynomials of fdlibm
+template<bool isCos>
+inline double sinCosLane(double x) {
+	const double covered = select(isSinCosCovered(x), x, 1.0);
+
+	const double shifted = covered * twoOverPi + roundingShift;
+	const double n = shifted - roundingShift;
+	const int64_t quadrant = (std::bit_cast<int64_t>(shifted)
+		- std::bit_cast<int64_t>(roundingShift) + (isCos ? 1 : 0)) & 3;
+	const double r = ((covered - n * pio2Part1) - n * pio2Part2) - n * pio2Part3;
+
+	const double z = r * r;
+	const double sinR = r + z * r * (-1.66666666666666324348e-01 + z * (8.33333333332248946124e-03
+		+ z * (-1.98412698298579493134e-04 + z * (2.75573137070700676789e-06
+		+ z * (-2.50507602534068634195e-08 + z * 1.58969099521155010221e-10)))));
+	const double cosTail = z * z * (4.16666666666666019037e-02 + z * (-1.38888888888741095749e-03
+		+ z * (2.48015872894767294178e-05 + z * (-2.75573143513906633035e-07
+		+ z * (2.08757232129817482790e-09 + z * -1.13596475577881948265e-11)))));
+	const double halfZ = 0.5 * z;
+	const double w = 1.0 - halfZ;
+	const double cosR = w + (((1.0 - w) - halfZ) + cosTail);
+
+	// sin(n * pi/2 + r) cycles through sin(r), cos(r), -sin(r) and -cos(r)
+	const double value = select(quadrant & 1, cosR, sinR);
+	return select(quadrant & 2, -value, value);
+}
+
+/// @brief `exp(hi + lo)` by the reduction to `[-ln(2)/2, ln(2)/2]` and the rational
+/// approximation of fdlibm
+/// @pre `|hi| <= 708` and `|lo|` is at most an ulp of `hi`
+inline double expLane(double hi, double lo) {
+	const double shifted = hi * invLn2 + roundingShift;
+	const double n = shifted - roundingShift;
+	const int64_t exponent = std::bit_cast<int64_t>(shifted)
+		- std::bit_cast<int64_t>(roundingShift);
+	const double rHi = hi - n * ln2Hi;
+	const double rLo = n * ln2Lo - lo;
+	const double r = rHi - rLo;
+	// Keep the powers of r from underflowing, exp(r) is 1 + r below that
+	const double rClamped = select(isInRange(r, 1e-70, 1.0), r, 0.0);
+	const double t = rClamped * rClamped;
+	const double c = rClamped - t * (1.66666666666666019037e-01 + t * (-2.77777777770155933842e-03
+		+ t * (6.61375632143793436117e-05 + t * (-1.65339022054652515390e-06
+		+ t * 4.13813679705723846039e-08))));
+	const double y = 1.0 - ((rLo - (rClamped * c) / (2.0 - c)) - rHi);
+	return y * std::bit_cast<double>((exponent + 1023) << 52);
+}
+
+/// @brief `log(x)` as a double-double, by fdlibm's `log(1 + f)` on `[sqrt(2)/2, sqrt(2)]` with
+/// the large terms summed exactly
+/// @pre `x` is normal, positive and finite
+inline DoubleDouble logLane(double x) {
+	const int64_t bits = std::bit_cast<int64_t>(x);
+	const int64_t mantissa = bits & 0x000f'ffff'ffff'ffff;
+	// The mantissa of sqrt(2)
+	const bool isLarge = mantissa > 0x6'a09e'667f'3bcd;
+	const double m = std::bit_cast<double>(mantissa
+		| (isLarge ? 0x3fe0'0000'0000'0000 : 0x3ff0'0000'0000'0000));
+	const int64_t exponent = (bits >> 52) - 1023 + (isLarge ? 1 : 0);
+	const double e = std::bit_cast<double>(std::bit_cast<int64_t>(roundingShift) + exponent)
+		- roundingShift;
+
+	// Exact, by Sterbenz's lemma
+	const double f = m - 1.0;
+	const DoubleDouble fSquared = twoProduct(f, f);
+	const double halfSquaredHi = 0.5 * fSquared.hi;
+	const double halfSquaredLo = 0.5 * fSquared.lo;
+	const double s = f / (2.0 + f);
+	const double z = s * s;
+	const double polynomial = z * (6.666666666666735130e-01 + z * (3.999999999940941908e-01
+		+ z * (2.857142874366239149e-01 + z * (2.222219843214978396e-01
+		+ z * (1.818357216161805012e-01 + z * (1.531383769920937332e-01
+		+ z * 1.479819860511658591e-01))))));
+	const double tail = s * (halfSquaredHi + polynomial);
+
+	// log(x) = e * ln(2) + f - f^2 / 2 + tail
+	const DoubleDouble first = twoSum(e * ln2Hi, f);
+	const DoubleDouble second = twoSum(first.hi, -halfSquaredHi);
+	return fastTwoSum(second.hi,
+		first.lo + second.lo - halfSquaredLo + tail + e * ln2Lo);
+}
+
+/// @brief `pow(x, y)` as `exp(y * log(x))`, with the product in double-double, so that its
+/// rounding is not multiplied by the size of the exponent
+inline double powLane(double x, double y) {
+	const DoubleDouble logX = logLane(select(isLogCovered(x), x, 1.0));
+	const double coveredY = select(isInRange(y, 0.0, 0.0) | isInRange(y, 1e-200, 1e200), y, 1.0);
+	const DoubleDouble product = twoProduct(coveredY, logX.hi);
+	const DoubleDouble exponent = fastTwoSum(product.hi, product.lo + coveredY * logX.lo);
+	// Past 709 the result is out of the range of `isPowCovered()` and its exponent overflows
+	return expLane(select(isInRange(exponent.hi, 0.0, 709.0), exponent.hi,
+		std::copysign(709.0, exponent.hi)), exponent.lo);
+}
+
+/// @brief Set every value to `lane(value)`, or to `fallback(value)` if not `isCovered(value)`
+template<typename Lane, typename IsCovered, typename Fallback>
+VECTOR_MATH_INLINE void applyUnary(double* values, size_t count, Lane lane, IsCovered isCovered,
+	Fallback fallback)
+{
+	double inputs[chunkSize];
+	double results[chunkSize];
+	for (size_t begin = 0; begin < count; begin += chunkSize) {
+		const size_t size = std::min(chunkSize, count - begin);
+		std::copy_n(values + begin, size, inputs);
+		std::fill(inputs + size, inputs + chunkSize, 1.0);
+		for (size_t i = 0; i < chunkSize; ++i) {
+			results[i] = lane(inputs[i]);
+		}
+		for (size_t i = 0; i < size; ++i) {
+			values[begin + i] = isCovered(inputs[i]) ? results[i] : fallback(inputs[i]);
+		}
+	}
+}
+
+} // namespace
+
+VECTOR_MATH_CLONES void vectorSin(double* values, size_t count) {
+	applyUnary(values, count, sinCosLane<false>, isSinCosCovered,
+		[](double x) { return std::sin(x); });
+}
+
+VECTOR_MATH_CLONES void vectorCos(double* values, size_t count) {
+	applyUnary(values, count, sinCosLane<true>, isSinCosCovered,
+		[](double x) { return std::cos(x); });
+}
+
+VECTOR_MATH_CLONES void vectorExp(double* values, size_t count) {
+	applyUnary(values, count,
+		[](double x) { return expLane(select(isExpCovered(x), x, 1.0), 0.0); }, isExpCovered,
+		[](double x) { return std::exp(x); });
+}
+
+VECTOR_MATH_CLONES void vectorLog(double* values, size_t count) {
+	applyUnary(values, count,
+		[](double x) { return logLane(select(isLogCovered(x), x, 1.0)).hi; }, isLogCovered,
+		[](double x) { return std::log(x); });
+}
+
+VECTOR_MATH_CLONES void vectorSqrt(double* values, size_t count) {
+	applyUnary(values, count,
+		[](double x) { return std::sqrt(select(isSqrtCovered(x), x, 1.0)); }, isSqrtCovered,
+		[](double x) { return std::sqrt(x); });
+}
+
+VECTOR_MATH_CLONES void vectorPow(double* values, const double* exponents, size_t count) {
+	double bases[chunkSize];
+	double powers[chunkSize];
+	double results[chunkSize];
+	for (size_t begin = 0; begin < count; begin += chunkSize) {
+		const size_t size = std::min(chunkSize, count - begin);
+		std::copy_n(values + begin, size, bases);
+		std::copy_n(exponents + begin, size, powers);
+		std::fill(bases + size, bases + chunkSize, 1.0);
+		std::fill(powers + size, powers + chunkSize, 1.0);
+		for (size_t i = 0; i < chunkSize; ++i) {
+			results[i] = powLane(bases[i], powers[i]);
+		}
+		for (size_t i = 0; i < size; ++i) {
+			values[begin + i] = isPowCovered(bases[i], powers[i], results[i]) ? results[i]
+				: std::pow(bases[i], powers[i]);
+		}
+	}
+}
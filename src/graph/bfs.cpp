@@ -0,0 +1,201 @@
+#include "graph/bfs.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <memory>
+
+#include "parallel/parallel.hpp"
+
+namespace {
+
+/// @brief A bitmap that can be updated from several threads at once
+class AtomicBitmap {
+public:
+	explicit AtomicBitmap(size_t bitCount):
+		m_wordCount((bitCount + 63) / 64),
+		m_words(new std::atomic<uint64_t>[m_wordCount])
+	{
+		for (size_t i = 0; i < m_wordCount; ++i) {
+			m_words[i].store(0, std::memory_order_relaxed);
+		}
+	}
+
+	bool get(size_t pos) const {
+		return (m_words[pos / 64].load(std::memory_order_relaxed) >> (pos % 64)) & 1;
+	}
+
+	/// @brief Set the bit and return its old value. Exactly one of the threads racing to set
+	/// the same bit gets `false`
+	bool testAndSet(size_t pos) {
+		const uint64_t mask = uint64_t{1} << (pos % 64);
+		return m_words[pos / 64].fetch_or(mask, std::memory_order_relaxed) & mask;
+	}
+
+	BitSet toBitSet() const {
+		std::vector<uint8_t> bytes(m_wordCount * 8);
+		for (size_t i = 0; i < bytes.size(); ++i) {
+			const uint64_t word = m_words[i / 8].load(std::memory_order_relaxed);
+			bytes[i] = static_cast<uint8_t>(word >> (8 * (i % 8)));
+		}
+		return BitSet::fromBytes({bytes.begin(), bytes.end()});
+	}
+
+private:
+	size_t m_wordCount;
+	std::unique_ptr<std::atomic<uint64_t>[]> m_words;
+};
+
+/// @brief The state shared by the levels of the search
+struct BfsState {
+	const CsrGraph& graph;
+	unsigned threadCount;
+	std::vector<uint32_t>& parents;
+	AtomicBitmap visited;
+
+	/// @brief The frontier as a queue of nodes for the top-down steps
+	std::vector<uint32_t> queue{};
+	/// @brief The frontier as a bitset for the bottom-up steps
+	BitSet frontier{};
+	BitSet nextFrontier{};
+
+	/// @brief Number of nodes and the sum of their degrees for the frontier produced by
+	/// the last step
+	size_t frontierSize = 0;
+	size_t frontierEdges = 0;
+};
+
+void topDownStep(BfsState& state) {
+	const unsigned threads = resolveThreadCount(state.threadCount, state.queue.size() / 64);
+	std::vector<std::vector<uint32_t>> localQueues(threads);
+	std::vector<size_t> localEdges(threads, 0);
+
+	runOnThreads(threads, [&](unsigned threadIndex) {
+		const ThreadRange range(state.queue.size(), threadIndex, threads);
+		std::vector<uint32_t>& next = localQueues[threadIndex];
+		size_t edges = 0;
+		for (size_t i = range.begin; i < range.end; ++i) {
+			const uint32_t node = state.queue[i];
+			for (uint32_t neighbor : state.graph.neighbors(node)) {
+				// Check before the atomic RMW: most of the neighbors have been visited already
+				if (!state.visited.get(neighbor) && !state.visited.testAndSet(neighbor)) {
+					state.parents[neighbor] = node;
+					next.push_back(neighbor);
+					edges += state.graph.degree(neighbor);
+				}
+			}
+		}
+		localEdges[threadIndex] = edges;
+	});
+
+	state.queue.clear();
+	state.frontierEdges = 0;
+	for (unsigned i = 0; i < threads; ++i) {
+		state.queue.insert(state.queue.end(), localQueues[i].begin(), localQueues[i].end());
+		state.frontierEdges += localEdges[i];
+	}
+	state.frontierSize = state.queue.size();
+}
+
+void bottomUpStep(BfsState& state) {
+	const size_t nodeCount = state.graph.nodeCount();
+	const unsigned threads = resolveThreadCount(state.threadCount, nodeCount / 4096);
+	std::vector<size_t> localSizes(threads, 0);
+	std::vector<size_t> localEdges(threads, 0);
+
+	state.nextFrontier.clear();
+	runOnThreads(threads, [&](unsigned threadIndex) {
+		// Word-aligned ranges: no two threads ever write to the same word of `visited` or the
+		// same byte of `nextFrontier`
+		const ThreadRange range(nodeCount, threadIndex, threads, 64);
+		size_t size = 0;
+		size_t edges = 0;
+		for (size_t i = range.begin; i < range.end; ++i) {
+			const uint32_t node = static_cast<uint32_t>(i);
+			if (state.visited.get(node)) {
+				continue;
+			}
+			for (uint32_t neighbor : state.graph.neighbors(node)) {
+				if (state.frontier.get(neighbor)) {
+					state.parents[node] = neighbor;
+					state.visited.testAndSet(node);
+					state.nextFrontier.set(node);
+					++size;
+					edges += state.graph.degree(node);
+					break;
+				}
+			}
+		}
+		localSizes[threadIndex] = size;
+		localEdges[threadIndex] = edges;
+	});
+
+	swap(state.frontier, state.nextFrontier);
+	state.frontierSize = 0;
+	state.frontierEdges = 0;
+	for (unsigned i = 0; i < threads; ++i) {
+		state.frontierSize += localSizes[i];
+		state.frontierEdges += localEdges[i];
+	}
+}
+
+} // namespace
+
+BfsResult breadthFirstSearch(const CsrGraph& graph, uint32_t source, const BfsOptions& options) {
+	const size_t nodeCount = graph.nodeCount();
+
+	BfsResult result;
+	result.parents.assign(nodeCount, BfsResult::noParent);
+	result.parents[source] = source;
+
+	BfsState state{graph, options.threadCount, result.parents, AtomicBitmap(nodeCount)};
+	state.frontierSize = 1;
+	state.frontierEdges = graph.degree(source);
+	state.visited.testAndSet(source);
+	state.queue.push_back(source);
+	// Preallocate the frontier bitsets, so that the threads never make `BitSet::set()` reallocate
+	state.frontier.reserve(nodeCount);
+	state.nextFrontier.reserve(nodeCount);
+
+	bool isBottomUp = options.direction == BfsDirection::BottomUp;
+	if (isBottomUp) {
+		state.frontier.set(source);
+	}
+
+	size_t unexploredEdges = graph.edgeCount() - graph.degree(source);
+	while (state.frontierSize != 0) {
+		++result.levelCount;
+
+		if (options.direction == BfsDirection::Auto) {
+			const double frontierSize = static_cast<double>(state.frontierSize);
+			const double frontierEdges = static_cast<double>(state.frontierEdges);
+			const bool wantsBottomUp = isBottomUp ?
+				frontierSize >= static_cast<double>(nodeCount) / options.beta :
+				frontierEdges > static_cast<double>(unexploredEdges) / options.alpha;
+
+			// Convert the frontier to the representation of the new direction
+			if (wantsBottomUp && !isBottomUp) {
+				state.frontier.clear();
+				for (uint32_t node : state.queue) {
+					state.frontier.set(node);
+				}
+			}
+			else if (!wantsBottomUp && isBottomUp) {
+				state.frontier.toIndices(state.queue);
+			}
+			isBottomUp = wantsBottomUp;
+		}
+
+		if (isBottomUp) {
+			bottomUpStep(state);
+			++result.bottomUpLevelCount;
+		}
+		else {
+			topDownStep(state);
+			++result.topDownLevelCount;
+		}
+		unexploredEdges -= std::min(unexploredEdges, state.frontierEdges);
+	}
+
+	result.visited = state.visited.toBitSet();
+	return result;
+}
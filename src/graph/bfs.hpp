@@ -0,0 +1,56 @@
+#ifndef BFS_HPP_INCLUDED
+#define BFS_HPP_INCLUDED
+
+#include <cstddef>
+#include <cstdint>
+
+#include <vector>
+
+#include "bitset/bitset.hpp"
+#include "graph/csr_graph.hpp"
+
+/// @brief How `breadthFirstSearch` expands the frontier
+enum class BfsDirection {
+	/// Every frontier node checks its neighbors. Cheap while the frontier is small
+	TopDown,
+	/// Every unvisited node looks for a parent in the frontier and stops at the first one found.
+	/// Cheap when the frontier is a large part of the graph
+	BottomUp,
+	/// Pick one of the above at every level (Beamer et al., "Direction-Optimizing Breadth-First
+	/// Search", 2012)
+	Auto,
+};
+
+struct BfsOptions {
+	BfsDirection direction = BfsDirection::Auto;
+	/// @brief The number of threads to use. 0 means `hardware_concurrency()`
+	unsigned threadCount = 0;
+	/// @brief Switch to bottom-up once the frontier has more than `1 / alpha` of the unexplored
+	/// edges
+	double alpha = 14;
+	/// @brief Switch back to top-down once the frontier has less than `1 / beta` of the nodes
+	double beta = 24;
+};
+
+struct BfsResult {
+	static constexpr uint32_t noParent = UINT32_MAX;
+
+	/// @brief The parent of every node in the BFS tree, `noParent` for unreachable nodes.
+	/// The source is its own parent
+	std::vector<uint32_t> parents;
+	/// @brief The set of reachable nodes
+	BitSet visited;
+	/// @brief Number of levels of the BFS tree (the eccentricity of the source plus one)
+	size_t levelCount = 0;
+	size_t topDownLevelCount = 0;
+	size_t bottomUpLevelCount = 0;
+};
+
+/// @brief Parallel breadth-first search from the node `source`
+///
+/// The top-down steps keep the frontier as a queue of node indices, the bottom-up steps keep it
+/// as a `BitSet`. Threads claim the nodes in the visited bitmap with atomic operations.
+/// @pre `graph` is symmetric, since the bottom-up steps look for parents among the neighbors
+BfsResult breadthFirstSearch(const CsrGraph& graph, uint32_t source, const BfsOptions& options = {});
+
+#endif
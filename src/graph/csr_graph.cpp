@@ -0,0 +1,50 @@
+#include "graph/csr_graph.hpp"
+
+#include <cassert>
+
+#include <algorithm>
+
+CsrGraph CsrGraph::fromEdges(size_t nodeCount, ArrayView<const Edge> edges, bool isSymmetric) {
+	CsrGraph graph;
+
+	// Counting sort by the source node: count the degrees, turn them into offsets with a prefix
+	// sum, then scatter the targets
+	std::vector<uint64_t> offsets(nodeCount + 1, 0);
+	for (const Edge& edge : edges) {
+		assert(edge.first < nodeCount && edge.second < nodeCount);
+		if (edge.first != edge.second) {
+			++offsets[edge.first + 1];
+			if (isSymmetric) {
+				++offsets[edge.second + 1];
+			}
+		}
+	}
+	for (size_t i = 0; i < nodeCount; ++i) {
+		offsets[i + 1] += offsets[i];
+	}
+
+	std::vector<uint32_t> neighbors(offsets.back());
+	std::vector<uint64_t> position(offsets.begin(), offsets.end() - 1);
+	for (const Edge& edge : edges) {
+		if (edge.first != edge.second) {
+			neighbors[position[edge.first]++] = edge.second;
+			if (isSymmetric) {
+				neighbors[position[edge.second]++] = edge.first;
+			}
+		}
+	}
+
+	// Sort the neighbor lists and squeeze out the duplicates
+	graph.m_offsets.assign(nodeCount + 1, 0);
+	graph.m_neighbors.reserve(neighbors.size());
+	for (size_t node = 0; node < nodeCount; ++node) {
+		const auto begin = neighbors.begin() + static_cast<std::ptrdiff_t>(offsets[node]);
+		const auto end = neighbors.begin() + static_cast<std::ptrdiff_t>(offsets[node + 1]);
+		std::sort(begin, end);
+		const auto uniqueEnd = std::unique(begin, end);
+		graph.m_neighbors.insert(graph.m_neighbors.end(), begin, uniqueEnd);
+		graph.m_offsets[node + 1] = graph.m_neighbors.size();
+	}
+
+	return graph;
+}
@@ -0,0 +1,52 @@
+#ifndef CSR_GRAPH_HPP_INCLUDED
+#define CSR_GRAPH_HPP_INCLUDED
+
+#include <cstddef>
+#include <cstdint>
+
+#include <utility>
+#include <vector>
+
+#include "array_view/array_view.hpp"
+
+using std::size_t;
+using std::uint32_t;
+using std::uint64_t;
+
+/// @brief A graph in the Compressed Sparse Row format: the neighbors of all the nodes are stored
+/// back to back in a single array, and `offsets[v]..offsets[v + 1]` is the range of the node `v`
+class CsrGraph {
+public:
+	using Edge = std::pair<uint32_t, uint32_t>;
+
+	CsrGraph() = default;
+
+	/// @brief Build a graph from a list of edges. Self-loops and duplicate edges are removed
+	/// @param isSymmetric Add the reverse of every edge, i.e. build an undirected graph
+	/// @pre Every node index is less than `nodeCount`
+	static CsrGraph fromEdges(size_t nodeCount, ArrayView<const Edge> edges, bool isSymmetric);
+
+	size_t nodeCount() const {
+		return m_offsets.empty() ? 0 : m_offsets.size() - 1;
+	}
+
+	/// @brief Number of stored (directed) edges. Every undirected edge is counted twice
+	size_t edgeCount() const {
+		return m_neighbors.size();
+	}
+
+	size_t degree(uint32_t node) const {
+		return static_cast<size_t>(m_offsets[node + 1] - m_offsets[node]);
+	}
+
+	/// @brief The neighbors of `node` sorted in ascending order
+	ArrayView<const uint32_t> neighbors(uint32_t node) const {
+		return {m_neighbors.data() + m_offsets[node], degree(node)};
+	}
+
+private:
+	std::vector<uint64_t> m_offsets;
+	std::vector<uint32_t> m_neighbors;
+};
+
+#endif
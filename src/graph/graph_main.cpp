@@ -0,0 +1,158 @@
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include "graph/bfs.hpp"
+#include "graph/csr_graph.hpp"
+
+/// @brief Generate the edges of an R-MAT graph (Chakrabarti et al., "R-MAT: A Recursive Model for
+/// Graph Mining", 2004) with the Graph500 parameters. Every edge is placed by descending
+/// `scale` times into one of the quadrants of the adjacency matrix, which gives a skewed,
+/// power-law-like degree distribution
+static std::vector<CsrGraph::Edge> generateRmatEdges(unsigned scale, size_t edgeFactor,
+	unsigned seed
+) {
+	constexpr double a = 0.57;
+	constexpr double b = 0.19;
+	constexpr double c = 0.19;
+
+	std::mt19937_64 random(seed);
+	std::uniform_real_distribution<double> uniform(0.0, 1.0);
+
+	const size_t edgeCount = (size_t{1} << scale) * edgeFactor;
+	std::vector<CsrGraph::Edge> edges(edgeCount);
+	for (CsrGraph::Edge& edge : edges) {
+		uint32_t row = 0;
+		uint32_t column = 0;
+		for (unsigned level = 0; level < scale; ++level) {
+			const double r = uniform(random);
+			const uint32_t bit = uint32_t{1} << level;
+			if (r < a) {
+				// top left quadrant
+			}
+			else if (r < a + b) {
+				column |= bit;
+			}
+			else if (r < a + b + c) {
+				row |= bit;
+			}
+			else {
+				row |= bit;
+				column |= bit;
+			}
+		}
+		edge = {row, column};
+	}
+
+	// Shuffle the node labels so that the high-degree nodes are not clustered at low indices
+	std::vector<uint32_t> labels(size_t{1} << scale);
+	for (size_t i = 0; i < labels.size(); ++i) {
+		labels[i] = static_cast<uint32_t>(i);
+	}
+	std::shuffle(labels.begin(), labels.end(), random);
+	for (CsrGraph::Edge& edge : edges) {
+		edge = {labels[edge.first], labels[edge.second]};
+	}
+	return edges;
+}
+
+/// @brief Check that every parent is a neighbor one level closer to the source, using the depths
+/// computed by a simple sequential BFS
+static bool isValidBfsTree(const CsrGraph& graph, uint32_t source, const BfsResult& result) {
+	std::vector<size_t> depth(graph.nodeCount(), SIZE_MAX);
+	std::vector<uint32_t> queue{source};
+	depth[source] = 0;
+	for (size_t i = 0; i < queue.size(); ++i) {
+		for (uint32_t neighbor : graph.neighbors(queue[i])) {
+			if (depth[neighbor] == SIZE_MAX) {
+				depth[neighbor] = depth[queue[i]] + 1;
+				queue.push_back(neighbor);
+			}
+		}
+	}
+
+	for (uint32_t node = 0; node < graph.nodeCount(); ++node) {
+		const uint32_t parent = result.parents[node];
+		if ((depth[node] == SIZE_MAX) != (parent == BfsResult::noParent)
+			|| (depth[node] != SIZE_MAX) != result.visited.get(node)
+		) {
+			return false;
+		}
+		if (parent == BfsResult::noParent || node == source) {
+			continue;
+		}
+		const ArrayView<const uint32_t> neighbors = graph.neighbors(node);
+		if (depth[parent] + 1 != depth[node]
+			|| !std::binary_search(neighbors.begin(), neighbors.end(), parent)
+		) {
+			return false;
+		}
+	}
+	return true;
+}
+
+int main() {
+	constexpr unsigned scale = 18;
+	constexpr size_t edgeFactor = 16;
+
+	std::cout << "Generating an R-MAT graph with 2^" << scale << " nodes and edge factor "
+		<< edgeFactor << "...\n";
+	const std::vector<CsrGraph::Edge> edges = generateRmatEdges(scale, edgeFactor, 1);
+	const CsrGraph graph = CsrGraph::fromEdges(size_t{1} << scale, {edges.begin(), edges.end()},
+		true);
+	std::cout << graph.nodeCount() << " nodes, " << graph.edgeCount() << " directed edges\n";
+
+	// Take sources with at least one edge, as Graph500 does
+	std::mt19937 random(2);
+	std::uniform_int_distribution<uint32_t> node(0, static_cast<uint32_t>(graph.nodeCount() - 1));
+	std::vector<uint32_t> sources;
+	while (sources.size() < 8) {
+		const uint32_t source = node(random);
+		if (graph.degree(source) != 0) {
+			sources.push_back(source);
+		}
+	}
+
+	struct Strategy { const char* name; BfsDirection direction; };
+	const Strategy strategies[] = {
+		{"top-down", BfsDirection::TopDown},
+		{"bottom-up", BfsDirection::BottomUp},
+		{"direction-optimizing", BfsDirection::Auto},
+	};
+
+	using Seconds = std::chrono::duration<double>;
+	for (const Strategy& strategy : strategies) {
+		BfsOptions options;
+		options.direction = strategy.direction;
+
+		double totalSeconds = 0;
+		double traversedEdges = 0;
+		bool isValid = true;
+		size_t topDownLevels = 0;
+		size_t bottomUpLevels = 0;
+		for (uint32_t source : sources) {
+			const auto start = std::chrono::steady_clock::now();
+			const BfsResult result = breadthFirstSearch(graph, source, options);
+			totalSeconds += Seconds(std::chrono::steady_clock::now() - start).count();
+
+			isValid = isValid && isValidBfsTree(graph, source, result);
+			topDownLevels += result.topDownLevelCount;
+			bottomUpLevels += result.bottomUpLevelCount;
+			// Graph500 counts the undirected edges within the connected component of the source
+			for (uint32_t i = 0; i < graph.nodeCount(); ++i) {
+				if (result.visited.get(i)) {
+					traversedEdges += static_cast<double>(graph.degree(i)) / 2;
+				}
+			}
+		}
+
+		std::cout << '\n' << strategy.name << ":\n";
+		std::cout << "  Valid BFS trees: " << (isValid ? "yes" : "NO") << '\n';
+		std::cout << "  Levels: " << topDownLevels << " top-down, " << bottomUpLevels
+			<< " bottom-up\n";
+		std::cout << "  Mean time: " << totalSeconds / static_cast<double>(sources.size()) * 1000
+			<< " ms, " << traversedEdges / totalSeconds / 1e6 << " MTEPS\n";
+	}
+}
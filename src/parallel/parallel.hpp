@@ -0,0 +1,59 @@
+#ifndef PARALLEL_HPP_INCLUDED
+#define PARALLEL_HPP_INCLUDED
+
+#include <cstddef>
+
+#include <algorithm>
+#include <thread>
+#include <vector>
+
+/// @brief Resolve the "0 means all cores" convention and never start more threads than there
+/// are units of work
+inline unsigned resolveThreadCount(unsigned requested, std::size_t workCount) {
+	unsigned count = requested != 0 ? requested : std::thread::hardware_concurrency();
+	count = std::max(count, 1u);
+	return static_cast<unsigned>(std::min<std::size_t>(count, std::max<std::size_t>(workCount, 1)));
+}
+
+/// @brief Run `worker(threadIndex)` on `threadCount` threads, one of them being the calling thread
+template<typename Worker>
+void runOnThreads(unsigned threadCount, const Worker& worker) {
+	std::vector<std::thread> threads;
+	threads.reserve(threadCount - 1);
+	for (unsigned i = 1; i < threadCount; ++i) {
+		threads.emplace_back(worker, i);
+	}
+	worker(0u);
+	for (std::thread& thread : threads) {
+		thread.join();
+	}
+}
+
+/// @brief Get the `[begin, end)` range of `count` items that belongs to the thread `threadIndex`
+/// out of `threadCount` when the items are split as evenly as possible. Both ends are rounded
+/// down to a multiple of `granularity` (except for the very end), e.g. to keep the threads from
+/// writing to the same byte or cache line
+struct ThreadRange {
+	std::size_t begin;
+	std::size_t end;
+
+	ThreadRange(std::size_t count, unsigned threadIndex, unsigned threadCount,
+		std::size_t granularity = 1
+	):
+		begin(split(count, threadIndex, threadCount, granularity)),
+		end(split(count, threadIndex + 1, threadCount, granularity))
+	{ }
+
+private:
+	static std::size_t split(std::size_t count, unsigned index, unsigned threadCount,
+		std::size_t granularity
+	) {
+		if (index == threadCount) {
+			return count;
+		}
+		const std::size_t position = count * index / threadCount;
+		return position / granularity * granularity;
+	}
+};
+
+#endif
@@ -0,0 +1,214 @@
+#include "sieve/prime_sieve.hpp"
+
+#include <cstring>
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <vector>
+
+#include "parallel/parallel.hpp"
+
+namespace {
+
+/// @brief Size of a segment in bytes. Leaves some of a typical 48 KiB L1 data cache for
+/// the primes and their offsets
+constexpr size_t segmentBytes = 32 * 1024;
+/// @brief Number of odd numbers in a segment
+constexpr uint64_t segmentOdds = segmentBytes * 8;
+
+/// @brief The primes that are crossed out by copying the wheel pattern
+constexpr uint32_t wheelPrimes[] = {3, 5, 7, 11, 13};
+/// @brief The period of the pattern in bytes: 3 * 5 * 7 * 11 * 13 odd numbers repeat with this
+/// period, and so do 8 times as many, which is a whole number of bytes
+constexpr size_t wheelPeriodBytes = 3 * 5 * 7 * 11 * 13;
+
+/// @brief The odd number `2 * index + 1` is stored in the bit `index`
+constexpr uint64_t oddIndex(uint64_t number) {
+	return number / 2;
+}
+
+/// @brief A byte of the odd-only representation covers 16 consecutive numbers, i.e. 2 bytes of
+/// the `BitSet`. This table places the bit `i` at the position `2 * i + 1` of a 16-bit value
+constexpr std::array<uint16_t, 256> makeSpreadTable() {
+	std::array<uint16_t, 256> table{};
+	for (unsigned byte = 0; byte < 256; ++byte) {
+		for (unsigned bit = 0; bit < 8; ++bit) {
+			if (byte & (1u << bit)) {
+				table[byte] = static_cast<uint16_t>(table[byte] | (1u << (2 * bit + 1)));
+			}
+		}
+	}
+	return table;
+}
+
+constexpr std::array<uint16_t, 256> spreadTable = makeSpreadTable();
+
+/// @brief The odd primes that are not in the wheel, up to and including `sqrt(limit)`
+std::vector<uint32_t> sievingPrimes(uint64_t limit) {
+	uint64_t root = 0;
+	while ((root + 1) * (root + 1) < limit) {
+		++root;
+	}
+
+	// A plain sieve is fast enough for the small range
+	std::vector<bool> isComposite(static_cast<size_t>(root + 1));
+	std::vector<uint32_t> primes;
+	for (uint64_t i = 3; i <= root; i += 2) {
+		if (isComposite[i]) {
+			continue;
+		}
+		if (i > wheelPrimes[std::size(wheelPrimes) - 1]) {
+			primes.push_back(static_cast<uint32_t>(i));
+		}
+		for (uint64_t j = i * i; j <= root; j += 2 * i) {
+			isComposite[j] = true;
+		}
+	}
+	return primes;
+}
+
+/// @brief The wheel pattern for the odd numbers, long enough to fill a whole segment starting
+/// from any offset within the period
+std::vector<uint8_t> makeWheelPattern() {
+	std::vector<uint8_t> pattern(wheelPeriodBytes + segmentBytes, 0xff);
+	for (uint32_t prime : wheelPrimes) {
+		for (uint64_t index = oddIndex(prime); index < pattern.size() * 8; index += prime) {
+			pattern[index / 8] &= static_cast<uint8_t>(~(1u << (index % 8)));
+		}
+	}
+	return pattern;
+}
+
+/// @brief Sieve the odd numbers below `limit` segment by segment. For every segment call
+/// `sink(threadIndex, firstOddIndex, bits)`, where `bits` has a bit per odd number and the bits
+/// past the limit are cleared
+template<typename Sink>
+void sieveSegments(uint64_t limit, unsigned threadCount, Sink sink) {
+	const uint64_t oddCount = limit / 2;
+	const uint64_t segmentCount = (oddCount + segmentOdds - 1) / segmentOdds;
+	const std::vector<uint32_t> primes = sievingPrimes(limit);
+	const std::vector<uint8_t> wheel = makeWheelPattern();
+
+	const unsigned threads = resolveThreadCount(threadCount, static_cast<size_t>(segmentCount));
+	runOnThreads(threads, [&](unsigned threadIndex) {
+		const ThreadRange segments(static_cast<size_t>(segmentCount), threadIndex, threads);
+		if (segments.begin == segments.end) {
+			return;
+		}
+
+		// The odd index of the next multiple of every prime to cross out. Computed once per thread
+		// with a division, then just incremented
+		const uint64_t firstIndex = segments.begin * segmentOdds;
+		std::vector<uint64_t> nextMultiple(primes.size());
+		for (size_t i = 0; i < primes.size(); ++i) {
+			const uint64_t prime = primes[i];
+			const uint64_t firstNumber = 2 * firstIndex + 1;
+			uint64_t multiple = std::max(prime * prime, (firstNumber + prime - 1) / prime * prime);
+			if (multiple % 2 == 0) {
+				multiple += prime;
+			}
+			nextMultiple[i] = oddIndex(multiple);
+		}
+
+		std::vector<uint8_t> bits(segmentBytes);
+		for (size_t segment = segments.begin; segment < segments.end; ++segment) {
+			const uint64_t segmentBegin = segment * segmentOdds;
+			const uint64_t segmentEnd = std::min(segmentBegin + segmentOdds, oddCount);
+
+			std::memcpy(bits.data(), wheel.data() + (segmentBegin / 8) % wheelPeriodBytes,
+				segmentBytes);
+
+			for (size_t i = 0; i < primes.size(); ++i) {
+				const uint64_t prime = primes[i];
+				uint64_t index = nextMultiple[i];
+				for (; index < segmentEnd; index += prime) {
+					const uint64_t bit = index - segmentBegin;
+					bits[bit / 8] &= static_cast<uint8_t>(~(1u << (bit % 8)));
+				}
+				nextMultiple[i] = index;
+			}
+
+			if (segment == 0) {
+				// 1 is not a prime, and the wheel crossed out its own primes
+				bits[0] &= static_cast<uint8_t>(~1u);
+				for (uint32_t prime : wheelPrimes) {
+					const uint64_t index = oddIndex(prime);
+					if (index < oddCount) {
+						bits[index / 8] |= static_cast<uint8_t>(1u << (index % 8));
+					}
+				}
+			}
+
+			// Clear the bits past the limit in the last segment
+			const uint64_t validBits = segmentEnd - segmentBegin;
+			if (validBits < segmentOdds) {
+				const size_t fullBytes = static_cast<size_t>(validBits / 8);
+				if (validBits % 8 != 0) {
+					bits[fullBytes] &= static_cast<uint8_t>((1u << (validBits % 8)) - 1);
+				}
+				const size_t usedBytes = static_cast<size_t>((validBits + 7) / 8);
+				std::fill(bits.begin() + static_cast<std::ptrdiff_t>(usedBytes), bits.end(), 0);
+			}
+
+			sink(threadIndex, segmentBegin, ArrayView<const uint8_t>(bits.begin(), bits.end()));
+		}
+	});
+}
+
+} // namespace
+
+uint64_t countPrimes(uint64_t limit, unsigned threadCount) {
+	if (limit <= 2) {
+		return 0;
+	}
+
+	std::vector<uint64_t> counts(resolveThreadCount(threadCount, SIZE_MAX), 0);
+	sieveSegments(limit, threadCount,
+		[&counts](unsigned threadIndex, uint64_t, ArrayView<const uint8_t> bits) {
+			uint64_t count = 0;
+			for (size_t i = 0; i < bits.size(); i += 8) {
+				uint64_t word;
+				std::memcpy(&word, &bits[i], sizeof(word));
+				count += static_cast<uint64_t>(std::popcount(word));
+			}
+			counts[threadIndex] += count;
+		});
+
+	uint64_t total = 1; // 2 is the only even prime
+	for (uint64_t count : counts) {
+		total += count;
+	}
+	return total;
+}
+
+BitSet sievePrimes(uint64_t limit, unsigned threadCount) {
+	BitSet result;
+	if (limit <= 2) {
+		return result;
+	}
+
+	const size_t totalBytes = static_cast<size_t>((limit + 7) / 8);
+	result.reserve(static_cast<size_t>(limit));
+
+	const unsigned threads = resolveThreadCount(threadCount, SIZE_MAX);
+	std::vector<std::vector<uint8_t>> buffers(threads, std::vector<uint8_t>(2 * segmentBytes));
+	sieveSegments(limit, threadCount,
+		[&](unsigned threadIndex, uint64_t firstOddIndex, ArrayView<const uint8_t> bits) {
+			std::vector<uint8_t>& buffer = buffers[threadIndex];
+			for (size_t i = 0; i < bits.size(); ++i) {
+				const uint16_t spread = spreadTable[bits[i]];
+				buffer[2 * i] = static_cast<uint8_t>(spread);
+				buffer[2 * i + 1] = static_cast<uint8_t>(spread >> 8);
+			}
+
+			// Never write past the reserved storage, `writeBytes()` would reallocate it under
+			// the feet of the other threads
+			const size_t offset = static_cast<size_t>(firstOddIndex / 4);
+			const size_t count = std::min(buffer.size(), totalBytes - offset);
+			result.writeBytes(offset, {buffer.data(), count});
+		});
+
+	result.set(2);
+	return result;
+}
@@ -0,0 +1,25 @@
+#ifndef PRIME_SIEVE_HPP_INCLUDED
+#define PRIME_SIEVE_HPP_INCLUDED
+
+#include <cstdint>
+
+#include "bitset/bitset.hpp"
+
+/// Segmented Sieve of Eratosthenes.
+///
+/// Only the odd numbers are stored, one bit per number. The range is processed in segments that
+/// fit into the L1 cache. Every segment is initialized from a precomputed pattern that already
+/// has the multiples of 3, 5, 7, 11 and 13 crossed out (wheel pre-sieving), then the multiples
+/// of the larger primes up to `sqrt(limit)` are crossed out one by one. Threads work on
+/// contiguous runs of segments.
+
+/// @brief Count the prime numbers less than `limit`
+/// @param threadCount The number of threads to use. 0 means `hardware_concurrency()`
+std::uint64_t countPrimes(std::uint64_t limit, unsigned threadCount = 0);
+
+/// @brief Get the set of the prime numbers less than `limit`
+/// @param threadCount The number of threads to use. 0 means `hardware_concurrency()`
+/// @note Every thread writes its segments straight into the storage of the resulting `BitSet`
+BitSet sievePrimes(std::uint64_t limit, unsigned threadCount = 0);
+
+#endif
@@ -0,0 +1,59 @@
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+
+#include "sieve/prime_sieve.hpp"
+
+/// @brief pi(10^k), the number of primes below 10^k, for checking the results
+static constexpr std::uint64_t knownPrimeCounts[] = {
+	0, 4, 25, 168, 1229, 9592, 78498, 664579, 5761455, 50847534, 455052511,
+};
+
+int main(int argc, char* argv[]) {
+	// Usage: sieve [maxExponent [maxBitSetExponent]]
+	// The sieve runs up to 10^maxExponent. Counting needs a few hundred kilobytes of memory at
+	// most, building a BitSet needs limit / 8 bytes, so it stops earlier by default
+	const int maxExponent = argc > 1 ? std::atoi(argv[1]) : 10;
+	const int maxBitSetExponent = argc > 2 ? std::atoi(argv[2]) : 9;
+
+	using Seconds = std::chrono::duration<double>;
+	bool isCorrect = true;
+
+	std::cout << "Counting primes:\n";
+	std::uint64_t limit = 1;
+	for (int exponent = 1; exponent <= maxExponent && exponent <= 10; ++exponent) {
+		limit *= 10;
+
+		const auto start = std::chrono::steady_clock::now();
+		const std::uint64_t count = countPrimes(limit);
+		const double seconds = Seconds(std::chrono::steady_clock::now() - start).count();
+
+		const bool matches = count == knownPrimeCounts[exponent];
+		isCorrect = isCorrect && matches;
+		std::cout << "  below 10^" << exponent << ": " << count << (matches ? "" : " (WRONG)")
+			<< ", " << seconds * 1000 << " ms, " << static_cast<double>(count) / seconds / 1e6
+			<< " Mprimes/s\n";
+	}
+
+	std::cout << "\nBuilding BitSets of primes:\n";
+	limit = 1;
+	for (int exponent = 1; exponent <= maxBitSetExponent && exponent <= 10; ++exponent) {
+		limit *= 10;
+
+		const auto start = std::chrono::steady_clock::now();
+		const BitSet primes = sievePrimes(limit);
+		const double seconds = Seconds(std::chrono::steady_clock::now() - start).count();
+
+		const std::uint64_t count = primes.count();
+		const bool matches = count == knownPrimeCounts[exponent];
+		isCorrect = isCorrect && matches;
+		std::cout << "  below 10^" << exponent << ": " << count << (matches ? "" : " (WRONG)")
+			<< ", " << seconds * 1000 << " ms, "
+			<< static_cast<double>(primes.bytes().size()) / seconds / 1e9 << " GB/s written\n";
+		if (exponent == 2) {
+			std::cout << "    " << primes << '\n';
+		}
+	}
+
+	return isCorrect ? 0 : 1;
+}